@@ -23,10 +23,10 @@ CPU_CORES = os.cpu_count() or 4 # Usa 4 como padrão se a detecção falhar
 
 # Lista de executáveis a serem testados
 EXECUTABLES = [
-    {"name": "Sequencial", "source": "kmeans_sequencial.c", "output": "kmeans_sequencial", "type": "serial", "compile_cmd": "gcc -o kmeans_sequencial kmeans_sequencial.c -O3"},
-    {"name": "OpenMP", "source": "kmeans_openmp.c", "output": "kmeans_openmp", "type": "omp", "compile_cmd": "gcc -o kmeans_openmp kmeans_openmp.c -fopenmp -O3"},
-    {"name": "Pthreads", "source": "kmeans_pthreads.c", "output": "kmeans_pthreads", "type": "serial", "compile_cmd": "gcc -o kmeans_pthreads kmeans_pthreads.c -lpthread -O3"},
-    {"name": "MPI", "source": "kmeans_mpi.c", "output": "kmeans_mpi", "type": "mpi", "compile_cmd": "mpicc -o kmeans_mpi kmeans_mpi.c -O3"}
+    {"name": "Sequencial", "source": "kmeans_sequencial.c", "output": "kmeans_sequencial", "type": "serial", "compile_cmd": "gcc -o kmeans_sequencial kmeans_sequencial.c -O3 -lm -lpthread"},
+    {"name": "OpenMP", "source": "kmeans_openmp.c", "output": "kmeans_openmp", "type": "omp", "compile_cmd": "gcc -o kmeans_openmp kmeans_openmp.c -fopenmp -O3 -lm"},
+    {"name": "Pthreads", "source": "kmeans_pthreads.c", "output": "kmeans_pthreads", "type": "serial", "compile_cmd": "gcc -o kmeans_pthreads kmeans_pthreads.c -lpthread -O3 -lm"},
+    {"name": "MPI", "source": "kmeans_mpi.c", "output": "kmeans_mpi", "type": "mpi", "compile_cmd": "mpicc -o kmeans_mpi kmeans_mpi.c -O3 -lm"}
 ]
 
 # --- Cores para o Terminal ---
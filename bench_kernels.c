@@ -0,0 +1,243 @@
+#define _POSIX_C_SOURCE 199309L  // Necessário para CLOCK_MONOTONIC
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "kmeans_aleatorio.h"
+#include "kmeans_dataset.h"
+#include "kmeans_simd.h"
+
+// Microbenchmark dos kernels de kmeans_simd.h, fora dos programas completos.
+//
+// Gera M pontos aleatórios (semente fixa) e mede, para cada conjunto de instruções
+// suportado, as variantes da fase de atribuição (pontos int32 em linhas, int16
+// compactos, colunas e blocada) e da acumulação da fase de atualização, além da
+// banda de memória de leitura e de cópia da máquina. Cada medida é a melhor de
+// 'repeticoes' execuções. A atribuição de cada variante é comparada com a do kernel
+// escalar em linhas; a última coluna indica se os rótulos são idênticos.
+//
+// A saída é uma tabela com uma linha por medida, separada por espaços, lida por
+// benchmark.py: kernel, nivel, tempo_ms, mpontos_s, gb_s, ns_par, corretude
+// (ns_par = nanossegundos por par ponto-centroide; '-' quando não se aplica).
+
+#define BENCH_BLOCO 1024  // Pontos por chamada dos kernels de colunas e blocado
+
+typedef struct {
+  int num_pontos;
+  int num_dimensoes;
+  int num_clusters;
+  int repeticoes;
+  int min_val, max_val;
+  ConjuntoPontos pontos;
+  PontosCompactos compacto;
+  int* centroides;
+  int32_t* referencia;  // Rótulos do kernel escalar em linhas
+} Bancada;
+
+static double agora(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+static void imprimir_linha(const char* kernel, const char* nivel, double segundos, long long pontos, double bytes,
+                           double pares, const char* corretude) {
+  char mpontos[32] = "-", gb[32] = "-", ns[32] = "-";
+  if (pontos > 0) snprintf(mpontos, sizeof(mpontos), "%.2f", pontos / segundos / 1e6);
+  if (bytes > 0) snprintf(gb, sizeof(gb), "%.2f", bytes / segundos / 1e9);
+  if (pares > 0) snprintf(ns, sizeof(ns), "%.4f", segundos * 1e9 / pares);
+  printf("%-16s %-8s %10.3f %10s %8s %8s %s\n", kernel, nivel, segundos * 1e3, mpontos, gb, ns, corretude);
+  fflush(stdout);
+}
+
+/**
+ * @brief Executa uma variante de atribuição 'repeticoes' vezes, imprime a melhor e
+ * compara os rótulos com a referência (ou os grava nela, se 'gravar_referencia').
+ */
+static void medir_atribuicao(const Bancada* b, const KernelAtribuicao* k, const char* nome, double bytes_ponto,
+                             int gravar_referencia) {
+  const int M = b->num_pontos;
+  int32_t* rotulos = (int32_t*)pontos_alocar((size_t)M * sizeof(int32_t));
+  double melhor = 1e30;
+  for (int r = 0; r < b->repeticoes; r++) {
+    for (int i = 0; i < M; i++) {
+      rotulos[i] = -1;
+    }
+    double inicio = agora();
+    if (strcmp(nome, "atrib_colunas") == 0) {
+      for (int ini = 0; ini < M; ini += BENCH_BLOCO) {
+        int fim = ini + BENCH_BLOCO < M ? ini + BENCH_BLOCO : M;
+        kernel_atribuir_colunas(k, b->pontos.colunas, M, ini, fim, rotulos);
+      }
+    } else if (strcmp(nome, "atrib_blocada") == 0) {
+      for (int ini = 0; ini < M; ini += BENCH_BLOCO) {
+        int fim = ini + BENCH_BLOCO < M ? ini + BENCH_BLOCO : M;
+        kernel_atribuir_blocado(k, b->compacto.coords, ini, fim, rotulos);
+      }
+    } else if (strcmp(nome, "atrib_int16") == 0) {
+      for (int i = 0; i < M; i++) {
+        rotulos[i] = kernel_mais_proximo_compacto(k, &b->compacto.coords[(size_t)i * b->compacto.largura]);
+      }
+    } else {
+      for (int i = 0; i < M; i++) {
+        rotulos[i] = kernel_mais_proximo(k, pontos_ponto(&b->pontos, i));
+      }
+    }
+    double t = agora() - inicio;
+    if (t < melhor) melhor = t;
+  }
+  if (gravar_referencia) memcpy(b->referencia, rotulos, (size_t)M * sizeof(int32_t));
+  const int igual = memcmp(rotulos, b->referencia, (size_t)M * sizeof(int32_t)) == 0;
+  imprimir_linha(nome, simd_nome(k->nivel), melhor, M, bytes_ponto * M, (double)M * b->num_clusters,
+                 igual ? "OK" : "DIVERGE");
+  free(rotulos);
+}
+
+/**
+ * @brief Mede a acumulação da fase de atualização (somas por cluster dos rótulos de
+ * referência), com pontos int32 ou compactos.
+ */
+static void medir_acumulacao(const Bancada* b, int compacto) {
+  const int M = b->num_pontos, D = b->num_dimensoes;
+  long long* somas = (long long*)pontos_alocar((size_t)b->num_clusters * D * sizeof(long long));
+  double melhor = 1e30;
+  long long total = 0;
+  for (int r = 0; r < b->repeticoes; r++) {
+    memset(somas, 0, (size_t)b->num_clusters * D * sizeof(long long));
+    double inicio = agora();
+    for (int i = 0; i < M; i++) {
+      long long* soma = &somas[(size_t)b->referencia[i] * D];
+      if (compacto) {
+        kernel_somar_compacto(soma, &b->compacto.coords[(size_t)i * b->compacto.largura], D);
+      } else {
+        kernel_somar(soma, pontos_ponto(&b->pontos, i), D);
+      }
+    }
+    double t = agora() - inicio;
+    if (t < melhor) melhor = t;
+  }
+  for (size_t j = 0; j < (size_t)b->num_clusters * D; j++) {
+    total += somas[j];
+  }
+  long long esperado = 0;
+  for (size_t j = 0; j < (size_t)M * D; j++) {
+    esperado += b->pontos.coords[j];
+  }
+  double bytes_ponto = compacto ? (double)b->compacto.largura * sizeof(int16_t) : (double)D * sizeof(int);
+  imprimir_linha(compacto ? "acum_int16" : "acum_int32", "-", melhor, M, bytes_ponto * M + (double)M * sizeof(int32_t),
+                 0, total == esperado ? "OK" : "DIVERGE");
+  free(somas);
+}
+
+/**
+ * @brief Banda de memória: leitura (soma de um vetor) e cópia (memcpy) de 'bytes'
+ * bytes, grandes o bastante para não caber na cache.
+ */
+static void medir_banda(size_t bytes, int repeticoes) {
+  const size_t n = bytes / sizeof(long long);
+  long long* a = (long long*)pontos_alocar(n * sizeof(long long));
+  long long* c = (long long*)pontos_alocar(n * sizeof(long long));
+  for (size_t i = 0; i < n; i++) {
+    a[i] = (long long)i;
+    c[i] = 0;
+  }
+  double melhor_leitura = 1e30, melhor_copia = 1e30;
+  volatile long long sorvedouro = 0;
+  for (int r = 0; r < repeticoes; r++) {
+    double inicio = agora();
+    long long soma = 0;
+    for (size_t i = 0; i < n; i++) {
+      soma += a[i];
+    }
+    sorvedouro += soma;
+    double t = agora() - inicio;
+    if (t < melhor_leitura) melhor_leitura = t;
+
+    inicio = agora();
+    memcpy(c, a, n * sizeof(long long));
+    t = agora() - inicio;
+    if (t < melhor_copia) melhor_copia = t;
+  }
+  (void)sorvedouro;
+  imprimir_linha("banda_leitura", "-", melhor_leitura, 0, (double)n * sizeof(long long), 0, "-");
+  // A cópia lê e escreve cada byte
+  imprimir_linha("banda_copia", "-", melhor_copia, 0, 2.0 * n * sizeof(long long), 0, "-");
+  free(a);
+  free(c);
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 4 || argc > 6) {
+    fprintf(stderr, "Uso: %s <num_pontos> <num_dimensoes> <num_clusters> [repeticoes] [max_val]\n", argv[0]);
+    fprintf(stderr, "Exemplo: %s 1000000 10 100 5 10000\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  Bancada b;
+  b.num_pontos = atoi(argv[1]);
+  b.num_dimensoes = atoi(argv[2]);
+  b.num_clusters = atoi(argv[3]);
+  b.repeticoes = argc > 4 ? atoi(argv[4]) : 5;
+  b.max_val = argc > 5 ? atoi(argv[5]) : 10000;
+  if (b.num_pontos <= 0 || b.num_dimensoes <= 0 || b.num_clusters <= 0 || b.num_clusters > b.num_pontos ||
+      b.repeticoes <= 0 || b.max_val <= 0) {
+    fprintf(stderr, "Erro: todos os parâmetros devem ser positivos, com num_clusters <= num_pontos.\n");
+    return EXIT_FAILURE;
+  }
+  const int M = b.num_pontos, D = b.num_dimensoes, K = b.num_clusters;
+
+  // Pontos uniformes em [0, max_val] e centroides iniciais nos K primeiros pontos
+  pontos_iniciar(&b.pontos, M, D, NULL);
+  // O j-ésimo valor é o j-ésimo sorteio do splitmix64 com semente 42
+  for (size_t j = 0; j < (size_t)M * D; j++) {
+    b.pontos.coords[j] = (int)(aleatorio_hash(42 + j * 0x9E3779B97F4A7C15ULL) % ((uint64_t)b.max_val + 1));
+  }
+  simd_faixa(b.pontos.coords, (size_t)M * D, &b.min_val, &b.max_val);
+  pontos_gerar_colunas(&b.pontos);
+  b.compacto.coords = NULL;
+  if (simd_compacto_seguro(b.min_val, b.max_val, D)) {
+    simd_compactar(b.pontos.coords, M, D, b.min_val, b.max_val, &b.compacto);
+  }
+  b.centroides = (int*)malloc((size_t)K * D * sizeof(int));
+  memcpy(b.centroides, b.pontos.coords, (size_t)K * D * sizeof(int));
+  b.referencia = (int32_t*)pontos_alocar((size_t)M * sizeof(int32_t));
+
+  printf("# M=%d D=%d K=%d repeticoes=%d faixa=[%d, %d]\n", M, D, K, b.repeticoes, b.min_val, b.max_val);
+  printf("# %-14s %-8s %10s %10s %8s %8s %s\n", "kernel", "nivel", "tempo_ms", "mpontos_s", "gb_s", "ns_par",
+         "corretude");
+
+  const NivelSimd suportado = simd_faixa_segura(b.min_val, b.max_val) ? simd_detectar() : SIMD_ESCALAR;
+  for (NivelSimd nivel = SIMD_ESCALAR; nivel <= suportado; nivel++) {
+    KernelAtribuicao k;
+    kernel_iniciar(&k, nivel, K, D);
+    if (b.compacto.coords != NULL) kernel_habilitar_compacto(&k);
+    kernel_carregar_centroides(&k, b.centroides);
+    medir_atribuicao(&b, &k, "atrib_int32", (double)D * sizeof(int), nivel == SIMD_ESCALAR);
+    medir_atribuicao(&b, &k, "atrib_colunas", (double)D * sizeof(int), 0);
+    if (b.compacto.coords != NULL) {
+      const double bytes_compacto = (double)b.compacto.largura * sizeof(int16_t);
+      medir_atribuicao(&b, &k, "atrib_int16", bytes_compacto, 0);
+      if (kernel_blocado_seguro(b.min_val, b.max_val, D)) {
+        kernel_habilitar_blocado(&k, b.min_val, b.max_val);
+        kernel_carregar_centroides(&k, b.centroides);
+        medir_atribuicao(&b, &k, "atrib_blocada", bytes_compacto, 0);
+      }
+    }
+    kernel_liberar(&k);
+  }
+
+  medir_acumulacao(&b, 0);
+  if (b.compacto.coords != NULL) medir_acumulacao(&b, 1);
+
+  // Vetores de 256 MiB, ou quatro vezes os pontos se isso for maior
+  size_t bytes_banda = (size_t)256 << 20;
+  if ((size_t)M * D * sizeof(int) * 4 > bytes_banda) bytes_banda = (size_t)M * D * sizeof(int) * 4;
+  medir_banda(bytes_banda, b.repeticoes);
+
+  free(b.referencia);
+  free(b.centroides);
+  free(b.compacto.coords);
+  pontos_liberar(&b.pontos);
+  return EXIT_SUCCESS;
+}
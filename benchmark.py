@@ -0,0 +1,289 @@
+import argparse
+import json
+import os
+import statistics
+import subprocess
+
+import avaliador
+from avaliador import C
+
+# Suíte de benchmarks de escalabilidade.
+#
+# Complementa o avaliador.py (uma configuração fixa, só o tempo total) com:
+#   1. microbenchmarks dos kernels de atribuição e atualização e a banda de memória
+#      medida da máquina (bench_kernels.c);
+#   2. uma varredura ponta a ponta que varia pontos (M), dimensões (D) e clusters (K)
+#      em torno de uma configuração base, com todas as unidades de execução;
+#   3. escalabilidade forte (M fixo) e fraca (M proporcional às unidades) variando
+#      threads (OpenMP, Pthreads) e processos (MPI).
+# Toda execução tem o checksum comparado com o da versão sequencial, obtido pela
+# mesma função do avaliador. Os resultados são gravados em JSON (para comparar com
+# uma execução anterior, --comparar) e em tabelas Markdown.
+
+# --- Bloco de Configuração ---
+
+# Configuração base: os demais parâmetros ficam nestes valores quando um deles varia
+BASE = {"M": 1000000, "D": 10, "K": 100, "I": 20, "MAX_VAL": 10000}
+
+# Valores de cada parâmetro na varredura ponta a ponta
+VARREDURA = {"M": [250000, 1000000, 4000000], "D": [2, 10, 32], "K": [10, 100, 1000]}
+
+# Pontos por unidade de execução na escalabilidade fraca
+M_POR_UNIDADE_FRACA = 250000
+
+# Configuração reduzida de --rapido, para conferir a suíte em poucos segundos
+RAPIDO = {
+    "BASE": {"M": 40000, "D": 10, "K": 50, "I": 10, "MAX_VAL": 10000},
+    "VARREDURA": {"M": [20000, 40000], "D": [2, 10], "K": [10, 50]},
+    "M_POR_UNIDADE_FRACA": 20000,
+}
+
+# Execuções de cada configuração; o tempo usado é a mediana
+NUM_RUNS = 3
+
+CPU_CORES = avaliador.CPU_CORES
+DATA_DIR = "bench_dados"
+BENCH_KERNELS = {"source": "bench_kernels.c", "output": "bench_kernels", "compile_cmd": "gcc -o bench_kernels bench_kernels.c -O3 -lm"}
+GERADOR = {"source": "gerador_dataset.c", "output": "gerador_dataset", "compile_cmd": "gcc -o gerador_dataset gerador_dataset.c -O3 -lm -lpthread"}
+
+# Tolerância para marcar uma regressão em relação ao JSON de --comparar
+TOLERANCIA_REGRESSAO = 0.10
+
+# --- Funções da Suíte ---
+
+def unit_counts(max_units):
+    """Potências de 2 até max_units, incluindo o próprio max_units."""
+    counts, n = [], 1
+    while n < max_units:
+        counts.append(n); n *= 2
+    counts.append(max_units)
+    return counts
+
+def compile_tools():
+    """Compila o microbenchmark e o gerador de datasets."""
+    for tool in (BENCH_KERNELS, GERADOR):
+        print(f"Compilando {C.YELLOW}{tool['source']}{C.END}... ", end='', flush=True)
+        try:
+            subprocess.run(tool['compile_cmd'], shell=True, check=True, capture_output=True, text=True)
+            print(f"{C.GREEN}OK{C.END}")
+        except subprocess.CalledProcessError as e:
+            print(f"{C.RED}FALHOU{C.END}\n{e.stderr}"); exit(1)
+    print()
+
+def run_microbenchmarks(base, repeticoes):
+    """Executa bench_kernels na configuração base e devolve as linhas da tabela como dicionários."""
+    print(f"{C.HEADER}--- Microbenchmarks dos Kernels ---{C.END}")
+    m = min(base["M"], 1000000)
+    cmd = [f"./{BENCH_KERNELS['output']}", str(m), str(base["D"]), str(base["K"]), str(repeticoes), str(base["MAX_VAL"])]
+    result = subprocess.run(cmd, capture_output=True, text=True, check=True)
+    print(result.stdout)
+    linhas = []
+    for line in result.stdout.splitlines():
+        if line.startswith('#') or not line.strip():
+            continue
+        kernel, nivel, tempo_ms, mpontos, gb, ns_par, corretude = line.split()
+        to_float = lambda v: None if v == '-' else float(v)
+        linhas.append({"kernel": kernel, "nivel": nivel, "tempo_ms": float(tempo_ms), "mpontos_s": to_float(mpontos),
+                       "gb_s": to_float(gb), "ns_par": to_float(ns_par), "corretude": corretude})
+    divergentes = [l for l in linhas if l["corretude"] == "DIVERGE"]
+    if divergentes:
+        print(f"{C.RED}Kernels divergentes da referência escalar: {[(l['kernel'], l['nivel']) for l in divergentes]}{C.END}")
+    return linhas
+
+def dataset_for(d, m, max_val):
+    """Gera (uma vez) um dataset binário com D dimensões e pelo menos M pontos. Os programas
+    leem só os primeiros M pontos, então um arquivo por D serve a toda a varredura."""
+    os.makedirs(DATA_DIR, exist_ok=True)
+    existentes = [f for f in os.listdir(DATA_DIR) if f.startswith(f"d{d}_") and f.endswith(".bin")]
+    for f in existentes:
+        if int(f[len(f"d{d}_"):-4]) >= m:
+            return os.path.join(DATA_DIR, f)
+    path = os.path.join(DATA_DIR, f"d{d}_{m}.bin")
+    print(f"Gerando {C.YELLOW}{path}{C.END}... ", end='', flush=True)
+    subprocess.run([f"./{GERADOR['output']}", str(m), str(d), str(max_val), path, "--binario"], check=True,
+                   capture_output=True)
+    print(f"{C.GREEN}OK{C.END}")
+    return path
+
+def run_version(exe, args, units, mpi_args):
+    """Executa uma versão NUM_RUNS vezes com 'units' threads/processos. Devolve a mediana
+    dos tempos e os checksums obtidos."""
+    cmd = [f"./{exe['output']}"] + args
+    env = os.environ.copy()
+    if exe['name'] == 'OpenMP':
+        env['OMP_NUM_THREADS'] = str(units)
+    elif exe['name'] == 'Pthreads':
+        cmd.append(f"--threads={units}")
+    elif exe['name'] == 'MPI':
+        cmd = ["mpirun", "-np", str(units)] + mpi_args + cmd
+    times, checksums = [], set()
+    for _ in range(NUM_RUNS):
+        try:
+            result = subprocess.run(cmd, env=env, capture_output=True, text=True, check=True)
+            time_str, checksum_str = result.stdout.strip().split('\n')
+            times.append(float(time_str)); checksums.add(int(checksum_str))
+        except (subprocess.CalledProcessError, ValueError):
+            checksums.add(None)
+    return (statistics.median(times) if times else float('nan')), checksums
+
+def measure(config, versions, units_list, mpi_args, label):
+    """Mede uma configuração (M, D, K, I) em todas as versões e contagens de unidades pedidas.
+    O checksum de referência vem da versão sequencial, via avaliador.get_golden_checksum."""
+    path = dataset_for(config["D"], config["M"], config["MAX_VAL"])
+    args = [path, str(config["M"]), str(config["D"]), str(config["K"]), str(config["I"])]
+    print(f"{C.BLUE}{label}: M={config['M']} D={config['D']} K={config['K']} I={config['I']}{C.END}")
+    golden = avaliador.get_golden_checksum(args)
+    rows = []
+    for exe in versions:
+        for units in ([1] if exe['name'] == 'Sequencial' else units_list):
+            tempo, checksums = run_version(exe, args, units, mpi_args)
+            ok = checksums == {golden}
+            print(f"  {exe['name']:<10} unidades={units:<3} tempo={tempo:.4f}s checksum: "
+                  f"{C.GREEN + 'OK' if ok else C.RED + 'FALHOU'}{C.END}")
+            rows.append({"versao": exe['name'], "unidades": units, "M": config["M"], "D": config["D"], "K": config["K"],
+                         "I": config["I"], "tempo": tempo, "correto": ok})
+    return rows
+
+def add_rates(rows, bandwidth):
+    """Vazão de cada execução: pontos por segundo (M * I / tempo) e bytes por segundo,
+    contando uma leitura dos pontos int32 na atribuição e outra na atualização por
+    iteração (volume nominal, independente do layout escolhido pelo programa)."""
+    for r in rows:
+        r["pontos_s"] = r["M"] * r["I"] / r["tempo"]
+        r["bytes_s"] = 2 * r["M"] * r["D"] * 4 * r["I"] / r["tempo"]
+        r["fracao_banda"] = r["bytes_s"] / bandwidth if bandwidth else None
+
+def add_scaling(rows, weak):
+    """Speedup e eficiência paralela em relação à própria versão com 1 unidade:
+    forte: t1 / (n * tn) ; fraca (trabalho por unidade constante): t1 / tn."""
+    for r in rows:
+        ref = next((x for x in rows if x["versao"] == r["versao"] and x["unidades"] == 1), None)
+        if ref is None:
+            continue
+        if weak:
+            r["eficiencia"] = ref["tempo"] / r["tempo"]
+        else:
+            r["speedup"] = ref["tempo"] / r["tempo"]
+            r["eficiencia"] = r["speedup"] / r["unidades"]
+
+def fmt(v, spec):
+    return "-" if v is None else format(v, spec)
+
+def markdown_table(title, rows, extra_cols):
+    """Tabela Markdown com as colunas comuns mais 'extra_cols' ([(chave, título, formato)])."""
+    cols = [("versao", "Versão", "s"), ("unidades", "Unid.", "d"), ("M", "M", "d"), ("D", "D", "d"), ("K", "K", "d"),
+            ("tempo", "Tempo (s)", ".4f"), ("pontos_s", "Mpontos/s", "mp"), ("bytes_s", "GB/s", "gb"),
+            ("fracao_banda", "% banda", "pct")] + extra_cols + [("correto", "Checksum", "ok")]
+    lines = [f"### {title}", "", "| " + " | ".join(c[1] for c in cols) + " |", "|" + "---|" * len(cols)]
+    for r in rows:
+        cells = []
+        for key, _, spec in cols:
+            v = r.get(key)
+            if spec == "mp": cells.append(fmt(v / 1e6 if v is not None else None, ".2f"))
+            elif spec == "gb": cells.append(fmt(v / 1e9 if v is not None else None, ".2f"))
+            elif spec == "pct": cells.append(fmt(v * 100 if v is not None else None, ".1f"))
+            elif spec == "ok": cells.append("OK" if v else "FALHOU")
+            else: cells.append(fmt(v, spec))
+        lines.append("| " + " | ".join(cells) + " |")
+    return "\n".join(lines) + "\n"
+
+def compare_with(previous_path, results):
+    """Compara os tempos com os de um JSON anterior da suíte e lista as regressões."""
+    with open(previous_path) as f:
+        previous = json.load(f)
+    key = lambda r: (r["secao"], r["versao"], r["unidades"], r["M"], r["D"], r["K"], r["I"])
+    old = {key(r): r for r in previous["execucoes"]}
+    regressions = []
+    for r in results["execucoes"]:
+        o = old.get(key(r))
+        if o and r["tempo"] > o["tempo"] * (1 + TOLERANCIA_REGRESSAO):
+            regressions.append((r, o))
+    print(f"{C.HEADER}--- Comparação com {previous_path} (tolerância {TOLERANCIA_REGRESSAO:.0%}) ---{C.END}")
+    if not regressions:
+        print(f"{C.GREEN}Nenhuma regressão encontrada.{C.END}")
+    for r, o in regressions:
+        print(f"{C.RED}Regressão{C.END} [{r['secao']}] {r['versao']} unidades={r['unidades']} M={r['M']} D={r['D']} "
+              f"K={r['K']}: {o['tempo']:.4f}s -> {r['tempo']:.4f}s ({r['tempo'] / o['tempo'] - 1:+.1%})")
+    return regressions
+
+# --- Ponto de Entrada Principal ---
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Suíte de benchmarks de escalabilidade do K-Means.")
+    parser.add_argument("--rapido", action="store_true", help="configuração reduzida, para conferir a suíte")
+    parser.add_argument("--max-unidades", type=int, default=CPU_CORES, help="máximo de threads/processos (padrão: núcleos)")
+    parser.add_argument("--mpi-args", default="", help="argumentos extras do mpirun (ex.: '--oversubscribe')")
+    parser.add_argument("--saida", default="benchmark_resultados", help="prefixo dos arquivos .json e .md gerados")
+    parser.add_argument("--comparar", help="JSON de uma execução anterior, para detectar regressões")
+    opts = parser.parse_args()
+
+    base = RAPIDO["BASE"] if opts.rapido else BASE
+    sweep = RAPIDO["VARREDURA"] if opts.rapido else VARREDURA
+    m_weak = RAPIDO["M_POR_UNIDADE_FRACA"] if opts.rapido else M_POR_UNIDADE_FRACA
+    mpi_args = opts.mpi_args.split()
+    units_list = unit_counts(opts.max_unidades)
+
+    avaliador.check_dependencies()
+    avaliador.compile_sources()
+    compile_tools()
+
+    kernels = run_microbenchmarks(base, NUM_RUNS)
+    bandwidth = next((k["gb_s"] * 1e9 for k in kernels if k["kernel"] == "banda_leitura"), None)
+
+    # Um dataset por D, já com o maior M usado por ele
+    needed = {}
+    for param, values in sweep.items():
+        for v in values:
+            config = dict(base, **{param: v})
+            needed[config["D"]] = max(needed.get(config["D"], 0), config["M"])
+    needed[base["D"]] = max(needed[base["D"]], m_weak * units_list[-1])
+    for d, m in needed.items():
+        dataset_for(d, m, base["MAX_VAL"])
+
+    results = {"cpu_cores": CPU_CORES, "banda_leitura": bandwidth, "base": base, "kernels": kernels, "execucoes": []}
+    report = [f"# Resultados da suíte de benchmarks\n",
+              f"Núcleos: {CPU_CORES}; banda de leitura medida: {fmt(bandwidth / 1e9 if bandwidth else None, '.2f')} GB/s. "
+              f"Vazão em bytes conta duas leituras dos pontos int32 por iteração.\n"]
+
+    # Varredura de M, D e K com todas as unidades
+    print(f"{C.HEADER}--- Varredura de M, D e K ({opts.max_unidades} unidades) ---{C.END}")
+    rows = []
+    for param, values in sweep.items():
+        for v in values:
+            config = dict(base, **{param: v})
+            if config["K"] > config["M"]:
+                continue
+            rows += measure(config, avaliador.EXECUTABLES, [opts.max_unidades], mpi_args, f"Varredura {param}")
+    add_rates(rows, bandwidth)
+    report.append(markdown_table("Varredura de M, D e K", rows, []))
+    results["execucoes"] += [dict(r, secao="varredura") for r in rows]
+
+    # Escalabilidade forte: configuração base, unidades variando
+    print(f"{C.HEADER}--- Escalabilidade Forte ---{C.END}")
+    rows = measure(base, avaliador.EXECUTABLES, units_list, mpi_args, "Forte")
+    add_rates(rows, bandwidth); add_scaling(rows, weak=False)
+    report.append(markdown_table("Escalabilidade forte", rows,
+                                 [("speedup", "Speedup", ".2f"), ("eficiencia", "Eficiência", ".2f")]))
+    results["execucoes"] += [dict(r, secao="forte") for r in rows]
+
+    # Escalabilidade fraca: M proporcional às unidades (uma medição por contagem de unidades)
+    print(f"{C.HEADER}--- Escalabilidade Fraca ---{C.END}")
+    paralelas = [e for e in avaliador.EXECUTABLES if e['name'] != 'Sequencial']
+    rows = []
+    for units in units_list:
+        rows += measure(dict(base, M=m_weak * units), paralelas, [units], mpi_args, f"Fraca ({units} unidades)")
+    add_rates(rows, bandwidth); add_scaling(rows, weak=True)
+    report.append(markdown_table("Escalabilidade fraca", rows, [("eficiencia", "Eficiência", ".2f")]))
+    results["execucoes"] += [dict(r, secao="fraca") for r in rows]
+
+    with open(f"{opts.saida}.json", "w") as f:
+        json.dump(results, f, indent=2)
+    with open(f"{opts.saida}.md", "w") as f:
+        f.write("\n".join(report))
+    print("\n".join(report))
+    print(f"{C.GREEN}Resultados gravados em {opts.saida}.json e {opts.saida}.md{C.END}")
+
+    falhas = [r for r in results["execucoes"] if not r["correto"]]
+    regressions = compare_with(opts.comparar, results) if opts.comparar else []
+    if falhas or regressions:
+        exit(1)
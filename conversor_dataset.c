@@ -0,0 +1,130 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kmeans_dataset.h"
+
+#define TAM_BUFFER 65536  // Coordenadas escritas por chamada de fwrite
+
+/**
+ * @brief Converte um dataset de texto (formato do gerador_dataset) para o formato
+ * binário de kmeans_dataset.h, calculando a faixa de valores e o checksum.
+ */
+static int converter(const char* entrada, int num_pontos, int num_dimensoes, const char* saida) {
+  FILE* in = fopen(entrada, "r");
+  if (in == NULL) {
+    fprintf(stderr, "Erro: Não foi possível abrir o arquivo '%s'\n", entrada);
+    return EXIT_FAILURE;
+  }
+  FILE* out = fopen(saida, "wb");
+  if (out == NULL) {
+    perror("Erro ao abrir o arquivo de saída");
+    fclose(in);
+    return EXIT_FAILURE;
+  }
+
+  // Cabeçalho provisório; é reescrito no final com a faixa e o checksum
+  CabecalhoDataset cab;
+  dataset_cabecalho_preencher(&cab, num_pontos, num_dimensoes, 0, 0, 0, 0);
+  if (dataset_escrever_cabecalho(out, &cab) != 0) {
+    perror("Erro ao escrever o arquivo de saída");
+    return EXIT_FAILURE;
+  }
+
+  int* buffer = (int*)malloc(TAM_BUFFER * sizeof(int));
+  uint64_t checksum = DATASET_FNV_INICIAL;
+  int min_val = INT_MAX, max_val = INT_MIN;
+  size_t total = (size_t)num_pontos * num_dimensoes, usados = 0;
+
+  for (size_t i = 0; i < total; i++) {
+    if (fscanf(in, "%d", &buffer[usados]) != 1) {
+      fprintf(stderr, "Erro: Arquivo de dados mal formatado ou incompleto (ponto %zu).\n", i / num_dimensoes);
+      return EXIT_FAILURE;
+    }
+    if (buffer[usados] < min_val) min_val = buffer[usados];
+    if (buffer[usados] > max_val) max_val = buffer[usados];
+    if (++usados == TAM_BUFFER || i + 1 == total) {
+      checksum = dataset_checksum_atualizar(checksum, buffer, usados * sizeof(int));
+      if (fwrite(buffer, sizeof(int), usados, out) != usados) {
+        perror("Erro ao escrever o arquivo de saída");
+        return EXIT_FAILURE;
+      }
+      usados = 0;
+    }
+  }
+
+  dataset_cabecalho_preencher(&cab, num_pontos, num_dimensoes, min_val, max_val, 1, checksum);
+  if (dataset_escrever_cabecalho(out, &cab) != 0 || fclose(out) != 0) {
+    perror("Erro ao escrever o arquivo de saída");
+    return EXIT_FAILURE;
+  }
+  fclose(in);
+  free(buffer);
+
+  printf("'%s' convertido para '%s': %d pontos, %d dimensões, valores em [%d, %d].\n", entrada, saida, num_pontos,
+         num_dimensoes, min_val, max_val);
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Confere a faixa de valores e o checksum gravados no cabeçalho de um dataset binário.
+ */
+static int verificar(const char* arquivo) {
+  int fd = open(arquivo, O_RDONLY);
+  CabecalhoDataset cab;
+  if (fd < 0 || !dataset_ler_cabecalho(fd, &cab)) {
+    fprintf(stderr, "Erro: '%s' não é um dataset binário.\n", arquivo);
+    return EXIT_FAILURE;
+  }
+  close(fd);
+
+  DatasetBinario ds;
+  dataset_binario_abrir(arquivo, (int)cab.num_pontos, (int)cab.num_dimensoes, &ds);
+  size_t total = (size_t)cab.num_pontos * cab.num_dimensoes;
+  int min_val = INT_MAX, max_val = INT_MIN;
+  for (size_t i = 0; i < total; i++) {
+    if (ds.coords[i] < min_val) min_val = ds.coords[i];
+    if (ds.coords[i] > max_val) max_val = ds.coords[i];
+  }
+  uint64_t checksum = dataset_checksum_atualizar(DATASET_FNV_INICIAL, ds.coords, total * sizeof(int));
+  dataset_binario_fechar(&ds);
+
+  printf("%llu pontos, %u dimensões, valores em [%d, %d]\n", (unsigned long long)cab.num_pontos, cab.num_dimensoes,
+         min_val, max_val);
+  int ok = min_val == cab.min_val && max_val == cab.max_val;
+  if (!ok) {
+    printf("Faixa de valores difere do cabeçalho ([%d, %d]).\n", cab.min_val, cab.max_val);
+  }
+  if (cab.flags & DATASET_FLAG_CHECKSUM) {
+    if (checksum != cab.checksum) {
+      printf("Checksum difere do cabeçalho.\n");
+      ok = 0;
+    } else {
+      printf("Checksum OK.\n");
+    }
+  } else {
+    printf("Arquivo sem checksum.\n");
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc == 3 && strcmp(argv[1], "--verificar") == 0) {
+    return verificar(argv[2]);
+  }
+  if (argc != 5) {
+    fprintf(stderr, "Uso: %s <arquivo_texto> <num_pontos> <num_dimensoes> <arquivo_binario>\n", argv[0]);
+    fprintf(stderr, "     %s --verificar <arquivo_binario>\n", argv[0]);
+    fprintf(stderr, "Exemplo: %s dataset.txt 1000000 10 dataset.bin\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  int num_pontos = atoi(argv[2]);
+  int num_dimensoes = atoi(argv[3]);
+  if (num_pontos <= 0 || num_dimensoes <= 0) {
+    fprintf(stderr, "Erro: O número de pontos e de dimensões devem ser positivos.\n");
+    return EXIT_FAILURE;
+  }
+  return converter(argv[1], num_pontos, num_dimensoes, argv[4]);
+}
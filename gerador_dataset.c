@@ -1,51 +1,453 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kmeans_aleatorio.h"
+#include "kmeans_dataset.h"
+
+// Gerador de datasets sintéticos.
+//
+// Cada ponto é sorteado de um fluxo aleatório próprio, obtido de (semente, índice do
+// ponto) por uma função de mistura (gerador baseado em contador). Assim o arquivo
+// depende só da semente e dos parâmetros, nunca do número de threads nem da ordem em
+// que os pontos são gerados. As threads geram blocos de pontos, já formatados como
+// texto ou binário, enquanto a thread principal grava a rodada anterior em ordem.
+
+#define COORDS_POR_BLOCO (1 << 19)  // Coordenadas geradas por bloco (por thread e rodada)
+#define MAX_CHARS_COORD 12          // "-2147483648" e o separador
+
+enum {
+  DIST_UNIFORME,      // Coordenadas uniformes em [0, max_val] (comportamento original)
+  DIST_GAUSSIANA,     // Nuvens gaussianas isotrópicas de mesmo peso
+  DIST_ANISOTROPICA,  // Nuvens gaussianas alongadas e rotacionadas
+  DIST_DESBALANCEADA  // Nuvens gaussianas com pesos de Zipf (1, 1/2, 1/3, ...)
+};
+
+typedef struct {
+  int distribuicao;
+  int num_pontos;
+  int num_dimensoes;
+  int max_val;
+  int num_clusters;
+  double desvio;       // Desvio-padrão das nuvens, em unidades de max_val
+  uint64_t semente;
+  double* centros;     // [k * D + d]
+  double* escalas;     // Desvio-padrão de cada cluster em cada eixo [k * D + d]
+  double* reflexoes;   // Vetor unitário da reflexão de Householder de cada cluster (anisotrópica)
+  double* acumulada;   // Distribuição acumulada dos pesos dos clusters
+} ModeloDataset;
+
+// --- Números aleatórios baseados em contador ---
+
+// O n-ésimo sorteio de um fluxo é aleatorio_hash(chave + n * constante), sem estado oculto
+typedef struct {
+  uint64_t chave;
+  uint64_t contador;
+} FluxoAleatorio;
+
+#define FLUXO_MODELO UINT64_MAX  // Índice do fluxo dos parâmetros do modelo
+
+static inline FluxoAleatorio fluxo_criar(uint64_t semente, uint64_t indice) {
+  FluxoAleatorio f = {aleatorio_hash(aleatorio_hash(semente) ^ aleatorio_hash(indice + 0x632BE59BD9B4E019ULL)), 0};
+  return f;
+}
+
+static inline uint64_t fluxo_proximo(FluxoAleatorio* f) {
+  return aleatorio_hash(f->chave + f->contador++ * 0x9E3779B97F4A7C15ULL);
+}
+
+/** @brief Sorteio uniforme em [0, 1). */
+static inline double fluxo_uniforme(FluxoAleatorio* f) {
+  return (double)(fluxo_proximo(f) >> 11) * 0x1.0p-53;
+}
+
+/** @brief Inteiro uniforme em [0, limite], por multiplicação (sem o viés do módulo). */
+static inline int fluxo_inteiro(FluxoAleatorio* f, int limite) {
+  return (int)(((fluxo_proximo(f) >> 32) * ((uint64_t)limite + 1)) >> 32);
+}
+
+/** @brief Par de normais padrão independentes (Box-Muller). */
+static inline void fluxo_normais(FluxoAleatorio* f, double* a, double* b) {
+  double r = sqrt(-2.0 * log(1.0 - fluxo_uniforme(f)));
+  double theta = 2.0 * M_PI * fluxo_uniforme(f);
+  *a = r * cos(theta);
+  *b = r * sin(theta);
+}
+
+// --- Modelo ---
+
+/**
+ * @brief Sorteia os parâmetros do modelo (centros, escalas, rotações e pesos) a partir do
+ * fluxo FLUXO_MODELO da semente.
+ */
+static void modelo_preparar(ModeloDataset* m) {
+  const int K = m->num_clusters, D = m->num_dimensoes;
+  m->centros = (double*)malloc((size_t)K * D * sizeof(double));
+  m->escalas = (double*)malloc((size_t)K * D * sizeof(double));
+  m->reflexoes = (double*)malloc((size_t)K * D * sizeof(double));
+  m->acumulada = (double*)malloc(K * sizeof(double));
+  FluxoAleatorio f = fluxo_criar(m->semente, FLUXO_MODELO);
+  const double sigma = m->desvio * m->max_val;
+  double total = 0.0;
+  for (int k = 0; k < K; k++) {
+    double norma = 0.0;
+    for (int d = 0; d < D; d++) {
+      // Centros longe das bordas, onde as nuvens seriam cortadas em 0 e max_val
+      m->centros[k * D + d] = (0.1 + 0.8 * fluxo_uniforme(&f)) * m->max_val;
+      // Anisotrópica: desvio por eixo log-uniforme entre sigma/10 e ~3*sigma
+      m->escalas[k * D + d] =
+          m->distribuicao == DIST_ANISOTROPICA ? sigma * pow(10.0, 1.5 * fluxo_uniforme(&f) - 1.0) : sigma;
+      double a, b;
+      fluxo_normais(&f, &a, &b);
+      m->reflexoes[k * D + d] = a;
+      norma += a * a;
+    }
+    norma = sqrt(norma);
+    for (int d = 0; d < D; d++) {
+      m->reflexoes[k * D + d] /= norma;
+    }
+    total += m->distribuicao == DIST_DESBALANCEADA ? 1.0 / (k + 1) : 1.0;
+    m->acumulada[k] = total;
+  }
+  for (int k = 0; k < K; k++) {
+    m->acumulada[k] /= total;
+  }
+}
+
+static void modelo_liberar(ModeloDataset* m) {
+  free(m->centros);
+  free(m->escalas);
+  free(m->reflexoes);
+  free(m->acumulada);
+}
+
+/**
+ * @brief Gera o ponto 'indice' em 'ponto'. 'z' é um vetor auxiliar de D posições.
+ */
+static inline void modelo_gerar_ponto(const ModeloDataset* m, long long indice, int* ponto, double* z) {
+  const int D = m->num_dimensoes;
+  FluxoAleatorio f = fluxo_criar(m->semente, (uint64_t)indice);
+  if (m->distribuicao == DIST_UNIFORME) {
+    for (int d = 0; d < D; d++) {
+      ponto[d] = fluxo_inteiro(&f, m->max_val);
+    }
+    return;
+  }
+  // Cluster pela distribuição acumulada dos pesos (busca binária)
+  double u = fluxo_uniforme(&f);
+  int lo = 0, hi = m->num_clusters - 1;
+  while (lo < hi) {
+    int meio = (lo + hi) / 2;
+    if (u < m->acumulada[meio]) hi = meio; else lo = meio + 1;
+  }
+  const double* centro = &m->centros[(size_t)lo * D];
+  const double* escala = &m->escalas[(size_t)lo * D];
+  for (int d = 0; d < D; d += 2) {
+    double a, b;
+    fluxo_normais(&f, &a, &b);
+    z[d] = a * escala[d];
+    if (d + 1 < D) z[d + 1] = b * escala[d + 1];
+  }
+  if (m->distribuicao == DIST_ANISOTROPICA) {
+    // Rotaciona a nuvem alongada com a reflexão H = I - 2vv^T do cluster
+    const double* v = &m->reflexoes[(size_t)lo * D];
+    double produto = 0.0;
+    for (int d = 0; d < D; d++) {
+      produto += v[d] * z[d];
+    }
+    for (int d = 0; d < D; d++) {
+      z[d] -= 2.0 * produto * v[d];
+    }
+  }
+  for (int d = 0; d < D; d++) {
+    double x = nearbyint(centro[d] + z[d]);
+    ponto[d] = x < 0.0 ? 0 : x > m->max_val ? m->max_val : (int)x;
+  }
+}
+
+// --- Geração paralela ---
+
+typedef struct {
+  char* dados;
+  size_t bytes;
+  int min_val, max_val;
+} BlocoGerado;
+
+typedef struct {
+  const ModeloDataset* modelo;
+  int binario;
+  int num_threads;
+  int pontos_por_bloco;
+  int num_blocos;
+  int num_rodadas;
+  BlocoGerado* blocos[2];  // [rodada % 2][thread]
+  pthread_barrier_t barreira;
+} Geracao;
+
+typedef struct {
+  Geracao* g;
+  int id;
+} TarefaGeracao;
+
+/**
+ * @brief Escreve 'valor' em decimal a partir de 'saida' e devolve o número de caracteres.
+ */
+static inline int formatar_inteiro(int valor, char* saida) {
+  char tmp[MAX_CHARS_COORD];
+  unsigned int v = valor < 0 ? 0u - (unsigned int)valor : (unsigned int)valor;
+  int n = 0;
+  do {
+    tmp[n++] = (char)('0' + v % 10);
+    v /= 10;
+  } while (v != 0);
+  int escritos = 0;
+  if (valor < 0) saida[escritos++] = '-';
+  while (n > 0) {
+    saida[escritos++] = tmp[--n];
+  }
+  return escritos;
+}
+
+/**
+ * @brief Gera o bloco 'b' de pontos já no formato do arquivo.
+ */
+static void gerar_bloco(const Geracao* g, int b, BlocoGerado* saida, int* ponto, double* z) {
+  const ModeloDataset* m = g->modelo;
+  const int D = m->num_dimensoes;
+  long long inicio = (long long)b * g->pontos_por_bloco;
+  long long fim = inicio + g->pontos_por_bloco;
+  if (fim > m->num_pontos) fim = m->num_pontos;
+  char* cursor = saida->dados;
+  saida->min_val = m->max_val;
+  saida->max_val = 0;
+  for (long long i = inicio; i < fim; i++) {
+    int* destino = g->binario ? (int*)cursor : ponto;
+    modelo_gerar_ponto(m, i, destino, z);
+    for (int d = 0; d < D; d++) {
+      if (destino[d] < saida->min_val) saida->min_val = destino[d];
+      if (destino[d] > saida->max_val) saida->max_val = destino[d];
+    }
+    if (g->binario) {
+      cursor += (size_t)D * sizeof(int);
+    } else {
+      for (int d = 0; d < D; d++) {
+        cursor += formatar_inteiro(ponto[d], cursor);
+        *cursor++ = d == D - 1 ? '\n' : ' ';
+      }
+    }
+  }
+  saida->bytes = (size_t)(cursor - saida->dados);
+}
+
+/**
+ * @brief Na rodada r, a thread 'id' gera o bloco r * num_threads + id no conjunto de
+ * buffers r % 2. A barreira de cada rodada também espera a thread principal terminar de
+ * gravar a rodada anterior, que usou o outro conjunto.
+ */
+static void* gerar_trabalhador(void* arg) {
+  TarefaGeracao* t = (TarefaGeracao*)arg;
+  Geracao* g = t->g;
+  int* ponto = (int*)malloc(g->modelo->num_dimensoes * sizeof(int));
+  double* z = (double*)malloc((g->modelo->num_dimensoes + 1) * sizeof(double));
+  for (int r = 0; r < g->num_rodadas; r++) {
+    int b = r * g->num_threads + t->id;
+    BlocoGerado* bloco = &g->blocos[r % 2][t->id];
+    bloco->bytes = 0;
+    if (b < g->num_blocos) gerar_bloco(g, b, bloco, ponto, z);
+    pthread_barrier_wait(&g->barreira);
+  }
+  free(ponto);
+  free(z);
+  return NULL;
+}
 
 /**
- * @brief Gera um arquivo de texto com um dataset de pontos com coordenadas inteiras.
+ * @brief Gera o dataset e grava os blocos em ordem em 'file' (já posicionado no início
+ * dos dados). Em binário, calcula também a faixa de valores e o checksum.
+ * @return 0 em caso de sucesso, -1 em caso de erro de escrita.
+ */
+static int gerar_dataset(const ModeloDataset* m, int binario, int num_threads, FILE* file, int* min_val,
+                         int* max_val, uint64_t* checksum) {
+  Geracao g;
+  g.modelo = m;
+  g.binario = binario;
+  g.num_threads = num_threads;
+  g.pontos_por_bloco = COORDS_POR_BLOCO / m->num_dimensoes > 0 ? COORDS_POR_BLOCO / m->num_dimensoes : 1;
+  g.num_blocos = (int)(((long long)m->num_pontos + g.pontos_por_bloco - 1) / g.pontos_por_bloco);
+  g.num_rodadas = (g.num_blocos + num_threads - 1) / num_threads;
+  const size_t capacidade = (size_t)g.pontos_por_bloco * m->num_dimensoes * (binario ? sizeof(int) : MAX_CHARS_COORD);
+  for (int c = 0; c < 2; c++) {
+    g.blocos[c] = (BlocoGerado*)calloc(num_threads, sizeof(BlocoGerado));
+    for (int t = 0; t < num_threads; t++) {
+      g.blocos[c][t].dados = (char*)malloc(capacidade);
+      if (g.blocos[c][t].dados == NULL) {
+        fprintf(stderr, "Erro: Falha ao alocar os buffers de geração\n");
+        exit(EXIT_FAILURE);
+      }
+    }
+  }
+  pthread_barrier_init(&g.barreira, NULL, num_threads + 1);
+  pthread_t* threads = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+  TarefaGeracao* tarefas = (TarefaGeracao*)malloc(num_threads * sizeof(TarefaGeracao));
+  for (int t = 0; t < num_threads; t++) {
+    tarefas[t].g = &g;
+    tarefas[t].id = t;
+    if (pthread_create(&threads[t], NULL, gerar_trabalhador, &tarefas[t]) != 0) {
+      fprintf(stderr, "Erro: Falha ao criar as threads de geração\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  int erro = 0;
+  *min_val = m->max_val;
+  *max_val = 0;
+  *checksum = DATASET_FNV_INICIAL;
+  for (int r = 0; r < g.num_rodadas; r++) {
+    pthread_barrier_wait(&g.barreira);
+    for (int t = 0; t < num_threads && !erro; t++) {
+      const BlocoGerado* bloco = &g.blocos[r % 2][t];
+      if (bloco->bytes == 0) continue;
+      if (bloco->min_val < *min_val) *min_val = bloco->min_val;
+      if (bloco->max_val > *max_val) *max_val = bloco->max_val;
+      if (binario) *checksum = dataset_checksum_atualizar(*checksum, bloco->dados, bloco->bytes);
+      erro = fwrite(bloco->dados, 1, bloco->bytes, file) != bloco->bytes;
+    }
+  }
+
+  for (int t = 0; t < num_threads; t++) {
+    pthread_join(threads[t], NULL);
+  }
+  pthread_barrier_destroy(&g.barreira);
+  for (int c = 0; c < 2; c++) {
+    for (int t = 0; t < num_threads; t++) {
+      free(g.blocos[c][t].dados);
+    }
+    free(g.blocos[c]);
+  }
+  free(threads);
+  free(tarefas);
+  return erro ? -1 : 0;
+}
+
+static void uso(const char* programa) {
+  fprintf(stderr, "Uso: %s <num_pontos> <num_dimensoes> <max_val> <arquivo_saida> [opções]\n", programa);
+  fprintf(stderr, "Opções:\n");
+  fprintf(stderr, "  --binario                  formato binário de kmeans_dataset.h\n");
+  fprintf(stderr, "  --distribuicao=TIPO        uniforme (padrão), gaussiana, anisotropica, desbalanceada\n");
+  fprintf(stderr, "  --clusters=N               número de nuvens (padrão 10)\n");
+  fprintf(stderr, "  --desvio=F                 desvio-padrão das nuvens em frações de max_val (padrão 0.05)\n");
+  fprintf(stderr, "  --semente=N                semente (padrão 42)\n");
+  fprintf(stderr, "  --threads=N                threads de geração (padrão: todas as CPUs)\n");
+  fprintf(stderr, "Exemplo: %s 1000000 10 10000 dataset.txt\n", programa);
+}
+
+/**
+ * @brief Gera um arquivo com um dataset de pontos com coordenadas inteiras.
  *
  * Este programa cria um arquivo contendo M pontos em um espaço D-dimensional,
- * com coordenadas inteiras aleatórias no intervalo [0, max_val].
+ * com coordenadas inteiras no intervalo [0, max_val]: uniformes ou em nuvens
+ * gaussianas (--distribuicao). Com --binario, o arquivo é escrito no formato
+ * binário de kmeans_dataset.h. O resultado é o mesmo para qualquer número de threads.
  */
 int main(int argc, char* argv[]) {
-  if (argc != 5) {
-    fprintf(stderr, "Uso: %s <num_pontos> <num_dimensoes> <max_val> <arquivo_saida>\n", argv[0]);
-    fprintf(stderr, "Exemplo: %s 1000000 10 10000 dataset.txt\n", argv[0]);
+  if (argc < 5) {
+    uso(argv[0]);
     return EXIT_FAILURE;
   }
 
-  int num_points = atoi(argv[1]);
-  int num_dimensions = atoi(argv[2]);
-  int max_val = atoi(argv[3]);
+  ModeloDataset modelo;
+  memset(&modelo, 0, sizeof(modelo));
+  long long num_points = atoll(argv[1]);
+  modelo.num_dimensoes = atoi(argv[2]);
+  modelo.max_val = atoi(argv[3]);
   const char* output_filename = argv[4];
+  modelo.distribuicao = DIST_UNIFORME;
+  modelo.num_clusters = 10;
+  modelo.desvio = 0.05;
+  modelo.semente = 42;
+  int binario = 0;
+  int num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+  for (int i = 5; i < argc; i++) {
+    const char* arg = argv[i];
+    if (strcmp(arg, "--binario") == 0) {
+      binario = 1;
+    } else if (strcmp(arg, "--distribuicao=uniforme") == 0) {
+      modelo.distribuicao = DIST_UNIFORME;
+    } else if (strcmp(arg, "--distribuicao=gaussiana") == 0) {
+      modelo.distribuicao = DIST_GAUSSIANA;
+    } else if (strcmp(arg, "--distribuicao=anisotropica") == 0) {
+      modelo.distribuicao = DIST_ANISOTROPICA;
+    } else if (strcmp(arg, "--distribuicao=desbalanceada") == 0) {
+      modelo.distribuicao = DIST_DESBALANCEADA;
+    } else if (strncmp(arg, "--clusters=", 11) == 0) {
+      modelo.num_clusters = atoi(arg + 11);
+    } else if (strncmp(arg, "--desvio=", 9) == 0) {
+      modelo.desvio = atof(arg + 9);
+    } else if (strncmp(arg, "--semente=", 10) == 0) {
+      modelo.semente = strtoull(arg + 10, NULL, 10);
+    } else if (strncmp(arg, "--threads=", 10) == 0) {
+      num_threads = atoi(arg + 10);
+    } else {
+      fprintf(stderr, "Erro: opção desconhecida '%s'\n", arg);
+      uso(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
 
-  if (num_points <= 0 || num_dimensions <= 0 || max_val <= 0) {
+  if (num_points <= 0 || num_points > INT_MAX || modelo.num_dimensoes <= 0 || modelo.max_val <= 0) {
     fprintf(stderr, "Erro: O número de pontos, dimensões e o valor máximo devem ser positivos.\n");
     return EXIT_FAILURE;
   }
+  if (modelo.num_clusters <= 0 || modelo.desvio <= 0.0 || num_threads <= 0) {
+    fprintf(stderr, "Erro: --clusters, --desvio e --threads devem ser positivos.\n");
+    return EXIT_FAILURE;
+  }
+  modelo.num_pontos = (int)num_points;
 
-  FILE* file = fopen(output_filename, "w");
+  FILE* file = fopen(output_filename, binario ? "wb" : "w");
   if (file == NULL) {
     perror("Erro ao abrir o arquivo de saída");
     return EXIT_FAILURE;
   }
 
-  srand(time(NULL));
-
   printf("Gerando '%s' com %d pontos, %d dimensões e valores até %d...\n",
-         output_filename, num_points, num_dimensions, max_val);
+         output_filename, modelo.num_pontos, modelo.num_dimensoes, modelo.max_val);
 
-  for (int i = 0; i < num_points; i++) {
-    for (int j = 0; j < num_dimensions; j++) {
-      // Gera um inteiro aleatório no intervalo [0, max_val]
-      int random_val = rand() % (max_val + 1);
-      fprintf(file, "%d%c", random_val, (j == num_dimensions - 1) ? '\n' : ' ');
+  modelo_preparar(&modelo);
+  CabecalhoDataset cab;
+  if (binario) {
+    // Cabeçalho provisório; é reescrito no final com a faixa real e o checksum
+    dataset_cabecalho_preencher(&cab, modelo.num_pontos, modelo.num_dimensoes, 0, modelo.max_val, 0, 0);
+    if (dataset_escrever_cabecalho(file, &cab) != 0) {
+      perror("Erro ao escrever o arquivo de saída");
+      return EXIT_FAILURE;
     }
   }
+  int min_gerado, max_gerado;
+  uint64_t checksum;
+  if (gerar_dataset(&modelo, binario, num_threads, file, &min_gerado, &max_gerado, &checksum) != 0) {
+    perror("Erro ao escrever o arquivo de saída");
+    return EXIT_FAILURE;
+  }
+  if (binario) {
+    dataset_cabecalho_preencher(&cab, modelo.num_pontos, modelo.num_dimensoes, min_gerado, max_gerado, 1, checksum);
+    if (dataset_escrever_cabecalho(file, &cab) != 0) {
+      perror("Erro ao escrever o arquivo de saída");
+      return EXIT_FAILURE;
+    }
+  }
+  modelo_liberar(&modelo);
 
-  fclose(file);
+  if (fclose(file) != 0) {
+    perror("Erro ao escrever o arquivo de saída");
+    return EXIT_FAILURE;
+  }
   printf("Dataset gerado com sucesso!\n");
 
   return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -0,0 +1,21 @@
+#ifndef KMEANS_ALEATORIO_H
+#define KMEANS_ALEATORIO_H
+
+#include <stdint.h>
+
+// Números aleatórios baseados em contador, compartilhados pelos mini-lotes, pelo
+// k-means||, pelo gerador de datasets e pelo microbenchmark: o valor depende só do
+// contador, e não da ordem das chamadas, então os sorteios são os mesmos com qualquer
+// número de threads ou processos.
+
+/**
+ * @brief Finalizador do SplitMix64: o mesmo contador sempre produz o mesmo valor.
+ */
+static inline uint64_t aleatorio_hash(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+#endif
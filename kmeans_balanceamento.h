@@ -0,0 +1,259 @@
+#ifndef KMEANS_BALANCEAMENTO_H
+#define KMEANS_BALANCEAMENTO_H
+
+#include <mpi.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "kmeans_dataset.h"
+#include "kmeans_simd.h"
+
+// Balanceamento de carga adaptativo da versão MPI (opção --balancear[=limiar]).
+//
+// Cada processo continua com uma faixa contígua dos pontos, mas as fronteiras entre
+// as faixas deixam de ser fixas. O tempo de cálculo de cada iteração (atribuição e
+// acúmulo das somas, até a redução) é medido em cada processo; o resto da iteração é
+// espera pelos mais lentos e comunicação. A cada BALANCEAMENTO_JANELA iterações
+// medidas, o processo 0 compara os tempos de cálculo e, se o mais lento passa da média
+// por mais que o limiar, divide os pontos na proporção da vazão (pontos por segundo)
+// de cada processo. As novas fronteiras são múltiplos de BALANCEAMENTO_BLOCO, e os
+// pontos (com os rótulos) migram entre os processos em um único MPI_Alltoallv. Como
+// as somas são inteiras, o resultado não depende da divisão.
+
+#define BALANCEAMENTO_BLOCO 1024  // Granularidade das fronteiras, em pontos
+#define BALANCEAMENTO_JANELA 2    // Iterações medidas antes de cada decisão
+
+typedef struct {
+  int processo;         // rank deste processo
+  int num_processos;
+  double limiar;        // Desequilíbrio máximo tolerado: max / média - 1 dos tempos de cálculo
+  int num_pontos;       // Total de pontos, em todos os processos
+  int* fronteiras;      // [p] = primeiro ponto do processo p; [num_processos] = num_pontos
+  int* novas;           // Fronteiras decididas pelo processo 0
+  double* tempos;       // Tempos de cálculo da janela de cada processo (só no processo 0)
+  int* envios;          // Contagens e deslocamentos do MPI_Alltoallv da migração
+  int* desl_envios;
+  int* recebimentos;
+  int* desl_recebimentos;
+  double inicio_iteracao;
+  double fim_calculo;
+  double calculo_janela;  // Tempo de cálculo acumulado na janela atual
+  int iteracoes_janela;   // Iterações medidas na janela atual
+  int descartar;          // A próxima iteração não entra na janela (caches frios)
+  double calculo_total;   // Totais do processo, informados no fim
+  double espera_total;
+  double migracao_total;
+  long long recebidos;    // Pontos recebidos de outros processos
+  int rebalanceamentos;
+} Balanceamento;
+
+/**
+ * @brief Começa com a divisão uniforme da versão de referência (os 'resto' primeiros
+ * processos ficam com um ponto a mais).
+ */
+static inline void balanceamento_iniciar(Balanceamento* b, double limiar, int num_pontos, int processo,
+                                         int num_processos) {
+  b->processo = processo;
+  b->num_processos = num_processos;
+  b->limiar = limiar;
+  b->num_pontos = num_pontos;
+  b->fronteiras = (int*)malloc((num_processos + 1) * sizeof(int));
+  b->novas = (int*)malloc((num_processos + 1) * sizeof(int));
+  b->tempos = (double*)malloc(num_processos * sizeof(double));
+  b->envios = (int*)malloc(num_processos * sizeof(int));
+  b->desl_envios = (int*)malloc(num_processos * sizeof(int));
+  b->recebimentos = (int*)malloc(num_processos * sizeof(int));
+  b->desl_recebimentos = (int*)malloc(num_processos * sizeof(int));
+  if (b->fronteiras == NULL || b->novas == NULL || b->tempos == NULL || b->envios == NULL ||
+      b->desl_envios == NULL || b->recebimentos == NULL || b->desl_recebimentos == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+  }
+  const int base = num_pontos / num_processos, resto = num_pontos % num_processos;
+  for (int p = 0; p <= num_processos; p++) {
+    b->fronteiras[p] = p * base + (p < resto ? p : resto);
+  }
+  b->calculo_janela = 0.0;
+  b->iteracoes_janela = 0;
+  b->descartar = 1;
+  b->calculo_total = b->espera_total = b->migracao_total = 0.0;
+  b->recebidos = 0;
+  b->rebalanceamentos = 0;
+}
+
+static inline void balanceamento_liberar(Balanceamento* b) {
+  free(b->fronteiras);
+  free(b->novas);
+  free(b->tempos);
+  free(b->envios);
+  free(b->desl_envios);
+  free(b->recebimentos);
+  free(b->desl_recebimentos);
+}
+
+static inline void balanceamento_inicio_iteracao(Balanceamento* b) {
+  if (b != NULL) b->inicio_iteracao = MPI_Wtime();
+}
+
+/**
+ * @brief Marca o fim do cálculo local da iteração, logo antes da redução.
+ */
+static inline void balanceamento_fim_calculo(Balanceamento* b) {
+  if (b != NULL) b->fim_calculo = MPI_Wtime();
+}
+
+/**
+ * @brief Contabiliza a iteração: cálculo até balanceamento_fim_calculo, espera (e
+ * comunicação) daí até agora.
+ */
+static inline void balanceamento_fim_iteracao(Balanceamento* b) {
+  if (b == NULL) return;
+  const double agora = MPI_Wtime(), calculo = b->fim_calculo - b->inicio_iteracao;
+  b->calculo_total += calculo;
+  b->espera_total += agora - b->fim_calculo;
+  if (b->descartar) {
+    b->descartar = 0;
+    return;
+  }
+  b->calculo_janela += calculo;
+  b->iteracoes_janela++;
+}
+
+/**
+ * @brief No processo 0: fronteiras proporcionais à vazão medida de cada processo,
+ * arredondadas para BALANCEAMENTO_BLOCO, com pelo menos um ponto por processo.
+ * @return 1 se o desequilíbrio passou do limiar e as fronteiras mudaram.
+ */
+static inline int balanceamento_planejar(Balanceamento* b) {
+  const int num_processos = b->num_processos;
+  double soma = 0.0, maior = 0.0;
+  for (int p = 0; p < num_processos; p++) {
+    soma += b->tempos[p];
+    if (b->tempos[p] > maior) maior = b->tempos[p];
+  }
+  if (soma <= 0.0 || maior / (soma / num_processos) - 1.0 <= b->limiar) return 0;
+
+  double vazao_total = 0.0;
+  for (int p = 0; p < num_processos; p++) {
+    const int pontos = b->fronteiras[p + 1] - b->fronteiras[p];
+    // Um tempo nulo (faixa vazia ou relógio grosseiro) conta como a vazão média
+    b->tempos[p] = b->tempos[p] > 0.0 ? pontos / b->tempos[p] : b->num_pontos / soma;
+    vazao_total += b->tempos[p];
+  }
+  double acumulada = 0.0;
+  b->novas[0] = 0;
+  for (int p = 1; p < num_processos; p++) {
+    acumulada += b->tempos[p - 1];
+    long long fronteira = (long long)(b->num_pontos * (acumulada / vazao_total) / BALANCEAMENTO_BLOCO + 0.5) *
+                          BALANCEAMENTO_BLOCO;
+    if (fronteira < b->novas[p - 1] + 1) fronteira = b->novas[p - 1] + 1;
+    if (fronteira > b->num_pontos - (num_processos - p)) fronteira = b->num_pontos - (num_processos - p);
+    b->novas[p] = (int)fronteira;
+  }
+  b->novas[num_processos] = b->num_pontos;
+  for (int p = 1; p < num_processos; p++) {
+    if (b->novas[p] != b->fronteiras[p]) return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Troca os pontos (coordenadas e rótulos) para as faixas de b->novas em um
+ * único MPI_Alltoallv por vetor; cada par de processos troca a interseção entre a
+ * faixa antiga de um e a nova do outro. O layout em colunas e a cópia compacta são
+ * refeitos para os novos pontos locais.
+ */
+static inline void balanceamento_migrar(Balanceamento* b, ConjuntoPontos* pontos, PontosCompactos* compacto,
+                                        MPI_Datatype tipo_ponto) {
+  const int processo = b->processo, num_processos = b->num_processos;
+  const int inicio = b->fronteiras[processo], fim = b->fronteiras[processo + 1];
+  const int novo_inicio = b->novas[processo], novo_fim = b->novas[processo + 1];
+  int enviados = 0, recebidos = 0;
+  for (int p = 0; p < num_processos; p++) {
+    const int de = inicio > b->novas[p] ? inicio : b->novas[p];
+    const int ate = fim < b->novas[p + 1] ? fim : b->novas[p + 1];
+    b->envios[p] = ate > de ? ate - de : 0;
+    b->desl_envios[p] = enviados;
+    enviados += b->envios[p];
+    const int de_novo = novo_inicio > b->fronteiras[p] ? novo_inicio : b->fronteiras[p];
+    const int ate_novo = novo_fim < b->fronteiras[p + 1] ? novo_fim : b->fronteiras[p + 1];
+    b->recebimentos[p] = ate_novo > de_novo ? ate_novo - de_novo : 0;
+    b->desl_recebimentos[p] = recebidos;
+    recebidos += b->recebimentos[p];
+  }
+  b->recebidos += recebidos - b->recebimentos[processo];
+
+  ConjuntoPontos novos;
+  pontos_iniciar(&novos, novo_fim - novo_inicio, pontos->num_dimensoes, NULL);
+  MPI_Alltoallv(pontos->coords, b->envios, b->desl_envios, tipo_ponto, novos.coords, b->recebimentos,
+                b->desl_recebimentos, tipo_ponto, MPI_COMM_WORLD);
+  MPI_Alltoallv(pontos->rotulos, b->envios, b->desl_envios, MPI_INT32_T, novos.rotulos, b->recebimentos,
+                b->desl_recebimentos, MPI_INT32_T, MPI_COMM_WORLD);
+  const int colunas = pontos->colunas != NULL;
+  pontos_liberar(pontos);
+  *pontos = novos;
+  if (colunas) {
+    pontos_gerar_colunas(pontos);
+  }
+  if (compacto->coords != NULL) {
+    free(compacto->coords);
+    simd_compactar(pontos->coords, pontos->num_pontos, pontos->num_dimensoes, INT16_MIN, INT16_MAX, compacto);
+  }
+  for (int p = 0; p <= num_processos; p++) {
+    b->fronteiras[p] = b->novas[p];
+  }
+}
+
+/**
+ * @brief Fecha uma janela de medição a cada BALANCEAMENTO_JANELA iterações: o processo
+ * 0 reúne os tempos de cálculo, decide as novas fronteiras e as distribui, e os pontos
+ * migram se elas mudaram. O tempo gasto aqui entra na medição do algoritmo.
+ * @return 1 se houve migração (buffers dimensionados pelos pontos locais devem ser refeitos).
+ */
+static inline int balanceamento_verificar(Balanceamento* b, ConjuntoPontos* pontos, PontosCompactos* compacto,
+                                          MPI_Datatype tipo_ponto) {
+  if (b->iteracoes_janela < BALANCEAMENTO_JANELA) return 0;
+  const int num_processos = b->num_processos;
+  const double inicio = MPI_Wtime();
+  MPI_Gather(&b->calculo_janela, 1, MPI_DOUBLE, b->tempos, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  b->calculo_janela = 0.0;
+  b->iteracoes_janela = 0;
+  int mudou = b->processo == 0 ? balanceamento_planejar(b) : 0;
+  MPI_Bcast(&mudou, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  if (mudou) {
+    MPI_Bcast(b->novas, num_processos + 1, MPI_INT, 0, MPI_COMM_WORLD);
+    balanceamento_migrar(b, pontos, compacto, tipo_ponto);
+    b->rebalanceamentos++;
+    b->descartar = 1;
+  }
+  b->migracao_total += MPI_Wtime() - inicio;
+  return mudou;
+}
+
+/**
+ * @brief Reúne no processo 0 e imprime em stderr, por processo, os pontos finais e os
+ * tempos de cálculo, espera e balanceamento.
+ */
+static inline void balanceamento_relatar(const Balanceamento* b) {
+  const int processo = b->processo, num_processos = b->num_processos;
+  const int pontos = b->fronteiras[processo + 1] - b->fronteiras[processo];
+  double local[5] = {(double)pontos, b->calculo_total, b->espera_total, b->migracao_total, (double)b->recebidos};
+  double* todos = processo == 0 ? (double*)malloc(5 * num_processos * sizeof(double)) : NULL;
+  MPI_Gather(local, 5, MPI_DOUBLE, todos, 5, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  if (processo != 0) return;
+  long long migrados = 0;
+  for (int p = 0; p < num_processos; p++) {
+    migrados += (long long)todos[5 * p + 4];
+  }
+  fprintf(stderr, "Balanceamento: %d rebalanceamento(s), %lld pontos migrados\n", b->rebalanceamentos, migrados);
+  for (int p = 0; p < num_processos; p++) {
+    const double* t = &todos[5 * p];
+    const double total = t[1] + t[2] + t[3];
+    fprintf(stderr, "Processo %d: %d pontos, cálculo %.3f s, espera %.3f s (%.1f%%), balanceamento %.3f s\n", p,
+            (int)t[0], t[1], t[2], total > 0.0 ? 100.0 * t[2] / total : 0.0, t[3]);
+  }
+  free(todos);
+}
+
+#endif
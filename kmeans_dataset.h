@@ -0,0 +1,498 @@
+#ifndef KMEANS_DATASET_H
+#define KMEANS_DATASET_H
+
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Formato binário de dataset (.bin), na ordem de bytes nativa (little-endian em x86).
+//
+//   [0, 64)     CabecalhoDataset
+//   [64, 4096)  zeros
+//   [4096, ...) num_pontos * num_dimensoes coordenadas do tipo indicado, ponto a ponto
+//
+// Os dados começam em um limite de página, então o arquivo pode ser mapeado com
+// mmap e usado diretamente como vetor de coordenadas, sem nenhuma conversão.
+// O checksum (FNV-1a de 64 bits sobre os bytes dos dados) é opcional e só é
+// conferido sob demanda (conversor_dataset --verificar), nunca no carregamento. A faixa
+// de valores do cabeçalho decide o armazenamento compacto; para não percorrer o arquivo
+// na abertura, ela é conferida na própria conversão para int16 (simd_compactar), que
+// rejeita o arquivo se algum valor ficar fora da faixa declarada. A versão MPI usa a
+// faixa medida sobre os pontos recebidos por cada processo.
+
+#define DATASET_MAGICA "KMEANSBN"
+#define DATASET_VERSAO 1
+#define DATASET_OFFSET_DADOS 4096
+#define DATASET_TIPO_INT32 1
+#define DATASET_FLAG_CHECKSUM 1u
+
+typedef struct {
+  char magica[8];           // DATASET_MAGICA, sem terminador
+  uint32_t versao;          // DATASET_VERSAO
+  uint32_t tipo;            // Tipo das coordenadas (DATASET_TIPO_*)
+  uint64_t num_pontos;
+  uint32_t num_dimensoes;
+  int32_t min_val;          // Menor coordenada do arquivo
+  int32_t max_val;          // Maior coordenada do arquivo
+  uint32_t flags;           // DATASET_FLAG_*
+  uint64_t checksum;        // FNV-1a dos dados, válido se DATASET_FLAG_CHECKSUM
+  uint64_t offset_dados;    // Sempre DATASET_OFFSET_DADOS nesta versão
+  uint8_t reservado[8];
+} CabecalhoDataset;
+
+_Static_assert(sizeof(CabecalhoDataset) == 64, "CabecalhoDataset deve ocupar 64 bytes");
+
+// Dataset binário mapeado em memória
+typedef struct {
+  int* coords;         // Primeira coordenada (dentro do mapeamento)
+  void* mapa;          // Início do mapeamento
+  size_t tamanho_mapa;
+  CabecalhoDataset cabecalho;
+} DatasetBinario;
+
+#define DATASET_FNV_INICIAL 1469598103934665603ULL
+
+static inline uint64_t dataset_checksum_atualizar(uint64_t hash, const void* dados, size_t bytes) {
+  const unsigned char* p = (const unsigned char*)dados;
+  for (size_t i = 0; i < bytes; i++) {
+    hash ^= p[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+static inline void dataset_cabecalho_preencher(CabecalhoDataset* cab, uint64_t num_pontos, uint32_t num_dimensoes,
+                                               int32_t min_val, int32_t max_val, int com_checksum, uint64_t checksum) {
+  memset(cab, 0, sizeof(*cab));
+  memcpy(cab->magica, DATASET_MAGICA, 8);
+  cab->versao = DATASET_VERSAO;
+  cab->tipo = DATASET_TIPO_INT32;
+  cab->num_pontos = num_pontos;
+  cab->num_dimensoes = num_dimensoes;
+  cab->min_val = min_val;
+  cab->max_val = max_val;
+  cab->flags = com_checksum ? DATASET_FLAG_CHECKSUM : 0;
+  cab->checksum = checksum;
+  cab->offset_dados = DATASET_OFFSET_DADOS;
+}
+
+/**
+ * @brief Escreve o cabeçalho e o preenchimento até o início dos dados na posição 0 do arquivo.
+ * @return 0 em caso de sucesso, -1 em caso de erro de escrita.
+ */
+static inline int dataset_escrever_cabecalho(FILE* file, const CabecalhoDataset* cab) {
+  static const unsigned char zeros[DATASET_OFFSET_DADOS - sizeof(CabecalhoDataset)];
+  if (fseek(file, 0, SEEK_SET) != 0) return -1;
+  if (fwrite(cab, sizeof(*cab), 1, file) != 1) return -1;
+  if (fwrite(zeros, sizeof(zeros), 1, file) != 1) return -1;
+  return 0;
+}
+
+/**
+ * @brief Lê e valida o cabeçalho de um arquivo aberto.
+ * @return 1 se for um dataset binário válido, 0 se não for (ex.: arquivo de texto).
+ */
+static inline int dataset_ler_cabecalho(int fd, CabecalhoDataset* cab) {
+  if (lseek(fd, 0, SEEK_SET) != 0 || read(fd, cab, sizeof(*cab)) != (ssize_t)sizeof(*cab)) return 0;
+  return memcmp(cab->magica, DATASET_MAGICA, 8) == 0;
+}
+
+/**
+ * @brief Confere se o dataset binário aberto em 'fd', com cabeçalho já lido em 'cab',
+ * tem a versão suportada e ao menos 'num_pontos' pontos com 'num_dimensoes' dimensões.
+ * Encerra o programa caso contrário.
+ */
+static inline void dataset_binario_validar(int fd, const char* filename, int num_pontos, int num_dimensoes,
+                                           const CabecalhoDataset* cab) {
+  if (cab->versao != DATASET_VERSAO || cab->tipo != DATASET_TIPO_INT32 || cab->offset_dados != DATASET_OFFSET_DADOS) {
+    fprintf(stderr, "Erro: '%s' usa uma versão ou tipo de dados não suportado.\n", filename);
+    exit(EXIT_FAILURE);
+  }
+  if ((int)cab->num_dimensoes != num_dimensoes || cab->num_pontos < (uint64_t)num_pontos) {
+    fprintf(stderr, "Erro: '%s' contém %llu pontos com %u dimensões, mas foram pedidos %d pontos com %d dimensões.\n",
+            filename, (unsigned long long)cab->num_pontos, cab->num_dimensoes, num_pontos, num_dimensoes);
+    exit(EXIT_FAILURE);
+  }
+  size_t bytes_dados = (size_t)num_pontos * num_dimensoes * sizeof(int);
+  struct stat info;
+  if (fstat(fd, &info) != 0 || (size_t)info.st_size < DATASET_OFFSET_DADOS + bytes_dados) {
+    fprintf(stderr, "Erro: '%s' está truncado.\n", filename);
+    exit(EXIT_FAILURE);
+  }
+}
+
+/**
+ * @brief Mapeia um dataset binário em memória. Se o arquivo não começar com a assinatura
+ * do formato binário, retorna 0 sem alterar nada e o chamador deve usar o leitor de texto.
+ * Erros de um arquivo binário inválido ou incompatível encerram o programa.
+ * @return 1 se o arquivo foi mapeado, 0 se não é um dataset binário.
+ */
+static inline int dataset_binario_abrir(const char* filename, int num_pontos, int num_dimensoes, DatasetBinario* ds) {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "Erro: Não foi possível abrir o arquivo '%s'\n", filename);
+    exit(EXIT_FAILURE);
+  }
+  if (!dataset_ler_cabecalho(fd, &ds->cabecalho)) {
+    close(fd);
+    return 0;
+  }
+
+  dataset_binario_validar(fd, filename, num_pontos, num_dimensoes, &ds->cabecalho);
+  size_t bytes_dados = (size_t)num_pontos * num_dimensoes * sizeof(int);
+
+  // Só os pontos pedidos são mapeados. MAP_POPULATE (quando disponível) já resolve
+  // as faltas de página aqui, fora da região medida.
+  int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+  flags |= MAP_POPULATE;
+#endif
+  ds->tamanho_mapa = DATASET_OFFSET_DADOS + bytes_dados;
+  ds->mapa = mmap(NULL, ds->tamanho_mapa, PROT_READ, flags, fd, 0);
+  close(fd);
+  if (ds->mapa == MAP_FAILED) {
+    perror("Erro ao mapear o dataset");
+    exit(EXIT_FAILURE);
+  }
+  ds->coords = (int*)((char*)ds->mapa + DATASET_OFFSET_DADOS);
+
+#ifndef MAP_POPULATE
+  volatile int toque = 0;
+  long pagina = sysconf(_SC_PAGESIZE);
+  for (size_t b = 0; b < bytes_dados; b += pagina) {
+    toque += *(volatile const int*)((const char*)ds->coords + b);
+  }
+  (void)toque;
+#endif
+  return 1;
+}
+
+static inline void dataset_binario_fechar(DatasetBinario* ds) {
+  munmap(ds->mapa, ds->tamanho_mapa);
+}
+
+
+// --- Leitura paralela do formato de texto ---
+//
+// O arquivo de texto (um ponto por linha, coordenadas separadas por espaços) é
+// mapeado em memória e dividido em blocos que terminam em quebras de linha, um por
+// thread. Uma primeira passada conta as linhas e os pontos de cada bloco, o que
+// permite calcular por soma de prefixos em que linha do arquivo e em que ponto do
+// vetor de coordenadas cada bloco começa. A segunda passada converte os inteiros
+// com um laço de dígitos escrito à mão direto no vetor de coordenadas.
+// Linhas em branco são ignoradas.
+
+typedef struct {
+  const char* inicio;         // Início do bloco (sempre no começo de uma linha)
+  const char* fim;            // Fim do bloco (logo após uma quebra de linha, ou fim do arquivo)
+  long long num_linhas;       // Linhas do bloco (1a passada)
+  long long num_pontos;       // Linhas não vazias do bloco (1a passada)
+  long long primeira_linha;   // Número (a partir de 1) da primeira linha do bloco no arquivo
+  long long primeiro_ponto;   // Índice do primeiro ponto do bloco
+  int* coords;                // Vetor de destino (num_pontos_total x num_dimensoes)
+  long long num_pontos_total; // Pontos pedidos; os excedentes do arquivo são ignorados
+  int num_dimensoes;
+  int min_val, max_val;       // Faixa dos valores convertidos pelo bloco
+  long long linha_erro;       // 0 se não houve erro
+  char msg_erro[128];
+} BlocoTexto;
+
+static inline void* texto_contar_bloco(void* arg) {
+  BlocoTexto* b = (BlocoTexto*)arg;
+  b->num_linhas = 0;
+  b->num_pontos = 0;
+  int vazia = 1;
+  for (const char* p = b->inicio; p < b->fim; p++) {
+    if (*p == '\n') {
+      b->num_linhas++;
+      b->num_pontos += !vazia;
+      vazia = 1;
+    } else if (*p != ' ' && *p != '\t' && *p != '\r') {
+      vazia = 0;
+    }
+  }
+  if (!vazia) {  // Última linha sem quebra de linha
+    b->num_linhas++;
+    b->num_pontos++;
+  }
+  return NULL;
+}
+
+static inline void* texto_converter_bloco(void* arg) {
+  BlocoTexto* b = (BlocoTexto*)arg;
+  const char* p = b->inicio;
+  const char* fim = b->fim;
+  const int D = b->num_dimensoes;
+  long long linha = b->primeira_linha;
+  long long ponto = b->primeiro_ponto;
+  int min_val = INT_MAX, max_val = INT_MIN;
+  b->linha_erro = 0;
+
+  while (p < fim && ponto < b->num_pontos_total) {
+    int* destino = &b->coords[ponto * D];
+    int lidos = 0;
+    for (;;) {
+      while (p < fim && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+      if (p == fim || *p == '\n') break;
+      if (lidos == D) {
+        b->linha_erro = linha;
+        snprintf(b->msg_erro, sizeof(b->msg_erro), "mais de %d valores na linha", D);
+        return NULL;
+      }
+      int negativo = 0;
+      if (*p == '-' || *p == '+') {
+        negativo = *p == '-';
+        p++;
+      }
+      if (p == fim || *p < '0' || *p > '9') {
+        b->linha_erro = linha;
+        snprintf(b->msg_erro, sizeof(b->msg_erro), "valor %d não é um inteiro", lidos + 1);
+        return NULL;
+      }
+      long long valor = 0;
+      while (p < fim && *p >= '0' && *p <= '9') {
+        valor = valor * 10 + (*p - '0');
+        if (valor > (long long)INT_MAX + 1) {
+          b->linha_erro = linha;
+          snprintf(b->msg_erro, sizeof(b->msg_erro), "valor %d fora da faixa de int", lidos + 1);
+          return NULL;
+        }
+        p++;
+      }
+      if (p < fim && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+        b->linha_erro = linha;
+        snprintf(b->msg_erro, sizeof(b->msg_erro), "caractere inválido '%c' no valor %d", *p, lidos + 1);
+        return NULL;
+      }
+      if (negativo) valor = -valor;
+      if (valor > INT_MAX) {
+        b->linha_erro = linha;
+        snprintf(b->msg_erro, sizeof(b->msg_erro), "valor %d fora da faixa de int", lidos + 1);
+        return NULL;
+      }
+      destino[lidos++] = (int)valor;
+      if (valor < min_val) min_val = (int)valor;
+      if (valor > max_val) max_val = (int)valor;
+    }
+    if (lidos > 0 && lidos < D) {
+      b->linha_erro = linha;
+      snprintf(b->msg_erro, sizeof(b->msg_erro), "esperados %d valores, encontrados %d", D, lidos);
+      return NULL;
+    }
+    ponto += lidos > 0;
+    if (p < fim) p++;  // Quebra de linha
+    linha++;
+  }
+  b->min_val = min_val;
+  b->max_val = max_val;
+  return NULL;
+}
+
+/**
+ * @brief Executa 'funcao' sobre cada bloco, um por thread (a thread atual processa o bloco 0).
+ */
+static inline void texto_executar_blocos(void* (*funcao)(void*), BlocoTexto* blocos, int num_blocos) {
+  pthread_t* threads = (pthread_t*)malloc(num_blocos * sizeof(pthread_t));
+  int* criada = (int*)calloc(num_blocos, sizeof(int));
+  if (threads == NULL || criada == NULL) {
+    // Sem memória para as threads, todos os blocos são processados aqui mesmo
+    for (int t = 0; t < num_blocos; t++) funcao(&blocos[t]);
+    free(threads);
+    free(criada);
+    return;
+  }
+  for (int t = 1; t < num_blocos; t++) {
+    criada[t] = pthread_create(&threads[t], NULL, funcao, &blocos[t]) == 0;
+    if (!criada[t]) funcao(&blocos[t]);  // Sem threads disponíveis, processa aqui mesmo
+  }
+  funcao(&blocos[0]);
+  for (int t = 1; t < num_blocos; t++) {
+    if (criada[t]) pthread_join(threads[t], NULL);
+  }
+  free(threads);
+  free(criada);
+}
+
+/**
+ * @brief Lê os num_pontos primeiros pontos de um dataset de texto para 'coords'
+ * (num_pontos x num_dimensoes) usando 'num_threads' threads (0 = uma por CPU).
+ * Também devolve a faixa de valores lidos. Erros de formato são informados com o
+ * número da linha e encerram o programa.
+ */
+static inline void dataset_texto_ler(const char* filename, int* coords, int num_pontos, int num_dimensoes,
+                                     int num_threads, int* min_val, int* max_val) {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "Erro: Não foi possível abrir o arquivo '%s'\n", filename);
+    exit(EXIT_FAILURE);
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    fprintf(stderr, "Erro: Arquivo de dados mal formatado ou incompleto.\n");
+    exit(EXIT_FAILURE);
+  }
+  size_t tamanho = (size_t)info.st_size;
+  const char* texto = (const char*)mmap(NULL, tamanho, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (texto == MAP_FAILED) {
+    perror("Erro ao mapear o dataset");
+    exit(EXIT_FAILURE);
+  }
+
+  if (num_threads <= 0) num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (num_threads <= 0) num_threads = 1;
+  // Blocos muito pequenos não compensam o custo de criar as threads
+  const size_t min_bloco = 1 << 20;
+  if ((size_t)num_threads > tamanho / min_bloco) num_threads = (int)(tamanho / min_bloco) + 1;
+
+  BlocoTexto* blocos = (BlocoTexto*)calloc(num_threads, sizeof(BlocoTexto));
+  const char* fim_texto = texto + tamanho;
+  const char* inicio = texto;
+  for (int t = 0; t < num_threads; t++) {
+    const char* fim = t == num_threads - 1 ? fim_texto : texto + tamanho / num_threads * (t + 1);
+    if (fim < inicio) fim = inicio;
+    while (fim < fim_texto && fim > texto && fim[-1] != '\n') fim++;
+    blocos[t].inicio = inicio;
+    blocos[t].fim = fim;
+    blocos[t].coords = coords;
+    blocos[t].num_pontos_total = num_pontos;
+    blocos[t].num_dimensoes = num_dimensoes;
+    inicio = fim;
+  }
+
+  texto_executar_blocos(texto_contar_bloco, blocos, num_threads);
+  long long linha = 1, ponto = 0;
+  for (int t = 0; t < num_threads; t++) {
+    blocos[t].primeira_linha = linha;
+    blocos[t].primeiro_ponto = ponto;
+    linha += blocos[t].num_linhas;
+    ponto += blocos[t].num_pontos;
+  }
+  if (ponto < num_pontos) {
+    fprintf(stderr, "Erro: Arquivo de dados incompleto: '%s' tem %lld pontos, mas foram pedidos %d.\n", filename,
+            ponto, num_pontos);
+    exit(EXIT_FAILURE);
+  }
+
+  texto_executar_blocos(texto_converter_bloco, blocos, num_threads);
+  *min_val = INT_MAX;
+  *max_val = INT_MIN;
+  for (int t = 0; t < num_threads; t++) {
+    // Blocos em ordem: o primeiro erro encontrado é o de menor número de linha
+    if (blocos[t].linha_erro != 0) {
+      fprintf(stderr, "Erro: Arquivo de dados mal formatado: '%s', linha %lld: %s.\n", filename,
+              blocos[t].linha_erro, blocos[t].msg_erro);
+      exit(EXIT_FAILURE);
+    }
+    if (blocos[t].primeiro_ponto < num_pontos) {
+      if (blocos[t].min_val < *min_val) *min_val = blocos[t].min_val;
+      if (blocos[t].max_val > *max_val) *max_val = blocos[t].max_val;
+    }
+  }
+
+  free(blocos);
+  munmap((void*)texto, tamanho);
+}
+
+// --- Conjunto de pontos em memória ---
+//
+// Estrutura de arrays usada por todas as versões: as coordenadas ficam em uma única
+// matriz contígua linha-major ([i * D + d], alinhada em 64 bytes quando alocada aqui,
+// ou o próprio mapeamento de um dataset binário) e o cluster de cada ponto em um
+// vetor int32 denso separado. Opcionalmente é mantida uma cópia dimensão-major
+// ([d * num_pontos + i], opção --layout=colunas), em que a mesma coordenada de
+// pontos consecutivos é contígua e os kernels vetorizam sobre os pontos.
+
+#define PONTOS_ALINHAMENTO 64
+
+typedef struct {
+  int num_pontos;
+  int num_dimensoes;
+  int* coords;       // Linha-major [i * D + d]
+  int32_t* rotulos;  // Cluster de cada ponto; -1 antes da primeira atribuição
+  int* colunas;      // Dimensão-major [d * num_pontos + i], ou NULL
+  int coords_proprias;  // 1 se 'coords' foi alocado por pontos_iniciar
+} ConjuntoPontos;
+
+static inline void* pontos_alocar(size_t bytes) {
+  size_t tamanho = (bytes + PONTOS_ALINHAMENTO - 1) / PONTOS_ALINHAMENTO * PONTOS_ALINHAMENTO;
+  void* ptr = aligned_alloc(PONTOS_ALINHAMENTO, tamanho > 0 ? tamanho : PONTOS_ALINHAMENTO);
+  if (ptr == NULL) {
+    fprintf(stderr, "Erro: falha ao alocar os pontos.\n");
+    exit(EXIT_FAILURE);
+  }
+  return ptr;
+}
+
+/**
+ * @brief Inicializa um conjunto de 'num_pontos' pontos. Se 'coords' for NULL a matriz
+ * de coordenadas é alocada (alinhada); caso contrário o conjunto usa 'coords' sem
+ * copiar (por exemplo, o mapeamento de um dataset binário). Os rótulos começam em -1.
+ */
+static inline void pontos_iniciar(ConjuntoPontos* p, int num_pontos, int num_dimensoes, int* coords) {
+  p->num_pontos = num_pontos;
+  p->num_dimensoes = num_dimensoes;
+  p->coords_proprias = coords == NULL;
+  p->coords = coords != NULL ? coords : (int*)pontos_alocar((size_t)num_pontos * num_dimensoes * sizeof(int));
+  p->rotulos = (int32_t*)pontos_alocar((size_t)num_pontos * sizeof(int32_t));
+  p->colunas = NULL;
+  for (int i = 0; i < num_pontos; i++) {
+    p->rotulos[i] = -1;
+  }
+}
+
+static inline void pontos_liberar(ConjuntoPontos* p) {
+  if (p->coords_proprias) free(p->coords);
+  free(p->rotulos);
+  free(p->colunas);
+}
+
+/**
+ * @brief Coordenadas do ponto i.
+ */
+static inline int* pontos_ponto(const ConjuntoPontos* p, int i) {
+  return &p->coords[(size_t)i * p->num_dimensoes];
+}
+
+/**
+ * @brief Gera a cópia dimensão-major das coordenadas (p->colunas).
+ */
+static inline void pontos_gerar_colunas(ConjuntoPontos* p) {
+  const int M = p->num_pontos, D = p->num_dimensoes;
+  p->colunas = (int*)pontos_alocar((size_t)M * D * sizeof(int));
+  for (int i = 0; i < M; i++) {
+    for (int d = 0; d < D; d++) {
+      p->colunas[(size_t)d * M + i] = p->coords[(size_t)i * D + d];
+    }
+  }
+}
+
+/**
+ * @brief Carrega os 'num_pontos' primeiros pontos de 'filename' em 'p': um dataset
+ * binário é mapeado (e 'binario' deve ser fechado com dataset_binario_fechar depois de
+ * pontos_liberar); um de texto é lido com 'num_threads' threads para uma matriz alocada.
+ * Também devolve a faixa de valores dos dados; a de um binário é a do cabeçalho, lida
+ * sem tocar nos pontos mapeados (ver o comentário do formato).
+ * @return 1 se o arquivo é binário, 0 se é de texto.
+ */
+static inline int pontos_carregar(const char* filename, int num_pontos, int num_dimensoes, int num_threads,
+                                  ConjuntoPontos* p, DatasetBinario* binario, int* min_val, int* max_val) {
+  if (dataset_binario_abrir(filename, num_pontos, num_dimensoes, binario)) {
+    pontos_iniciar(p, num_pontos, num_dimensoes, binario->coords);
+    *min_val = binario->cabecalho.min_val;
+    *max_val = binario->cabecalho.max_val;
+    return 1;
+  }
+  pontos_iniciar(p, num_pontos, num_dimensoes, NULL);
+  dataset_texto_ler(filename, p->coords, num_pontos, num_dimensoes, num_threads, min_val, max_val);
+  return 0;
+}
+
+#endif
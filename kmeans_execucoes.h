@@ -0,0 +1,229 @@
+#ifndef KMEANS_EXECUCOES_H
+#define KMEANS_EXECUCOES_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kmeans_dataset.h"
+#include "kmeans_simd.h"
+
+// Várias execuções do K-Means com sementes diferentes avançadas juntas (opção --execucoes=R).
+//
+// Cada execução tem seus centroides, rótulos e acumuladores, mas a passada sobre os
+// pontos é uma só: eles são percorridos em blocos de EXECUCOES_BLOCO pontos, e cada
+// bloco, enquanto está no cache, é atribuído e somado para as R execuções, cada uma
+// com uma réplica do kernel de atribuição (mesmos modos compacto e blocado). Assim
+// os pontos saem da memória uma vez por iteração, e não R vezes.
+//
+// A execução r parte da semente 42 + r (sorteio da versão de referência) ou, com
+// --inicializacao=paralela, de --semente + r; a execução 0 é a execução normal. Com
+// --convergencia cada execução para quando converge, e as demais continuam. No fim,
+// a inércia de cada execução é calculada e a de menor inércia é a vencedora.
+
+#define EXECUCOES_BLOCO 1024  // Pontos de cada bloco atribuído para todas as execuções
+
+typedef struct {
+  int num_execucoes;
+  int num_pontos;
+  int num_clusters;
+  int num_dimensoes;
+  int* centroides;            // [r * K * D + k * D + d]
+  KernelAtribuicao* kernels;  // Um por execução
+  int32_t* rotulos;           // [r * M + i]
+  long long* somas;           // [r * K * D + k * D + d]
+  int* contagens;             // [r * K + k]
+  long long* mudancas;        // Pontos que mudaram de cluster na iteração, por execução
+  int* ativa;                 // 0 depois que a execução convergiu
+  int* iteracoes;             // Iterações executadas por cada execução
+  long long* inercias;        // Somas exatas das distâncias ao quadrado, por execução
+} ExecucoesMultiplas;
+
+/**
+ * @brief Aloca 'num_execucoes' execuções. Os kernels são criados depois, por
+ * execucoes_replicar, quando o kernel principal já está configurado.
+ */
+static inline void execucoes_iniciar(ExecucoesMultiplas* e, int num_execucoes, int num_pontos, int num_clusters,
+                                     int num_dimensoes) {
+  const size_t R = num_execucoes, K = num_clusters, D = num_dimensoes;
+  e->num_execucoes = num_execucoes;
+  e->num_pontos = num_pontos;
+  e->num_clusters = num_clusters;
+  e->num_dimensoes = num_dimensoes;
+  e->centroides = (int*)malloc(R * K * D * sizeof(int));
+  e->kernels = (KernelAtribuicao*)malloc(R * sizeof(KernelAtribuicao));
+  e->rotulos = (int32_t*)malloc(R * num_pontos * sizeof(int32_t));
+  e->somas = (long long*)malloc(R * K * D * sizeof(long long));
+  e->contagens = (int*)malloc(R * K * sizeof(int));
+  e->mudancas = (long long*)malloc(R * sizeof(long long));
+  e->ativa = (int*)malloc(R * sizeof(int));
+  e->iteracoes = (int*)calloc(R, sizeof(int));
+  e->inercias = (long long*)calloc(R, sizeof(long long));
+  if (e->centroides == NULL || e->kernels == NULL || e->rotulos == NULL || e->somas == NULL ||
+      e->contagens == NULL || e->mudancas == NULL || e->ativa == NULL || e->iteracoes == NULL ||
+      e->inercias == NULL) {
+    fprintf(stderr, "Erro: falha ao alocar as execuções múltiplas.\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t r = 0; r < R; r++) {
+    e->ativa[r] = 1;
+  }
+  for (size_t i = 0; i < R * num_pontos; i++) {
+    e->rotulos[i] = -1;
+  }
+}
+
+/**
+ * @brief Cria o kernel de cada execução como réplica de 'modelo' (mesmo conjunto de
+ * instruções e modos compacto e blocado).
+ */
+static inline void execucoes_replicar(ExecucoesMultiplas* e, const KernelAtribuicao* modelo) {
+  for (int r = 0; r < e->num_execucoes; r++) {
+    kernel_replicar(&e->kernels[r], modelo);
+  }
+}
+
+static inline void execucoes_liberar(ExecucoesMultiplas* e) {
+  for (int r = 0; r < e->num_execucoes; r++) {
+    kernel_liberar(&e->kernels[r]);
+  }
+  free(e->kernels);
+  free(e->centroides);
+  free(e->rotulos);
+  free(e->somas);
+  free(e->contagens);
+  free(e->mudancas);
+  free(e->ativa);
+  free(e->iteracoes);
+  free(e->inercias);
+}
+
+static inline int* execucoes_centroides(const ExecucoesMultiplas* e, int r) {
+  return &e->centroides[(size_t)r * e->num_clusters * e->num_dimensoes];
+}
+
+/**
+ * @brief Sorteia os centroides iniciais da execução 'r' como initialize_centroids, com
+ * srand(semente) no lugar da semente fixa.
+ */
+static inline void execucoes_sortear_centroides(ExecucoesMultiplas* e, int r, const ConjuntoPontos* points,
+                                                unsigned int semente) {
+  const int M = e->num_pontos, D = e->num_dimensoes;
+  srand(semente);
+  int* indices = (int*)malloc(M * sizeof(int));
+  if (indices == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int i = 0; i < M; i++) {
+    indices[i] = i;
+  }
+  for (int i = 0; i < M; i++) {
+    int j = rand() % M;
+    int temp = indices[i];
+    indices[i] = indices[j];
+    indices[j] = temp;
+  }
+  int* centroides = execucoes_centroides(e, r);
+  for (int k = 0; k < e->num_clusters; k++) {
+    memcpy(&centroides[(size_t)k * D], pontos_ponto(points, indices[k]), D * sizeof(int));
+  }
+  free(indices);
+}
+
+/**
+ * @brief Carrega os centroides de cada execução no seu kernel: só das ativas no início
+ * de uma iteração ('todas' = 0), ou de todas antes do cálculo da inércia.
+ */
+static inline void execucoes_carregar(ExecucoesMultiplas* e, int todas) {
+  for (int r = 0; r < e->num_execucoes; r++) {
+    if (todas || e->ativa[r]) kernel_carregar_centroides(&e->kernels[r], execucoes_centroides(e, r));
+  }
+}
+
+/**
+ * @brief Atribui os pontos [inicio, fim) para cada execução ativa e os acumula em
+ * 'somas' e 'contagens' (no layout de e->somas e e->contagens). Em 'mudancas' é somado,
+ * por execução, o número de pontos que mudaram de cluster. No modo compacto os pontos
+ * são lidos da cópia em int16.
+ */
+static inline void execucoes_bloco(const ExecucoesMultiplas* e, const ConjuntoPontos* points,
+                                   const PontosCompactos* compacto, int inicio, int fim, long long* somas,
+                                   int* contagens, long long* mudancas) {
+  const int K = e->num_clusters, D = e->num_dimensoes;
+  for (int r = 0; r < e->num_execucoes; r++) {
+    if (!e->ativa[r]) continue;
+    const KernelAtribuicao* kernel = &e->kernels[r];
+    int32_t* rotulos = &e->rotulos[(size_t)r * e->num_pontos];
+    long long* soma = &somas[(size_t)r * K * D];
+    int* contagem = &contagens[(size_t)r * K];
+    long long mudados = 0;
+    if (compacto->coords != NULL) {
+      if (kernel->coords_b != NULL) {
+        mudados += kernel_atribuir_blocado(kernel, compacto->coords, inicio, fim, rotulos);
+      }
+      for (int i = inicio; i < fim; i++) {
+        const int16_t* ponto = &compacto->coords[(size_t)i * compacto->largura];
+        if (kernel->coords_b == NULL) {
+          int cluster_id = kernel_mais_proximo_compacto(kernel, ponto);
+          mudados += cluster_id != rotulos[i];
+          rotulos[i] = cluster_id;
+        }
+        contagem[rotulos[i]]++;
+        kernel_somar_compacto(&soma[(size_t)rotulos[i] * D], ponto, D);
+      }
+    } else {
+      for (int i = inicio; i < fim; i++) {
+        const int* ponto = pontos_ponto(points, i);
+        int cluster_id = kernel_mais_proximo(kernel, ponto);
+        mudados += cluster_id != rotulos[i];
+        rotulos[i] = cluster_id;
+        contagem[cluster_id]++;
+        kernel_somar(&soma[(size_t)cluster_id * D], ponto, D);
+      }
+    }
+    mudancas[r] += mudados;
+  }
+}
+
+/**
+ * @brief Soma em 'inercias' (uma posição por execução) a inércia dos pontos
+ * [inicio, fim), com os centroides de todas as execuções já carregados nos kernels.
+ * As somas são inteiras, então não dependem da ordem dos blocos.
+ */
+static inline void execucoes_inercia_bloco(const ExecucoesMultiplas* e, const ConjuntoPontos* points, int inicio,
+                                           int fim, long long* inercias) {
+  for (int r = 0; r < e->num_execucoes; r++) {
+    const KernelAtribuicao* kernel = &e->kernels[r];
+    long long inercia = 0;
+    for (int i = inicio; i < fim; i++) {
+      const int* ponto = pontos_ponto(points, i);
+      inercia += kernel_distancia(kernel, ponto, kernel_mais_proximo(kernel, ponto));
+    }
+    inercias[r] += inercia;
+  }
+}
+
+/**
+ * @brief Índice da execução de menor inércia (a primeira, em caso de empate).
+ */
+static inline int execucoes_melhor(const ExecucoesMultiplas* e) {
+  int melhor = 0;
+  for (int r = 1; r < e->num_execucoes; r++) {
+    if (e->inercias[r] < e->inercias[melhor]) melhor = r;
+  }
+  return melhor;
+}
+
+/**
+ * @brief Imprime em stderr a inércia e as iterações de cada execução e a vencedora.
+ */
+static inline void execucoes_relatar(const ExecucoesMultiplas* e, int melhor) {
+  for (int r = 0; r < e->num_execucoes; r++) {
+    fprintf(stderr, "Execução %d: inércia %.6e em %d iterações%s\n", r, (double)e->inercias[r], e->iteracoes[r],
+            r == melhor ? " (vencedora)" : "");
+  }
+}
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef KMEANS_HAMERLY_H
+#define KMEANS_HAMERLY_H
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kmeans_simd.h"
+
+// Atribuição acelerada pela desigualdade triangular (algoritmo de Hamerly).
+//
+// Para cada ponto são mantidos um limite superior u (distância até o centroide
+// atual) e um limite inferior l (distância até o segundo centroide mais próximo).
+// Depois de cada atualização, u cresce com o deslocamento do próprio centroide e
+// l diminui com o maior deslocamento entre os demais. Se u < max(l, s[a]), onde
+// s[a] é metade da distância do centroide a até o centroide mais próximo dele,
+// nenhum outro centroide pode estar a uma distância menor ou igual, e o ponto
+// mantém o cluster sem calcular nenhuma distância.
+//
+// As comparações de poda são estritas e descontam uma folga proporcional à maior
+// distância possível nos dados, cobrindo o erro de arredondamento dos limites em
+// double. Quando a poda falha, as distâncias são calculadas exatamente em inteiros
+// pelo kernel de atribuição, então o resultado é idêntico ao do Lloyd.
+
+#define HAMERLY_FOLGA 1e-10  // Folga relativa à maior distância possível nos dados
+
+typedef struct {
+  int num_pontos;
+  int num_clusters;
+  int num_dimensoes;
+  int iniciado;              // 0 até a primeira atribuição completa
+  double folga;              // Margem absoluta aplicada às comparações de poda
+  double* superior;          // u[i]
+  double* inferior;          // l[i]
+  int* centroides_anteriores;  // Centroides da iteração anterior [k * D + d]
+  double* deslocamento;      // Quanto cada centroide se moveu na última atualização
+  double* meia_separacao;    // s[k]: metade da distância até o centroide mais próximo
+  double maior_desloc;       // Maior deslocamento entre todos os centroides
+  double segundo_desloc;     // Segundo maior deslocamento
+  int cluster_maior_desloc;  // Centroide com o maior deslocamento
+} EstadoHamerly;
+
+static inline void hamerly_iniciar(EstadoHamerly* h, int num_pontos, int num_clusters, int num_dimensoes,
+                                   int min_val, int max_val) {
+  h->num_pontos = num_pontos;
+  h->num_clusters = num_clusters;
+  h->num_dimensoes = num_dimensoes;
+  h->iniciado = 0;
+  double maior_distancia = ((double)max_val - min_val) * sqrt((double)num_dimensoes);
+  h->folga = HAMERLY_FOLGA * (maior_distancia > 1.0 ? maior_distancia : 1.0);
+  h->superior = (double*)malloc((size_t)num_pontos * sizeof(double));
+  h->inferior = (double*)malloc((size_t)num_pontos * sizeof(double));
+  h->centroides_anteriores = (int*)malloc((size_t)num_clusters * num_dimensoes * sizeof(int));
+  h->deslocamento = (double*)calloc(num_clusters, sizeof(double));
+  h->meia_separacao = (double*)calloc(num_clusters, sizeof(double));
+  if ((num_pontos > 0 && (h->superior == NULL || h->inferior == NULL)) || h->centroides_anteriores == NULL ||
+      h->deslocamento == NULL || h->meia_separacao == NULL) {
+    fprintf(stderr, "Erro: falha ao alocar o estado de Hamerly.\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+static inline void hamerly_liberar(EstadoHamerly* h) {
+  free(h->superior);
+  free(h->inferior);
+  free(h->centroides_anteriores);
+  free(h->deslocamento);
+  free(h->meia_separacao);
+}
+
+static inline double hamerly_distancia_centroides(const int* a, const int* b, int num_dimensoes) {
+  long long dist = 0;
+  for (int d = 0; d < num_dimensoes; d++) {
+    long long diff = (long long)a[d] - b[d];
+    dist += diff * diff;
+  }
+  return sqrt((double)dist);
+}
+
+/**
+ * @brief Deve ser chamada uma vez por iteração, depois de kernel_carregar_centroides e
+ * antes de atribuir os pontos. Calcula o deslocamento de cada centroide desde a
+ * iteração anterior e a meia separação s[k] entre os centroides atuais.
+ */
+static inline void hamerly_preparar_iteracao(EstadoHamerly* h, const KernelAtribuicao* kernel) {
+  const int K = h->num_clusters, D = h->num_dimensoes;
+  const int* atuais = kernel->coords;
+
+  h->maior_desloc = 0.0;
+  h->segundo_desloc = 0.0;
+  h->cluster_maior_desloc = -1;
+  for (int k = 0; k < K; k++) {
+    double desloc = h->iniciado ? hamerly_distancia_centroides(&h->centroides_anteriores[(size_t)k * D],
+                                                                &atuais[(size_t)k * D], D)
+                                : 0.0;
+    h->deslocamento[k] = desloc;
+    if (desloc > h->maior_desloc) {
+      h->segundo_desloc = h->maior_desloc;
+      h->maior_desloc = desloc;
+      h->cluster_maior_desloc = k;
+    } else if (desloc > h->segundo_desloc) {
+      h->segundo_desloc = desloc;
+    }
+  }
+  memcpy(h->centroides_anteriores, atuais, (size_t)K * D * sizeof(int));
+
+  for (int k = 0; k < K; k++) {
+    h->meia_separacao[k] = INFINITY;
+  }
+  for (int k = 0; k < K; k++) {
+    for (int j = k + 1; j < K; j++) {
+      double meia = 0.5 * hamerly_distancia_centroides(&atuais[(size_t)k * D], &atuais[(size_t)j * D], D);
+      if (meia < h->meia_separacao[k]) h->meia_separacao[k] = meia;
+      if (meia < h->meia_separacao[j]) h->meia_separacao[j] = meia;
+    }
+  }
+}
+
+/**
+ * @brief Atribui o ponto i, cujo cluster atual é 'atual' (ignorado na primeira iteração).
+ * 'distancias' é um buffer privado da thread com pelo menos num_clusters posições, e
+ * 'avaliacoes' acumula quantas distâncias ponto-centroide foram de fato calculadas.
+ * @return O índice do centroide mais próximo, idêntico ao da atribuição de Lloyd.
+ */
+static inline int hamerly_atribuir_ponto(EstadoHamerly* h, const KernelAtribuicao* kernel, int i, const int* ponto,
+                                         int atual, long long* distancias, long long* avaliacoes) {
+  if (h->iniciado) {
+    double u = h->superior[i] + h->deslocamento[atual];
+    double l = h->inferior[i] - (atual == h->cluster_maior_desloc ? h->segundo_desloc : h->maior_desloc);
+    double limite = l > h->meia_separacao[atual] ? l : h->meia_separacao[atual];
+    h->inferior[i] = l;
+
+    if (u + h->folga < limite) {
+      h->superior[i] = u;
+      return atual;
+    }
+    // Aperta o limite superior com a distância exata e tenta de novo
+    u = sqrt((double)kernel_distancia(kernel, ponto, atual));
+    (*avaliacoes)++;
+    h->superior[i] = u;
+    if (u + h->folga < limite) {
+      return atual;
+    }
+  }
+
+  kernel_distancias(kernel, ponto, distancias);
+  *avaliacoes += h->num_clusters;
+  long long min_dist = LLONG_MAX, segunda_dist = LLONG_MAX;
+  int best_cluster = -1;
+  for (int j = 0; j < h->num_clusters; j++) {
+    if (distancias[j] < min_dist) {
+      segunda_dist = min_dist;
+      min_dist = distancias[j];
+      best_cluster = j;
+    } else if (distancias[j] < segunda_dist) {
+      segunda_dist = distancias[j];
+    }
+  }
+  h->superior[i] = sqrt((double)min_dist);
+  h->inferior[i] = segunda_dist == LLONG_MAX ? INFINITY : sqrt((double)segunda_dist);
+  return best_cluster;
+}
+
+/**
+ * @brief Marca o fim da primeira atribuição completa (a partir daí os limites são válidos).
+ */
+static inline void hamerly_concluir_iteracao(EstadoHamerly* h) {
+  h->iniciado = 1;
+}
+
+#endif
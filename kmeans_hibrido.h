@@ -0,0 +1,178 @@
+#ifndef KMEANS_HIBRIDO_H
+#define KMEANS_HIBRIDO_H
+
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kmeans_dataset.h"
+
+// Modo híbrido da versão MPI (opção --hibrido): memória compartilhada dentro de cada nó.
+//
+// Os processos de um nó (MPI_Comm_split_type com MPI_COMM_TYPE_SHARED) alocam as suas
+// faixas de pontos em uma janela MPI_Win_allocate_shared, contígua na ordem dos ranks.
+// Se os ranks de cada nó são consecutivos (distribuição em bloco do mpirun), o rank 0
+// envia a parte de cada nó inteira para o líder do nó (o processo de menor rank), que a
+// recebe direto na janela; senão cada processo recebe a sua faixa, como na versão normal.
+//
+// Na versão normal cada processo também guarda só a sua faixa, então a janela não
+// economiza memória nos demais processos: o único ganho real é que o rank 0 libera a
+// sua cópia completa dos pontos depois da distribuição.
+//
+// A redução das somas e contagens também é hierárquica: cada processo copia o seu vetor
+// para a sua linha de uma segunda janela compartilhada, os processos do nó somam as
+// linhas dividindo as colunas entre si, e só os líderes (um por nó) participam do
+// MPI_Allreduce entre nós. A sincronização dentro do nó é feita com MPI_Win_sync e
+// MPI_Barrier no comunicador do nó, em uma época passiva aberta uma única vez.
+
+typedef struct {
+  MPI_Comm no;            // Processos do mesmo nó
+  MPI_Comm lideres;       // Um processo por nó (MPI_COMM_NULL nos demais)
+  int processo_no;        // Rank no comunicador do nó (0 = líder)
+  int processos_no;
+  int num_nos;
+  int consecutivos;       // Os ranks de cada nó são consecutivos em MPI_COMM_WORLD
+  MPI_Win janela_pontos;  // Faixas de pontos dos processos do nó
+  MPI_Win janela_reducao;
+  long long* linhas;      // [processo_no * capacidade + x]: vetor de cada processo do nó
+  long long* total;       // Soma das linhas, depois somada entre os nós pelos líderes
+  int capacidade;         // Maior vetor aceito por hibrido_reduzir
+} Hibrido;
+
+/**
+ * @brief Divide MPI_COMM_WORLD por nó, cria o comunicador dos líderes e a janela da
+ * redução, com 'capacidade' posições por processo.
+ */
+static inline void hibrido_iniciar(Hibrido* h, int processo, int capacidade) {
+  MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, processo, MPI_INFO_NULL, &h->no);
+  MPI_Comm_rank(h->no, &h->processo_no);
+  MPI_Comm_size(h->no, &h->processos_no);
+  MPI_Comm_split(MPI_COMM_WORLD, h->processo_no == 0 ? 0 : MPI_UNDEFINED, processo, &h->lideres);
+  int lider = h->processo_no == 0;
+  MPI_Allreduce(&lider, &h->num_nos, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+  // Consecutivos se, em todos os nós, rank - processo_no é o rank do líder
+  int primeiro = processo - h->processo_no, rank_lider = processo;
+  MPI_Bcast(&rank_lider, 1, MPI_INT, 0, h->no);
+  int local = primeiro == rank_lider;
+  MPI_Allreduce(&local, &h->consecutivos, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  // O líder aloca a janela inteira (uma linha por processo do nó e o total)
+  h->capacidade = capacidade;
+  MPI_Aint bytes = h->processo_no == 0 ? (MPI_Aint)(h->processos_no + 1) * capacidade * sizeof(long long) : 0;
+  long long* base;
+  MPI_Win_allocate_shared(bytes, sizeof(long long), MPI_INFO_NULL, h->no, &base, &h->janela_reducao);
+  MPI_Aint tamanho;
+  int unidade;
+  MPI_Win_shared_query(h->janela_reducao, 0, &tamanho, &unidade, &base);
+  h->linhas = base;
+  h->total = &base[(size_t)h->processos_no * capacidade];
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, h->janela_reducao);
+  h->janela_pontos = MPI_WIN_NULL;
+}
+
+/**
+ * @brief Barreira do nó que também torna visíveis as escritas feitas nas janelas.
+ */
+static inline void hibrido_sincronizar(Hibrido* h) {
+  MPI_Win_sync(h->janela_reducao);
+  if (h->janela_pontos != MPI_WIN_NULL) MPI_Win_sync(h->janela_pontos);
+  MPI_Barrier(h->no);
+  MPI_Win_sync(h->janela_reducao);
+  if (h->janela_pontos != MPI_WIN_NULL) MPI_Win_sync(h->janela_pontos);
+}
+
+/**
+ * @brief Aloca a faixa de 'num_pontos' pontos deste processo na janela de pontos do nó
+ * e inicia 'p' sobre ela (as coordenadas não pertencem a 'p').
+ */
+static inline void hibrido_alocar_pontos(Hibrido* h, ConjuntoPontos* p, int num_pontos, int num_dimensoes) {
+  int* coords;
+  MPI_Win_allocate_shared((MPI_Aint)num_pontos * num_dimensoes * sizeof(int), sizeof(int), MPI_INFO_NULL, h->no,
+                          &coords, &h->janela_pontos);
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, h->janela_pontos);
+  pontos_iniciar(p, num_pontos, num_dimensoes, coords);
+}
+
+/**
+ * @brief Distribui os pontos do rank 0 ('todos', com 'contagens' e 'deslocamentos' em
+ * pontos por rank) para as janelas dos nós: uma parte por nó, recebida pelo líder a
+ * partir da faixa do processo 0 do nó, quando os ranks são consecutivos; uma por
+ * processo, caso contrário.
+ */
+static inline void hibrido_distribuir(Hibrido* h, const int* todos, const int* contagens, const int* deslocamentos,
+                                      MPI_Datatype tipo_ponto, ConjuntoPontos* p) {
+  if (!h->consecutivos) {
+    MPI_Scatterv(todos, contagens, deslocamentos, tipo_ponto, p->coords, p->num_pontos, tipo_ponto, 0,
+                 MPI_COMM_WORLD);
+  } else {
+    int pontos_no = 0;
+    MPI_Reduce(&p->num_pontos, &pontos_no, 1, MPI_INT, MPI_SUM, 0, h->no);
+    if (h->lideres != MPI_COMM_NULL) {
+      int lider, num_lideres;
+      MPI_Comm_rank(h->lideres, &lider);
+      MPI_Comm_size(h->lideres, &num_lideres);
+      int* contagens_nos = NULL;
+      int* deslocamentos_nos = NULL;
+      if (lider == 0) {
+        contagens_nos = (int*)malloc(num_lideres * sizeof(int));
+        deslocamentos_nos = (int*)malloc(num_lideres * sizeof(int));
+      }
+      MPI_Gather(&pontos_no, 1, MPI_INT, contagens_nos, 1, MPI_INT, 0, h->lideres);
+      if (lider == 0) {
+        for (int n = 0, offset = 0; n < num_lideres; n++) {
+          deslocamentos_nos[n] = offset;
+          offset += contagens_nos[n];
+        }
+      }
+      // O líder é o processo 0 do nó, então a sua faixa é o início da parte do nó
+      MPI_Scatterv(todos, contagens_nos, deslocamentos_nos, tipo_ponto, p->coords, pontos_no, tipo_ponto, 0,
+                   h->lideres);
+      free(contagens_nos);
+      free(deslocamentos_nos);
+    }
+  }
+  hibrido_sincronizar(h);
+}
+
+/**
+ * @brief Soma 'dados' (com 'tamanho' <= capacidade posições) entre todos os processos,
+ * como um MPI_Allreduce com MPI_SUM: dentro do nó pela janela compartilhada, entre os
+ * nós pelos líderes. Todos os processos recebem o total em 'dados'.
+ */
+static inline void hibrido_reduzir(Hibrido* h, long long* dados, int tamanho) {
+  memcpy(&h->linhas[(size_t)h->processo_no * h->capacidade], dados, tamanho * sizeof(long long));
+  hibrido_sincronizar(h);
+  // Cada processo do nó soma uma faixa das colunas
+  const int inicio = (int)((long long)tamanho * h->processo_no / h->processos_no);
+  const int fim = (int)((long long)tamanho * (h->processo_no + 1) / h->processos_no);
+  for (int x = inicio; x < fim; x++) {
+    long long soma = 0;
+    for (int q = 0; q < h->processos_no; q++) {
+      soma += h->linhas[(size_t)q * h->capacidade + x];
+    }
+    h->total[x] = soma;
+  }
+  hibrido_sincronizar(h);
+  if (h->num_nos > 1) {
+    if (h->lideres != MPI_COMM_NULL) {
+      MPI_Allreduce(MPI_IN_PLACE, h->total, tamanho, MPI_LONG_LONG, MPI_SUM, h->lideres);
+    }
+    hibrido_sincronizar(h);
+  }
+  memcpy(dados, h->total, tamanho * sizeof(long long));
+}
+
+static inline void hibrido_liberar(Hibrido* h) {
+  if (h->janela_pontos != MPI_WIN_NULL) {
+    MPI_Win_unlock_all(h->janela_pontos);
+    MPI_Win_free(&h->janela_pontos);
+  }
+  MPI_Win_unlock_all(h->janela_reducao);
+  MPI_Win_free(&h->janela_reducao);
+  if (h->lideres != MPI_COMM_NULL) MPI_Comm_free(&h->lideres);
+  MPI_Comm_free(&h->no);
+}
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef KMEANS_INCREMENTAL_H
+#define KMEANS_INCREMENTAL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kmeans_dataset.h"
+#include "kmeans_simd.h"
+
+// Atualização incremental dos centroides (opção --incremental).
+//
+// As somas e contagens de cada cluster são mantidas entre as iterações. A primeira
+// iteração as acumula por completo; a partir daí a atribuição registra, em uma lista
+// por thread, só os pontos que mudaram de cluster (com o cluster anterior), e a
+// atualização subtrai cada um da soma antiga e o soma na nova: custo O(mudanças) em
+// vez de O(M). Como as somas são inteiras, o resultado é idêntico ao da acumulação
+// completa. Quando uma lista enche (mais de 1/INCREMENTAL_FRACAO_MAXIMA dos pontos da
+// thread mudou), a iteração volta à acumulação completa, que então é mais barata.
+
+#define INCREMENTAL_FRACAO_MAXIMA 8  // Fração máxima de pontos por lista (1/8)
+#define INCREMENTAL_BLOCO 256        // Pontos por chamada dos kernels em colunas e blocado
+
+typedef struct {
+  _Alignas(64) int quantidade;  // Mudanças registradas; passa de 'capacidade' quando a lista enche
+  int capacidade;
+  int* pontos;       // Índice de cada ponto que mudou
+  int32_t* antigos;  // Cluster anterior de cada um
+} ListaMudancas;
+
+typedef struct {
+  int num_clusters;
+  int num_dimensoes;
+  int iniciado;          // 0 até a primeira acumulação completa
+  long long* somas;      // Somas correntes dos pontos de cada cluster [k * D + d]
+  int* contagens;        // Contagens correntes [k]
+  int num_listas;
+  ListaMudancas* listas;  // Uma por thread de atribuição
+} EstadoIncremental;
+
+/**
+ * @brief Aloca o estado para 'num_pontos' pontos divididos entre 'num_listas' threads
+ * de atribuição. Cada lista comporta 1/INCREMENTAL_FRACAO_MAXIMA da parte da thread.
+ */
+static inline void incremental_iniciar(EstadoIncremental* e, int num_pontos, int num_clusters, int num_dimensoes,
+                                       int num_listas) {
+  e->num_clusters = num_clusters;
+  e->num_dimensoes = num_dimensoes;
+  e->iniciado = 0;
+  e->somas = (long long*)calloc((size_t)num_clusters * num_dimensoes, sizeof(long long));
+  e->contagens = (int*)calloc(num_clusters, sizeof(int));
+  e->num_listas = num_listas;
+  e->listas = (ListaMudancas*)aligned_alloc(64, num_listas * sizeof(ListaMudancas));
+  if (e->somas == NULL || e->contagens == NULL || e->listas == NULL) {
+    fprintf(stderr, "Erro: falha ao alocar o estado incremental.\n");
+    exit(EXIT_FAILURE);
+  }
+  const int capacidade = num_pontos / num_listas / INCREMENTAL_FRACAO_MAXIMA + 1;
+  for (int l = 0; l < num_listas; l++) {
+    e->listas[l].quantidade = 0;
+    e->listas[l].capacidade = capacidade;
+    e->listas[l].pontos = (int*)malloc(capacidade * sizeof(int));
+    e->listas[l].antigos = (int32_t*)malloc(capacidade * sizeof(int32_t));
+    if (e->listas[l].pontos == NULL || e->listas[l].antigos == NULL) {
+      fprintf(stderr, "Erro: falha ao alocar o estado incremental.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+}
+
+static inline void incremental_liberar(EstadoIncremental* e) {
+  for (int l = 0; l < e->num_listas; l++) {
+    free(e->listas[l].pontos);
+    free(e->listas[l].antigos);
+  }
+  free(e->listas);
+  free(e->somas);
+  free(e->contagens);
+}
+
+/**
+ * @brief Lista em que a thread 'indice' registra as mudanças desta iteração, ou NULL
+ * quando não há o que registrar (modo desligado, com 'e' == NULL, ou primeira iteração).
+ */
+static inline ListaMudancas* incremental_lista(EstadoIncremental* e, int indice) {
+  return e != NULL && e->iniciado ? &e->listas[indice] : NULL;
+}
+
+static inline void incremental_registrar(ListaMudancas* l, int ponto, int32_t antigo) {
+  if (l->quantidade < l->capacidade) {
+    l->pontos[l->quantidade] = ponto;
+    l->antigos[l->quantidade] = antigo;
+  }
+  l->quantidade++;
+}
+
+/**
+ * @brief Atribui os pontos [inicio, fim) pelo kernel em colunas (se houver colunas) ou
+ * blocado, como kernel_atribuir_colunas/kernel_atribuir_blocado. Com 'lista', os rótulos
+ * anteriores de cada bloco são guardados antes do kernel para registrar as mudanças.
+ * @return Número de pontos cujo rótulo mudou.
+ */
+static inline long long incremental_atribuir_faixa(const KernelAtribuicao* k, const ConjuntoPontos* p,
+                                                   const PontosCompactos* compacto, int inicio, int fim,
+                                                   ListaMudancas* lista) {
+  int32_t* rotulos = p->rotulos;
+  if (lista == NULL) {
+    return p->colunas != NULL ? kernel_atribuir_colunas(k, p->colunas, p->num_pontos, inicio, fim, rotulos)
+                              : kernel_atribuir_blocado(k, compacto->coords, inicio, fim, rotulos);
+  }
+  int32_t antigos[INCREMENTAL_BLOCO];
+  long long mudancas = 0;
+  for (int i0 = inicio; i0 < fim; i0 += INCREMENTAL_BLOCO) {
+    const int n = fim - i0 < INCREMENTAL_BLOCO ? fim - i0 : INCREMENTAL_BLOCO;
+    memcpy(antigos, &rotulos[i0], n * sizeof(int32_t));
+    long long restantes = p->colunas != NULL
+                              ? kernel_atribuir_colunas(k, p->colunas, p->num_pontos, i0, i0 + n, rotulos)
+                              : kernel_atribuir_blocado(k, compacto->coords, i0, i0 + n, rotulos);
+    mudancas += restantes;
+    for (int j = 0; restantes > 0 && j < n; j++) {
+      if (rotulos[i0 + j] != antigos[j]) {
+        incremental_registrar(lista, i0 + j, antigos[j]);
+        restantes--;
+      }
+    }
+  }
+  return mudancas;
+}
+
+/**
+ * @brief Diz se a atualização desta iteração pode ser incremental: já houve uma
+ * acumulação completa e nenhuma lista encheu. Só pode ser chamada depois que todas as
+ * threads terminaram a atribuição.
+ */
+static inline int incremental_pronto(const EstadoIncremental* e) {
+  if (!e->iniciado) return 0;
+  for (int l = 0; l < e->num_listas; l++) {
+    if (e->listas[l].quantidade > e->listas[l].capacidade) return 0;
+  }
+  return 1;
+}
+
+/**
+ * @brief Tira as coordenadas do ponto i da soma 'de' e as coloca na soma 'para'. No
+ * modo compacto as coordenadas são lidas da cópia em int16.
+ */
+static inline void incremental_mover(long long* de, long long* para, const ConjuntoPontos* p,
+                                     const PontosCompactos* compacto, int i, int D) {
+  if (compacto->coords != NULL) {
+    const int16_t* x = &compacto->coords[(size_t)i * compacto->largura];
+    for (int d = 0; d < D; d++) {
+      de[d] -= x[d];
+      para[d] += x[d];
+    }
+  } else {
+    const int* x = pontos_ponto(p, i);
+    for (int d = 0; d < D; d++) {
+      de[d] -= x[d];
+      para[d] += x[d];
+    }
+  }
+}
+
+/**
+ * @brief Aplica as mudanças de 'lista' em 'somas' e 'contagens' (K x D e K): cada
+ * ponto sai do cluster anterior e entra no atual (points->rotulos).
+ */
+static inline void incremental_aplicar(const ListaMudancas* lista, const ConjuntoPontos* p,
+                                       const PontosCompactos* compacto, long long* somas, int* contagens, int D) {
+  for (int j = 0; j < lista->quantidade; j++) {
+    const int i = lista->pontos[j], antigo = lista->antigos[j], novo = p->rotulos[i];
+    contagens[antigo]--;
+    contagens[novo]++;
+    incremental_mover(&somas[(size_t)antigo * D], &somas[(size_t)novo * D], p, compacto, i, D);
+  }
+}
+
+/**
+ * @brief Encerra a atualização da iteração: esvazia as listas e marca as somas
+ * correntes como válidas.
+ */
+static inline void incremental_concluir(EstadoIncremental* e) {
+  for (int l = 0; l < e->num_listas; l++) {
+    e->listas[l].quantidade = 0;
+  }
+  e->iniciado = 1;
+}
+
+#endif
@@ -0,0 +1,262 @@
+#ifndef KMEANS_INICIALIZACAO_H
+#define KMEANS_INICIALIZACAO_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kmeans_aleatorio.h"
+#include "kmeans_simd.h"
+
+// Inicialização k-means|| (Bahmani et al., 2012), opção --inicializacao=paralela.
+//
+// Parte de um ponto sorteado e, em KMPAR_RODADAS passadas sobre os dados, sorteia
+// cada ponto x como candidato com probabilidade min(1, l * d²(x) / phi), onde d²(x)
+// é a distância ao candidato mais próximo, phi = soma de d²(x) e l = KMPAR_FATOR * K.
+// Depois cada candidato recebe como peso o número de pontos mais próximos dele, e os
+// ~l * KMPAR_RODADAS candidatos são reduzidos a K sementes por k-means++ ponderado.
+//
+// Só as passadas sobre os pontos dependem de M, e elas são paralelas: com OpenMP
+// os laços abaixo viram "parallel for"; no MPI cada processo executa as passadas
+// sobre os próprios pontos e os resultados são combinados entre as rodadas. O sorteio
+// de cada ponto usa o gerador baseado em contador de kmeans_aleatorio.h com o índice
+// global do ponto, e phi é somado exatamente em 64 bits, então as sementes são as
+// mesmas em todas as versões, com qualquer número de threads ou processos.
+
+#define KMPAR_RODADAS 5
+#define KMPAR_FATOR 2  // Fator de sobreamostragem l = KMPAR_FATOR * K
+
+#ifdef _OPENMP
+#define KMPAR_PRAGMA(x) _Pragma(#x)
+#else
+#define KMPAR_PRAGMA(x)
+#endif
+
+typedef struct {
+  int num_dimensoes;
+  int num_candidatos;
+  int capacidade;
+  int* coords;       // Candidatos [c * D + d]
+  long long* pesos;  // Pontos mais próximos de cada candidato
+} CandidatosKMPar;
+
+static inline void kmpar_candidatos_iniciar(CandidatosKMPar* c, int num_dimensoes, int capacidade) {
+  c->num_dimensoes = num_dimensoes;
+  c->num_candidatos = 0;
+  c->capacidade = capacidade > 0 ? capacidade : 1;
+  c->coords = (int*)malloc((size_t)c->capacidade * num_dimensoes * sizeof(int));
+  c->pesos = NULL;
+  if (c->coords == NULL) {
+    fprintf(stderr, "Erro: falha ao alocar os candidatos da inicialização.\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+static inline void kmpar_candidatos_liberar(CandidatosKMPar* c) {
+  free(c->coords);
+  free(c->pesos);
+}
+
+static inline void kmpar_candidatos_adicionar(CandidatosKMPar* c, const int* ponto) {
+  const int D = c->num_dimensoes;
+  if (c->num_candidatos == c->capacidade) {
+    c->capacidade *= 2;
+    c->coords = (int*)realloc(c->coords, (size_t)c->capacidade * D * sizeof(int));
+    if (c->coords == NULL) {
+      fprintf(stderr, "Erro: falha ao alocar os candidatos da inicialização.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  memcpy(&c->coords[(size_t)c->num_candidatos * D], ponto, D * sizeof(int));
+  c->num_candidatos++;
+}
+
+/**
+ * @brief Indica se phi (soma de d² sobre todos os pontos) cabe em 64 bits para a faixa
+ * de valores dos dados. Se não couber, a inicialização aleatória deve ser usada.
+ */
+static inline int kmpar_faixa_segura(long long num_pontos, int num_dimensoes, int min_val, int max_val) {
+  double faixa = (double)max_val - min_val;
+  return (double)num_pontos * num_dimensoes * faixa * faixa < 9.0e18;
+}
+
+/**
+ * @brief Número uniforme em [0, 1) para o ponto de índice global 'indice' na 'rodada'.
+ */
+static inline double kmpar_uniforme(uint64_t semente, int rodada, long long indice) {
+  uint64_t h = aleatorio_hash(aleatorio_hash(semente ^ ((uint64_t)rodada << 48)) + (uint64_t)indice);
+  return (double)(h >> 11) * 0x1.0p-53;
+}
+
+/**
+ * @brief Índice global do primeiro candidato.
+ */
+static inline long long kmpar_primeiro(uint64_t semente, long long num_pontos) {
+  return (long long)(aleatorio_hash(semente) % (uint64_t)num_pontos);
+}
+
+/**
+ * @brief Atualiza d²(x) dos 'n' pontos com os candidatos [primeiro, num_candidatos).
+ * Com primeiro == 0, d² é inicializado.
+ * @return A soma exata de d² sobre os n pontos (phi local).
+ */
+static inline long long kmpar_atualizar_distancias(const int* coords, int n, const CandidatosKMPar* c, int primeiro,
+                                                   NivelSimd nivel, long long* dist2) {
+  const int D = c->num_dimensoes;
+  long long soma = 0;
+  if (c->num_candidatos == primeiro) {
+    KMPAR_PRAGMA(omp parallel for reduction(+ : soma))
+    for (int i = 0; i < n; i++) {
+      soma += dist2[i];
+    }
+    return soma;
+  }
+
+  KernelAtribuicao kernel;
+  kernel_iniciar(&kernel, nivel, c->num_candidatos - primeiro, D);
+  kernel_carregar_centroides(&kernel, &c->coords[(size_t)primeiro * D]);
+  KMPAR_PRAGMA(omp parallel for reduction(+ : soma))
+  for (int i = 0; i < n; i++) {
+    const int* ponto = &coords[(size_t)i * D];
+    long long d = kernel_distancia(&kernel, ponto, kernel_mais_proximo(&kernel, ponto));
+    if (primeiro == 0 || d < dist2[i]) dist2[i] = d;
+    soma += dist2[i];
+  }
+  kernel_liberar(&kernel);
+  return soma;
+}
+
+/**
+ * @brief Sorteia os candidatos da rodada entre os 'n' pontos, cujo primeiro índice
+ * global é 'inicio_global'. marcados[i] = 1 para os pontos sorteados.
+ */
+static inline void kmpar_sortear(const long long* dist2, int n, long long inicio_global, long long phi, int num_clusters,
+                                 uint64_t semente, int rodada, unsigned char* marcados) {
+  const double fator = phi > 0 ? (double)KMPAR_FATOR * num_clusters / (double)phi : 0.0;
+  KMPAR_PRAGMA(omp parallel for)
+  for (int i = 0; i < n; i++) {
+    marcados[i] = kmpar_uniforme(semente, rodada, inicio_global + i) < fator * (double)dist2[i];
+  }
+}
+
+/**
+ * @brief Conta, para cada candidato, quantos dos 'n' pontos estão mais próximos dele.
+ */
+static inline void kmpar_pesos(const int* coords, int n, CandidatosKMPar* c, NivelSimd nivel) {
+  const int D = c->num_dimensoes, C = c->num_candidatos;
+  free(c->pesos);
+  c->pesos = (long long*)calloc(C, sizeof(long long));
+  if (c->pesos == NULL) {
+    fprintf(stderr, "Erro: falha ao alocar os candidatos da inicialização.\n");
+    exit(EXIT_FAILURE);
+  }
+  long long* pesos = c->pesos;
+
+  KernelAtribuicao kernel;
+  kernel_iniciar(&kernel, nivel, C, D);
+  kernel_carregar_centroides(&kernel, c->coords);
+  KMPAR_PRAGMA(omp parallel for reduction(+ : pesos[:C]))
+  for (int i = 0; i < n; i++) {
+    pesos[kernel_mais_proximo(&kernel, &coords[(size_t)i * D])]++;
+  }
+  kernel_liberar(&kernel);
+}
+
+/**
+ * @brief Reduz os candidatos ponderados a K sementes com k-means++ ponderado: cada
+ * semente é sorteada com probabilidade proporcional a peso * d² até a mais próxima
+ * já escolhida. Se não restar candidato com d² > 0 (menos candidatos distintos que
+ * K), os candidatos ainda não escolhidos são usados em ordem.
+ */
+static inline void kmpar_reduzir(const CandidatosKMPar* c, int num_clusters, uint64_t semente, int* centroides) {
+  const int D = c->num_dimensoes, C = c->num_candidatos;
+  double* dist = (double*)malloc(C * sizeof(double));
+  unsigned char* escolhido = (unsigned char*)calloc(C, 1);
+  if (dist == NULL || escolhido == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int j = 0; j < C; j++) {
+    dist[j] = 1.0;  // Primeira escolha proporcional apenas ao peso
+  }
+
+  for (int k = 0; k < num_clusters; k++) {
+    double total = 0.0;
+    for (int j = 0; j < C; j++) {
+      total += (double)c->pesos[j] * dist[j];
+    }
+    int sorteado = -1;
+    if (total > 0.0) {
+      double alvo = kmpar_uniforme(semente, KMPAR_RODADAS + 1, k) * total, acumulado = 0.0;
+      for (int j = 0; j < C; j++) {
+        double p = (double)c->pesos[j] * dist[j];
+        if (p <= 0.0) continue;
+        sorteado = j;
+        acumulado += p;
+        if (acumulado > alvo) break;
+      }
+    }
+    if (sorteado < 0) {
+      for (int j = 0; j < C && sorteado < 0; j++) {
+        if (!escolhido[j]) sorteado = j;
+      }
+      if (sorteado < 0) sorteado = k % C;
+    }
+
+    escolhido[sorteado] = 1;
+    const int* semente_k = &c->coords[(size_t)sorteado * D];
+    memcpy(&centroides[(size_t)k * D], semente_k, D * sizeof(int));
+    for (int j = 0; j < C; j++) {
+      double d = 0.0;
+      for (int t = 0; t < D; t++) {
+        double diff = (double)c->coords[(size_t)j * D + t] - semente_k[t];
+        d += diff * diff;
+      }
+      if (k == 0 || d < dist[j]) dist[j] = d;
+    }
+  }
+
+  free(dist);
+  free(escolhido);
+}
+
+/**
+ * @brief Inicialização k-means|| completa para os pontos em memória compartilhada
+ * (versões sequencial, OpenMP e Pthreads). Grava as K sementes em 'centroides'.
+ * @return O número de candidatos sobreamostrados.
+ */
+static inline int kmpar_inicializar(const int* coords, int num_pontos, int num_dimensoes, int num_clusters,
+                                    uint64_t semente, NivelSimd nivel, int* centroides) {
+  const int D = num_dimensoes;
+  CandidatosKMPar c;
+  kmpar_candidatos_iniciar(&c, D, 1 + KMPAR_RODADAS * KMPAR_FATOR * num_clusters);
+  long long* dist2 = (long long*)malloc((size_t)num_pontos * sizeof(long long));
+  unsigned char* marcados = (unsigned char*)malloc(num_pontos);
+  if (dist2 == NULL || marcados == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  kmpar_candidatos_adicionar(&c, &coords[(size_t)kmpar_primeiro(semente, num_pontos) * D]);
+  long long phi = kmpar_atualizar_distancias(coords, num_pontos, &c, 0, nivel, dist2);
+  for (int rodada = 0; rodada < KMPAR_RODADAS && phi > 0; rodada++) {
+    const int primeiro = c.num_candidatos;
+    kmpar_sortear(dist2, num_pontos, 0, phi, num_clusters, semente, rodada, marcados);
+    for (int i = 0; i < num_pontos; i++) {
+      if (marcados[i]) kmpar_candidatos_adicionar(&c, &coords[(size_t)i * D]);
+    }
+    phi = kmpar_atualizar_distancias(coords, num_pontos, &c, primeiro, nivel, dist2);
+  }
+
+  kmpar_pesos(coords, num_pontos, &c, nivel);
+  kmpar_reduzir(&c, num_clusters, semente, centroides);
+  const int num_candidatos = c.num_candidatos;
+  free(dist2);
+  free(marcados);
+  kmpar_candidatos_liberar(&c);
+  return num_candidatos;
+}
+
+#endif
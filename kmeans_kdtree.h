@@ -0,0 +1,502 @@
+#ifndef KMEANS_KDTREE_H
+#define KMEANS_KDTREE_H
+
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Atribuição por filtragem em uma árvore KD (Kanungo et al., 2002), opção --kdtree.
+//
+// A árvore é construída uma vez sobre os pontos, fora da região medida: cada nó
+// guarda a caixa delimitadora, a soma e a contagem dos seus pontos, e os nós são
+// divididos na mediana da dimensão mais larga até KDTREE_FOLHA pontos. Os pontos
+// são copiados na ordem da árvore, então cada subárvore ocupa uma faixa contígua.
+//
+// A cada iteração a árvore é percorrida com um conjunto de centroides candidatos.
+// Em cada nó, z* é o candidato mais próximo do centro da caixa, e um candidato z é
+// descartado quando, no vértice v da caixa mais favorável a z, z não é mais próximo
+// que z*: como |x - z|² - |x - z*|² é linear em x, o mínimo na caixa está nesse
+// vértice, e se ele não é negativo (com empate resolvido pelo menor índice, como no
+// Lloyd) z não vence em nenhum ponto do nó. Quando sobra um candidato, a subárvore
+// inteira é atribuída a ele e somada pelos totais do nó, sem tocar nos pontos; nas
+// folhas com mais de um candidato, cada ponto compara só os que sobraram. O teste é
+// feito em inteiros de 64 bits, então o resultado é idêntico ao do Lloyd; para isso a
+// faixa dos dados precisa passar em kdtree_faixa_segura.
+//
+// Para o trabalho em paralelo, a parte de cima da árvore é filtrada antes e as
+// subárvores com até num_pontos / KDTREE_TAREFAS pontos viram tarefas independentes,
+// cada uma com seu acumulador; a construção usa tarefas OpenMP sobre as subárvores.
+
+#define KDTREE_FOLHA 16                 // Pontos máximos por folha
+#define KDTREE_TAREFAS 1024             // Subárvores (aproximadamente) filtradas em paralelo
+#define KDTREE_TAREFA_CONSTRUCAO 32768  // Pontos mínimos de uma subárvore construída em outra tarefa
+
+#ifdef _OPENMP
+#define KDTREE_PRAGMA(x) _Pragma(#x)
+#else
+#define KDTREE_PRAGMA(x)
+#endif
+
+// Somas parciais de uma thread da filtragem
+typedef struct {
+  _Alignas(64) long long* somas;  // [k * D + d]
+  int* contagens;                 // [k]
+  int* candidatos;                // Candidatos de cada nível da recursão [nivel * K + j]
+  long long mudancas;
+  long long avaliacoes;           // Testes de poda e distâncias ponto-centroide calculados
+} AcumuladorKD;
+
+typedef struct {
+  int num_pontos;
+  int num_dimensoes;
+  int num_clusters;
+  int num_nos;
+  int profundidade;      // Níveis da recursão de filtragem (com folga)
+  int* coords;           // Pontos na ordem da árvore [j * D + d]
+  int32_t* rotulos;      // Rótulos na ordem da árvore
+  int* caixa_min;        // [no * D + d]
+  int* caixa_max;        // [no * D + d]
+  long long* somas;      // Soma dos pontos de cada nó [no * D + d]
+  int* inicio;           // Primeiro ponto (na ordem da árvore) de cada nó
+  int* contagem;         // Pontos de cada nó
+  int* direita;          // Filho da direita (o da esquerda é no + 1); -1 nas folhas
+  int* proximo;          // Primeiro nó depois da subárvore (ordem de pré-ordem)
+  int* dono;             // Cluster de todos os pontos da subárvore, ou -1 se não se sabe
+  int limite_tarefa;     // Pontos máximos de uma subárvore-tarefa
+  int num_tarefas;
+  int* tarefa_no;        // Raiz de cada tarefa da iteração
+  int* tarefa_candidatos;  // Candidatos de cada tarefa [t * K + j]
+  int* tarefa_num_candidatos;
+  int num_acumuladores;
+  AcumuladorKD* acumuladores;
+  long long* somas_clusters;  // Resultado de kdtree_reduzir [k * D + d]
+  int* contagens_clusters;    // [k]
+} ArvoreKD;
+
+/**
+ * @brief Indica se o teste de poda cabe em long long para dados em [min_val, max_val]:
+ * cada termo (z - z*)(z + z* - 2v) tem módulo até 2 * faixa², e são D termos.
+ */
+static inline int kdtree_faixa_segura(int num_dimensoes, int min_val, int max_val) {
+  double faixa = (double)max_val - min_val;
+  return 2.0 * num_dimensoes * faixa * faixa < 9.0e18;
+}
+
+/**
+ * @brief Número de nós da subárvore de 'n' pontos (n/2 vão para a esquerda).
+ * Devolve em 'seguinte' o da subárvore de n + 1 pontos: os dois tamanhos dos filhos
+ * de n e de n + 1 estão sempre em {n/2, n/2 + 1}, então a recursão é O(log n).
+ */
+static inline int kdtree_num_nos(int n, int* seguinte) {
+  if (n + 1 <= KDTREE_FOLHA) {
+    *seguinte = 1;
+    return 1;
+  }
+  const int h = n / 2;
+  int nos_h1;
+  const int nos_h = kdtree_num_nos(h, &nos_h1);
+  // n = 2h ou 2h + 1 pontos; n + 1 = 2h + 1 ou 2h + 2 pontos
+  *seguinte = 1 + ((n + 1) / 2 == h ? nos_h : nos_h1) + ((n + 1) - (n + 1) / 2 == h ? nos_h : nos_h1);
+  if (n <= KDTREE_FOLHA) return 1;
+  return 1 + (n / 2 == h ? nos_h : nos_h1) + (n - n / 2 == h ? nos_h : nos_h1);
+}
+
+/**
+ * @brief Reordena indices[0, n) para que o elemento de posição 'k' seja o que teria
+ * nessa posição se os índices estivessem ordenados pela coordenada 'dim' (quickselect).
+ */
+static inline void kdtree_selecionar(int* indices, int n, int k, const int* coords, int D, int dim) {
+  int esq = 0, dir = n - 1;
+  while (esq < dir) {
+    const int meio = esq + (dir - esq) / 2;
+    // Mediana de três como pivô
+    int a = coords[(size_t)indices[esq] * D + dim], b = coords[(size_t)indices[meio] * D + dim],
+        c = coords[(size_t)indices[dir] * D + dim];
+    const int pivo = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b));
+    int i = esq, j = dir;
+    while (i <= j) {
+      while (coords[(size_t)indices[i] * D + dim] < pivo) i++;
+      while (coords[(size_t)indices[j] * D + dim] > pivo) j--;
+      if (i <= j) {
+        int t = indices[i];
+        indices[i] = indices[j];
+        indices[j] = t;
+        i++;
+        j--;
+      }
+    }
+    if (k <= j) dir = j;
+    else if (k >= i) esq = i;
+    else return;
+  }
+}
+
+/**
+ * @brief Constrói o nó 'no' com os pontos indices[inicio, inicio + n) e, em tarefas
+ * quando a subárvore é grande, os filhos.
+ */
+static inline void kdtree_construir_no(ArvoreKD* a, int no, int* indices, int inicio, int n, const int* coords) {
+  const int D = a->num_dimensoes;
+  int* lo = &a->caixa_min[(size_t)no * D];
+  int* hi = &a->caixa_max[(size_t)no * D];
+  long long* soma = &a->somas[(size_t)no * D];
+  memcpy(lo, &coords[(size_t)indices[inicio] * D], D * sizeof(int));
+  memcpy(hi, lo, D * sizeof(int));
+  memset(soma, 0, D * sizeof(long long));
+  for (int j = inicio; j < inicio + n; j++) {
+    const int* p = &coords[(size_t)indices[j] * D];
+    for (int d = 0; d < D; d++) {
+      if (p[d] < lo[d]) lo[d] = p[d];
+      if (p[d] > hi[d]) hi[d] = p[d];
+      soma[d] += p[d];
+    }
+  }
+  int ignorado;
+  a->inicio[no] = inicio;
+  a->contagem[no] = n;
+  a->proximo[no] = no + kdtree_num_nos(n, &ignorado);
+  a->dono[no] = -1;
+  int dim = 0;
+  for (int d = 1; d < D; d++) {
+    if ((long long)hi[d] - lo[d] > (long long)hi[dim] - lo[dim]) dim = d;
+  }
+  // Folha: poucos pontos, ou todos iguais (os nós restantes da faixa ficam sem uso)
+  if (n <= KDTREE_FOLHA || hi[dim] == lo[dim]) {
+    a->direita[no] = -1;
+    return;
+  }
+  const int meio = n / 2;
+  kdtree_selecionar(&indices[inicio], n, meio, coords, D, dim);
+  const int direita = no + 1 + kdtree_num_nos(meio, &ignorado);
+  a->direita[no] = direita;
+  KDTREE_PRAGMA(omp task if (n > KDTREE_TAREFA_CONSTRUCAO))
+  kdtree_construir_no(a, no + 1, indices, inicio, meio, coords);
+  kdtree_construir_no(a, direita, indices, inicio + meio, n - meio, coords);
+  KDTREE_PRAGMA(omp taskwait)
+}
+
+/**
+ * @brief Conta as raízes de subárvores-tarefa abaixo de 'no': os nós que são folhas ou
+ * têm até limite_tarefa pontos e cujo pai não é nenhum dos dois.
+ */
+static inline int kdtree_contar_tarefas(const ArvoreKD* a, int no) {
+  if (a->direita[no] < 0 || a->contagem[no] <= a->limite_tarefa) return 1;
+  return kdtree_contar_tarefas(a, no + 1) + kdtree_contar_tarefas(a, a->direita[no]);
+}
+
+/**
+ * @brief Constrói a árvore sobre os 'num_pontos' pontos de 'coords' e aloca um
+ * acumulador para cada uma das 'num_acumuladores' threads que vão filtrá-la.
+ */
+static inline void kdtree_construir(ArvoreKD* a, const int* coords, int num_pontos, int num_dimensoes,
+                                    int num_clusters, int num_acumuladores) {
+  const int D = num_dimensoes, K = num_clusters;
+  int ignorado;
+  a->num_pontos = num_pontos;
+  a->num_dimensoes = D;
+  a->num_clusters = K;
+  a->num_nos = kdtree_num_nos(num_pontos, &ignorado);
+  a->profundidade = 2;
+  for (int n = num_pontos; n > KDTREE_FOLHA; n -= n / 2) a->profundidade++;
+  const size_t nos = a->num_nos;
+  a->coords = (int*)malloc((size_t)num_pontos * D * sizeof(int));
+  a->rotulos = (int32_t*)malloc((size_t)num_pontos * sizeof(int32_t));
+  a->caixa_min = (int*)malloc(nos * D * sizeof(int));
+  a->caixa_max = (int*)malloc(nos * D * sizeof(int));
+  a->somas = (long long*)malloc(nos * D * sizeof(long long));
+  a->inicio = (int*)calloc(nos, sizeof(int));
+  a->contagem = (int*)calloc(nos, sizeof(int));
+  a->direita = (int*)calloc(nos, sizeof(int));
+  a->proximo = (int*)calloc(nos, sizeof(int));
+  a->dono = (int*)calloc(nos, sizeof(int));
+  int* indices = (int*)malloc((size_t)num_pontos * sizeof(int));
+  if (a->coords == NULL || a->rotulos == NULL || a->caixa_min == NULL || a->caixa_max == NULL || a->somas == NULL ||
+      a->inicio == NULL || a->contagem == NULL || a->direita == NULL || a->proximo == NULL || a->dono == NULL ||
+      indices == NULL) {
+    fprintf(stderr, "Erro: falha ao alocar a árvore KD.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  KDTREE_PRAGMA(omp parallel for schedule(static))
+  for (int i = 0; i < num_pontos; i++) {
+    indices[i] = i;
+    a->rotulos[i] = -1;
+  }
+  KDTREE_PRAGMA(omp parallel)
+  KDTREE_PRAGMA(omp single)
+  kdtree_construir_no(a, 0, indices, 0, num_pontos, coords);
+  KDTREE_PRAGMA(omp parallel for schedule(static))
+  for (int j = 0; j < num_pontos; j++) {
+    memcpy(&a->coords[(size_t)j * D], &coords[(size_t)indices[j] * D], D * sizeof(int));
+  }
+  free(indices);
+
+  a->limite_tarefa = num_pontos / KDTREE_TAREFAS > KDTREE_FOLHA ? num_pontos / KDTREE_TAREFAS : KDTREE_FOLHA;
+  const int max_tarefas = kdtree_contar_tarefas(a, 0);
+  a->num_tarefas = 0;
+  a->tarefa_no = (int*)malloc(max_tarefas * sizeof(int));
+  a->tarefa_candidatos = (int*)malloc((size_t)max_tarefas * K * sizeof(int));
+  a->tarefa_num_candidatos = (int*)malloc(max_tarefas * sizeof(int));
+  a->num_acumuladores = num_acumuladores;
+  a->acumuladores = (AcumuladorKD*)aligned_alloc(64, num_acumuladores * sizeof(AcumuladorKD));
+  a->somas_clusters = (long long*)malloc((size_t)K * D * sizeof(long long));
+  a->contagens_clusters = (int*)malloc(K * sizeof(int));
+  if (a->tarefa_no == NULL || a->tarefa_candidatos == NULL || a->tarefa_num_candidatos == NULL ||
+      a->acumuladores == NULL || a->somas_clusters == NULL || a->contagens_clusters == NULL) {
+    fprintf(stderr, "Erro: falha ao alocar a árvore KD.\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int t = 0; t < num_acumuladores; t++) {
+    AcumuladorKD* acc = &a->acumuladores[t];
+    acc->somas = (long long*)malloc((size_t)K * D * sizeof(long long));
+    acc->contagens = (int*)malloc(K * sizeof(int));
+    acc->candidatos = (int*)malloc((size_t)a->profundidade * K * sizeof(int));
+    if (acc->somas == NULL || acc->contagens == NULL || acc->candidatos == NULL) {
+      fprintf(stderr, "Erro: falha ao alocar a árvore KD.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+}
+
+static inline void kdtree_liberar(ArvoreKD* a) {
+  for (int t = 0; t < a->num_acumuladores; t++) {
+    free(a->acumuladores[t].somas);
+    free(a->acumuladores[t].contagens);
+    free(a->acumuladores[t].candidatos);
+  }
+  free(a->acumuladores);
+  free(a->somas_clusters);
+  free(a->contagens_clusters);
+  free(a->tarefa_no);
+  free(a->tarefa_candidatos);
+  free(a->tarefa_num_candidatos);
+  free(a->coords);
+  free(a->rotulos);
+  free(a->caixa_min);
+  free(a->caixa_max);
+  free(a->somas);
+  free(a->inicio);
+  free(a->contagem);
+  free(a->direita);
+  free(a->proximo);
+  free(a->dono);
+}
+
+/**
+ * @brief Filtra os 'n' candidatos (em ordem crescente) pela caixa do nó 'no' e grava
+ * em 'saida', também em ordem crescente, os que ainda podem vencer em algum ponto dele.
+ * @return Quantos candidatos sobraram (pelo menos 1).
+ */
+static inline int kdtree_podar(const ArvoreKD* a, int no, const int* centroides, const int* candidatos, int n,
+                               int* saida, AcumuladorKD* acc) {
+  const int D = a->num_dimensoes;
+  const int* lo = &a->caixa_min[(size_t)no * D];
+  const int* hi = &a->caixa_max[(size_t)no * D];
+  acc->avaliacoes += n;
+  if (n == 1) {
+    saida[0] = candidatos[0];
+    return 1;
+  }
+  // z*: candidato mais próximo do centro da caixa (a escolha só afeta a poda, não o resultado)
+  int melhor = candidatos[0];
+  double melhor_dist = INFINITY;
+  for (int j = 0; j < n; j++) {
+    const int* z = &centroides[(size_t)candidatos[j] * D];
+    double dist = 0.0;
+    for (int d = 0; d < D; d++) {
+      double diff = 2.0 * z[d] - ((double)lo[d] + hi[d]);
+      dist += diff * diff;
+    }
+    if (dist < melhor_dist) {
+      melhor_dist = dist;
+      melhor = candidatos[j];
+    }
+  }
+  const int* estrela = &centroides[(size_t)melhor * D];
+  int m = 0;
+  for (int j = 0; j < n; j++) {
+    const int c = candidatos[j];
+    if (c != melhor) {
+      // |v - z|² - |v - z*|² = sum (z - z*)(z + z* - 2v), no vértice v mais favorável a z
+      const int* z = &centroides[(size_t)c * D];
+      long long diferenca = 0;
+      for (int d = 0; d < D; d++) {
+        const long long v = z[d] > estrela[d] ? hi[d] : lo[d];
+        diferenca += ((long long)z[d] - estrela[d]) * ((long long)z[d] + estrela[d] - 2 * v);
+      }
+      if (diferenca > 0 || (diferenca == 0 && c > melhor)) continue;
+    }
+    saida[m++] = c;
+  }
+  return m;
+}
+
+/**
+ * @brief Atribui todos os pontos da subárvore 'no' ao cluster 'k' pelos totais do nó.
+ * Os rótulos só são percorridos se a subárvore não era inteira de 'k'.
+ */
+static inline void kdtree_atribuir_subarvore(ArvoreKD* a, int no, int k, AcumuladorKD* acc) {
+  const int D = a->num_dimensoes;
+  const long long* soma = &a->somas[(size_t)no * D];
+  long long* destino = &acc->somas[(size_t)k * D];
+  for (int d = 0; d < D; d++) {
+    destino[d] += soma[d];
+  }
+  acc->contagens[k] += a->contagem[no];
+  if (a->dono[no] == k) return;
+  int32_t* rotulos = &a->rotulos[a->inicio[no]];
+  long long mudados = 0;
+  for (int j = 0; j < a->contagem[no]; j++) {
+    mudados += rotulos[j] != k;
+    rotulos[j] = k;
+  }
+  acc->mudancas += mudados;
+  for (int f = no; f < a->proximo[no]; f++) {
+    a->dono[f] = k;
+  }
+}
+
+/**
+ * @brief Atribui cada ponto da folha 'no' ao mais próximo dos 'n' candidatos.
+ */
+static inline void kdtree_atribuir_folha(ArvoreKD* a, int no, const int* centroides, const int* candidatos, int n,
+                                         AcumuladorKD* acc) {
+  const int D = a->num_dimensoes;
+  int32_t* rotulos = &a->rotulos[a->inicio[no]];
+  const int* pontos = &a->coords[(size_t)a->inicio[no] * D];
+  int dono = -2;
+  for (int j = 0; j < a->contagem[no]; j++) {
+    const int* p = &pontos[(size_t)j * D];
+    long long min_dist = LLONG_MAX;
+    int best_cluster = candidatos[0];
+    for (int c = 0; c < n; c++) {
+      const int* z = &centroides[(size_t)candidatos[c] * D];
+      long long dist = 0;
+      for (int d = 0; d < D; d++) {
+        long long diff = (long long)p[d] - z[d];
+        dist += diff * diff;
+      }
+      if (dist < min_dist) {
+        min_dist = dist;
+        best_cluster = candidatos[c];
+      }
+    }
+    acc->mudancas += rotulos[j] != best_cluster;
+    rotulos[j] = best_cluster;
+    acc->contagens[best_cluster]++;
+    long long* soma = &acc->somas[(size_t)best_cluster * D];
+    for (int d = 0; d < D; d++) {
+      soma[d] += p[d];
+    }
+    dono = dono == -2 || dono == best_cluster ? best_cluster : -1;
+  }
+  acc->avaliacoes += (long long)a->contagem[no] * n;
+  a->dono[no] = dono;
+}
+
+/**
+ * @brief Filtra a subárvore 'no' com os 'n' candidatos, usando o nível 'nivel' + 1 do
+ * buffer de candidatos do acumulador para os que sobram.
+ */
+static inline void kdtree_filtrar_no(ArvoreKD* a, int no, const int* centroides, const int* candidatos, int n,
+                                     int nivel, AcumuladorKD* acc) {
+  int* restantes = &acc->candidatos[(size_t)(nivel + 1) * a->num_clusters];
+  const int m = kdtree_podar(a, no, centroides, candidatos, n, restantes, acc);
+  if (m == 1) {
+    kdtree_atribuir_subarvore(a, no, restantes[0], acc);
+  } else if (a->direita[no] < 0) {
+    kdtree_atribuir_folha(a, no, centroides, restantes, m, acc);
+  } else {
+    a->dono[no] = -1;
+    kdtree_filtrar_no(a, no + 1, centroides, restantes, m, nivel + 1, acc);
+    kdtree_filtrar_no(a, a->direita[no], centroides, restantes, m, nivel + 1, acc);
+  }
+}
+
+/**
+ * @brief Parte de cima da filtragem, feita por uma thread: filtra os nós acima das
+ * subárvores-tarefa (acumulando no acumulador 'acc') e registra cada tarefa com os
+ * candidatos que chegaram até ela.
+ */
+static inline void kdtree_filtrar_topo(ArvoreKD* a, int no, const int* centroides, const int* candidatos, int n,
+                                       int nivel, AcumuladorKD* acc) {
+  if (a->direita[no] < 0 || a->contagem[no] <= a->limite_tarefa) {
+    const int t = a->num_tarefas++;
+    a->tarefa_no[t] = no;
+    a->tarefa_num_candidatos[t] = n;
+    memcpy(&a->tarefa_candidatos[(size_t)t * a->num_clusters], candidatos, n * sizeof(int));
+    return;
+  }
+  int* restantes = &acc->candidatos[(size_t)(nivel + 1) * a->num_clusters];
+  const int m = kdtree_podar(a, no, centroides, candidatos, n, restantes, acc);
+  if (m == 1) {
+    kdtree_atribuir_subarvore(a, no, restantes[0], acc);
+    return;
+  }
+  a->dono[no] = -1;
+  kdtree_filtrar_topo(a, no + 1, centroides, restantes, m, nivel + 1, acc);
+  kdtree_filtrar_topo(a, a->direita[no], centroides, restantes, m, nivel + 1, acc);
+}
+
+/**
+ * @brief Início da iteração: zera os acumuladores e filtra a parte de cima da árvore
+ * com todos os centroides, deixando as tarefas prontas para kdtree_filtrar_tarefa.
+ */
+static inline void kdtree_preparar(ArvoreKD* a, const int* centroides) {
+  const int K = a->num_clusters, D = a->num_dimensoes;
+  for (int t = 0; t < a->num_acumuladores; t++) {
+    AcumuladorKD* acc = &a->acumuladores[t];
+    memset(acc->somas, 0, (size_t)K * D * sizeof(long long));
+    memset(acc->contagens, 0, K * sizeof(int));
+    acc->mudancas = 0;
+    acc->avaliacoes = 0;
+  }
+  AcumuladorKD* acc = &a->acumuladores[0];
+  for (int k = 0; k < K; k++) {
+    acc->candidatos[k] = k;
+  }
+  a->num_tarefas = 0;
+  kdtree_filtrar_topo(a, 0, centroides, acc->candidatos, K, 0, acc);
+}
+
+/**
+ * @brief Filtra a subárvore-tarefa 't', acumulando em 'acc'. Tarefas diferentes podem
+ * ser filtradas ao mesmo tempo, desde que com acumuladores diferentes.
+ */
+static inline void kdtree_filtrar_tarefa(ArvoreKD* a, int t, const int* centroides, AcumuladorKD* acc) {
+  kdtree_filtrar_no(a, a->tarefa_no[t], centroides, &a->tarefa_candidatos[(size_t)t * a->num_clusters],
+                    a->tarefa_num_candidatos[t], 0, acc);
+}
+
+/**
+ * @brief Soma os acumuladores em somas_clusters e contagens_clusters.
+ * Em 'avaliacoes' é somado o número de testes de poda e distâncias calculados.
+ * @return Número de pontos que mudaram de cluster.
+ */
+static inline long long kdtree_reduzir(ArvoreKD* a, long long* avaliacoes) {
+  const int K = a->num_clusters, D = a->num_dimensoes;
+  memset(a->somas_clusters, 0, (size_t)K * D * sizeof(long long));
+  memset(a->contagens_clusters, 0, K * sizeof(int));
+  long long mudancas = 0;
+  for (int t = 0; t < a->num_acumuladores; t++) {
+    const AcumuladorKD* acc = &a->acumuladores[t];
+    for (size_t i = 0; i < (size_t)K * D; i++) {
+      a->somas_clusters[i] += acc->somas[i];
+    }
+    for (int k = 0; k < K; k++) {
+      a->contagens_clusters[k] += acc->contagens[k];
+    }
+    mudancas += acc->mudancas;
+    *avaliacoes += acc->avaliacoes;
+  }
+  return mudancas;
+}
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef KMEANS_MINIBATCH_H
+#define KMEANS_MINIBATCH_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kmeans_aleatorio.h"
+
+// K-Means por mini-lotes (Sculley, 2010), opção --minibatch=B.
+//
+// Em vez de percorrer os M pontos a cada iteração, cada passo sorteia B pontos,
+// atribui cada um ao centroide mais próximo e move os centroides na direção da
+// média do lote com taxa de aprendizado por centroide: com n pontos do lote no
+// cluster k e v[k] pontos já vistos por ele (incluindo o lote),
+//   c[k] += (soma[k] - n * c[k]) / v[k]
+// o que equivale a aplicar a regra ponto a ponto com taxa 1 / v[k].
+//
+// Os centroides são mantidos em double e arredondados para inteiros a cada passo,
+// porque o kernel de atribuição trabalha com coordenadas inteiras. As somas do
+// lote são inteiras de 64 bits, no mesmo layout compactado da redução do MPI
+// ([k * (D + 1) + d], com a contagem em d = D), então o resultado não depende do
+// número de threads. Os índices são sorteados por um gerador baseado em contador,
+// portanto o lote de cada passo é sempre o mesmo.
+
+#define MINILOTE_SEMENTE 42ULL
+
+typedef struct {
+  int tamanho_lote;
+  int num_clusters;
+  int num_dimensoes;
+  double* centros;    // Centroides em precisão dupla [k * D + d]
+  long long* vistos;  // v[k]: pontos já atribuídos ao centroide k em todos os passos
+  long long* lote;    // Somas e contagens do passo atual [k * (D + 1) + d]
+  int* indices;       // Pontos sorteados no passo atual
+} EstadoMiniLote;
+
+static inline void minilote_iniciar(EstadoMiniLote* m, int tamanho_lote, int num_clusters, int num_dimensoes,
+                                    const int* centroides) {
+  m->tamanho_lote = tamanho_lote;
+  m->num_clusters = num_clusters;
+  m->num_dimensoes = num_dimensoes;
+  m->centros = (double*)malloc((size_t)num_clusters * num_dimensoes * sizeof(double));
+  m->vistos = (long long*)calloc(num_clusters, sizeof(long long));
+  m->lote = (long long*)malloc((size_t)num_clusters * (num_dimensoes + 1) * sizeof(long long));
+  m->indices = (int*)malloc((size_t)tamanho_lote * sizeof(int));
+  if (m->centros == NULL || m->vistos == NULL || m->lote == NULL || m->indices == NULL) {
+    fprintf(stderr, "Erro: falha ao alocar o estado do mini-lote.\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < (size_t)num_clusters * num_dimensoes; i++) {
+    m->centros[i] = centroides[i];
+  }
+}
+
+static inline void minilote_liberar(EstadoMiniLote* m) {
+  free(m->centros);
+  free(m->vistos);
+  free(m->lote);
+  free(m->indices);
+}
+
+/**
+ * @brief Sorteia 'quantidade' índices (com reposição) em [inicio, inicio + num_pontos)
+ * para o passo 'passo'. 'fluxo' separa sequências independentes (por exemplo, o rank MPI).
+ */
+static inline void minilote_amostrar(EstadoMiniLote* m, int passo, int fluxo, int inicio, int num_pontos,
+                                     int quantidade) {
+  uint64_t base = aleatorio_hash(MINILOTE_SEMENTE ^ ((uint64_t)fluxo << 32)) + (uint64_t)passo * m->tamanho_lote;
+  for (int j = 0; j < quantidade; j++) {
+    m->indices[j] = inicio + (int)(aleatorio_hash(base + j) % (uint64_t)num_pontos);
+  }
+}
+
+/**
+ * @brief Aplica as somas do lote (já reduzidas entre threads/processos) aos centroides
+ * em double e grava a versão arredondada em 'centroides' [k * D + d].
+ */
+static inline void minilote_aplicar(EstadoMiniLote* m, int* centroides) {
+  const int D = m->num_dimensoes, largura = D + 1;
+  for (int k = 0; k < m->num_clusters; k++) {
+    const long long* linha = &m->lote[(size_t)k * largura];
+    const long long n = linha[D];
+    if (n == 0) continue;
+    m->vistos[k] += n;
+    for (int d = 0; d < D; d++) {
+      double* c = &m->centros[(size_t)k * D + d];
+      *c += ((double)linha[d] - n * *c) / (double)m->vistos[k];
+      centroides[(size_t)k * D + d] = (int)lround(*c);
+    }
+  }
+}
+
+#endif
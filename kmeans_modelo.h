@@ -0,0 +1,166 @@
+#ifndef KMEANS_MODELO_H
+#define KMEANS_MODELO_H
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kmeans_simd.h"
+
+// Modelo treinado (opção --modelo=arquivo e kmeans_preditor.c), na ordem de bytes nativa.
+//
+//   [0, 64)        CabecalhoModelo
+//   [64, ...)      num_clusters * num_dimensoes centroides int32, cluster a cluster
+//   se MODELO_FLAG_ESTATISTICAS:
+//                  num_clusters contagens int64 (pontos de treino de cada cluster)
+//                  num_clusters somas de distâncias ao quadrado (double) de cada cluster
+//
+// As estatísticas vêm de uma passada extra sobre os pontos de treino com os
+// centroides finais, fora da região medida. O arquivo é escrito em um temporário
+// e renomeado no final, então quem o relê (o preditor, ao trocar de modelo) nunca
+// encontra um modelo pela metade.
+
+#define MODELO_MAGICA "KMEANSMD"
+#define MODELO_VERSAO 1
+#define MODELO_FLAG_ESTATISTICAS 1u
+
+typedef struct {
+  char magica[8];          // MODELO_MAGICA, sem terminador
+  uint32_t versao;         // MODELO_VERSAO
+  uint32_t num_clusters;
+  uint32_t num_dimensoes;
+  int32_t min_val;         // Faixa dos dados de treino (os centroides ficam dentro dela)
+  int32_t max_val;
+  uint32_t flags;          // MODELO_FLAG_*
+  uint64_t num_pontos;     // Pontos de treino
+  uint32_t iteracoes;      // Iterações executadas no treino
+  uint8_t reservado[20];
+} CabecalhoModelo;
+
+_Static_assert(sizeof(CabecalhoModelo) == 64, "CabecalhoModelo deve ocupar 64 bytes");
+
+typedef struct {
+  CabecalhoModelo cabecalho;
+  int* centroides;       // [k * D + d]
+  long long* contagens;  // [k], NULL sem estatísticas
+  double* sse;           // [k], NULL sem estatísticas
+} ModeloKMeans;
+
+/**
+ * @brief Prepara um modelo com os centroides 'centroides' (copiados) e, com
+ * 'estatisticas', contagens e somas zeradas para modelo_acumular_estatisticas.
+ */
+static inline void modelo_iniciar(ModeloKMeans* m, const int* centroides, int num_clusters, int num_dimensoes,
+                                  int min_val, int max_val, long long num_pontos, int iteracoes, int estatisticas) {
+  CabecalhoModelo* cab = &m->cabecalho;
+  memset(cab, 0, sizeof(*cab));
+  memcpy(cab->magica, MODELO_MAGICA, 8);
+  cab->versao = MODELO_VERSAO;
+  cab->num_clusters = num_clusters;
+  cab->num_dimensoes = num_dimensoes;
+  cab->min_val = min_val;
+  cab->max_val = max_val;
+  cab->flags = estatisticas ? MODELO_FLAG_ESTATISTICAS : 0;
+  cab->num_pontos = num_pontos;
+  cab->iteracoes = iteracoes;
+  size_t bytes = (size_t)num_clusters * num_dimensoes * sizeof(int);
+  m->centroides = (int*)malloc(bytes);
+  m->contagens = estatisticas ? (long long*)calloc(num_clusters, sizeof(long long)) : NULL;
+  m->sse = estatisticas ? (double*)calloc(num_clusters, sizeof(double)) : NULL;
+  if (m->centroides == NULL || (estatisticas && (m->contagens == NULL || m->sse == NULL))) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(m->centroides, centroides, bytes);
+}
+
+static inline void modelo_liberar(ModeloKMeans* m) {
+  free(m->centroides);
+  free(m->contagens);
+  free(m->sse);
+}
+
+/**
+ * @brief Soma às estatísticas do modelo os 'num_pontos' pontos de 'coords' (ponto a
+ * ponto), atribuídos pelo 'kernel' já carregado com os centroides do modelo.
+ */
+static inline void modelo_acumular_estatisticas(ModeloKMeans* m, const KernelAtribuicao* kernel, const int* coords,
+                                                int num_pontos) {
+  const int D = (int)m->cabecalho.num_dimensoes;
+  for (int i = 0; i < num_pontos; i++) {
+    const int* ponto = &coords[(size_t)i * D];
+    const int cluster = kernel_mais_proximo(kernel, ponto);
+    m->contagens[cluster]++;
+    m->sse[cluster] += (double)kernel_distancia(kernel, ponto, cluster);
+  }
+}
+
+/**
+ * @brief Grava o modelo em 'arquivo' (via um temporário renomeado no final).
+ * @return 0 em caso de sucesso, -1 em caso de erro (com mensagem em stderr).
+ */
+static inline int modelo_salvar(const ModeloKMeans* m, const char* arquivo) {
+  const CabecalhoModelo* cab = &m->cabecalho;
+  const size_t K = cab->num_clusters, D = cab->num_dimensoes;
+  char temporario[4096];
+  snprintf(temporario, sizeof(temporario), "%s.tmp.%ld", arquivo, (long)getpid());
+  FILE* f = fopen(temporario, "wb");
+  if (f == NULL) {
+    fprintf(stderr, "Erro: não foi possível criar o modelo '%s'\n", temporario);
+    return -1;
+  }
+  int ok = fwrite(cab, sizeof(*cab), 1, f) == 1 && fwrite(m->centroides, sizeof(int), K * D, f) == K * D;
+  if (ok && (cab->flags & MODELO_FLAG_ESTATISTICAS)) {
+    ok = fwrite(m->contagens, sizeof(long long), K, f) == K && fwrite(m->sse, sizeof(double), K, f) == K;
+  }
+  if (fclose(f) != 0) ok = 0;
+  if (!ok || rename(temporario, arquivo) != 0) {
+    fprintf(stderr, "Erro ao gravar o modelo '%s'\n", arquivo);
+    remove(temporario);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Lê um modelo gravado por modelo_salvar. Não encerra o programa em caso de
+ * erro, para que o preditor possa manter o modelo anterior.
+ * @return 1 se o modelo foi lido, 0 em caso de erro (com mensagem em stderr).
+ */
+static inline int modelo_carregar(const char* arquivo, ModeloKMeans* m) {
+  FILE* f = fopen(arquivo, "rb");
+  if (f == NULL) {
+    fprintf(stderr, "Erro: Não foi possível abrir o modelo '%s'\n", arquivo);
+    return 0;
+  }
+  CabecalhoModelo* cab = &m->cabecalho;
+  if (fread(cab, sizeof(*cab), 1, f) != 1 || memcmp(cab->magica, MODELO_MAGICA, 8) != 0 ||
+      cab->versao != MODELO_VERSAO || cab->num_clusters == 0 || cab->num_dimensoes == 0 ||
+      (uint64_t)cab->num_clusters * cab->num_dimensoes > INT_MAX) {
+    fprintf(stderr, "Erro: '%s' não é um modelo válido.\n", arquivo);
+    fclose(f);
+    return 0;
+  }
+  const size_t K = cab->num_clusters, D = cab->num_dimensoes;
+  const int estatisticas = (cab->flags & MODELO_FLAG_ESTATISTICAS) != 0;
+  m->centroides = (int*)malloc(K * D * sizeof(int));
+  m->contagens = estatisticas ? (long long*)malloc(K * sizeof(long long)) : NULL;
+  m->sse = estatisticas ? (double*)malloc(K * sizeof(double)) : NULL;
+  int ok = m->centroides != NULL && (!estatisticas || (m->contagens != NULL && m->sse != NULL)) &&
+           fread(m->centroides, sizeof(int), K * D, f) == K * D;
+  if (ok && estatisticas) {
+    ok = fread(m->contagens, sizeof(long long), K, f) == K && fread(m->sse, sizeof(double), K, f) == K;
+  }
+  fclose(f);
+  if (!ok) {
+    fprintf(stderr, "Erro: o modelo '%s' está truncado.\n", arquivo);
+    modelo_liberar(m);
+    return 0;
+  }
+  return 1;
+}
+
+#endif
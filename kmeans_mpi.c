@@ -1,67 +1,39 @@
-#define _POSIX_C_SOURCE 199309L  // Necessário para CLOCK_MONOTONIC
-#include <limits.h>              // Para LLONG_MAX
+#define _GNU_SOURCE  // Necessário para CLOCK_MONOTONIC e syscall (perf_event_open)
+#include <limits.h>  // Para LLONG_MAX
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>  // Header correto para clock_gettime e struct timespec
 #include <mpi.h>
 
-// Estrutura para representar um ponto no espaço D-dimensional
-typedef struct {
-  int* coords;     // Vetor de coordenadas inteiras
-  int cluster_id;  // ID do cluster ao qual o ponto pertence
-} Point;
+#include "kmeans_balanceamento.h"
+#include "kmeans_dataset.h"
+#include "kmeans_hamerly.h"
+#include "kmeans_hibrido.h"
+#include "kmeans_incremental.h"
+#include "kmeans_inicializacao.h"
+#include "kmeans_minibatch.h"
+#include "kmeans_modelo.h"
+#include "kmeans_opcoes.h"
+#include "kmeans_perfil.h"
+#include "kmeans_simd.h"
 
 int rank, size;
 
-// --- Funções Utilitárias ---
-
-/**
- * @brief Calcula a distância Euclidiana ao quadrado entre dois pontos com coordenadas inteiras.
- * Usa 'long long' para evitar overflow no cálculo da distância e da diferença.
- * @return A distância Euclidiana ao quadrado como um long long.
- */
-long long euclidean_dist_sq(Point* p1, Point* p2, int num_dimensoes) {
-  long long dist = 0;
-  for (int i = 0; i < num_dimensoes; i++) {
-    long long diff = (long long)p1->coords[i] - p2->coords[i];
-    dist += diff * diff;
-  }
-  return dist;
-}
-
 // --- Funções Principais do K-Means ---
 
-/**
- * @brief Lê os dados de pontos (inteiros) de um arquivo de texto.
- */
-void read_data_from_file(const char* filename, Point* points, int num_pontos, int num_dimensoes) {
-  FILE* file = fopen(filename, "r");
-  if (file == NULL) {
-    fprintf(stderr, "Erro: Não foi possível abrir o arquivo '%s'\n", filename);
-    exit(EXIT_FAILURE);
-  }
-
-  for (int i = 0; i < num_pontos; i++) {
-    for (int j = 0; j < num_dimensoes; j++) {
-      if (fscanf(file, "%d", &points[i].coords[j]) != 1) {
-        fprintf(stderr, "Erro: Arquivo de dados mal formatado ou incompleto.\n");
-        fclose(file);
-        exit(EXIT_FAILURE);
-      }
-    }
-  }
-
-  fclose(file);
-}
-
 /**
  * @brief Inicializa os centroides escolhendo K pontos aleatórios do dataset.
  */
-void initialize_centroids(Point* points, Point* centroids, int num_pontos, int num_clusters, int num_dimensoes) {
+void initialize_centroids(const ConjuntoPontos* points, int* centroids, int num_pontos, int num_clusters,
+                          int num_dimensoes) {
   srand(42);  // Semente fixa para reprodutibilidade
 
   int* indices = (int*)malloc(num_pontos * sizeof(int));
+  if (indices == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    exit(EXIT_FAILURE);
+  }
   for (int i = 0; i < num_pontos; i++) {
     indices[i] = i;
   }
@@ -74,29 +46,117 @@ void initialize_centroids(Point* points, Point* centroids, int num_pontos, int n
   }
 
   for (int i = 0; i < num_clusters; i++) {
-    memcpy(centroids[i].coords, points[indices[i]].coords, num_dimensoes * sizeof(int));
+    memcpy(&centroids[(size_t)i * num_dimensoes], pontos_ponto(points, indices[i]), num_dimensoes * sizeof(int));
   }
 
   free(indices);
 }
 
+/**
+ * @brief Inicialização k-means|| distribuída (opção --inicializacao=paralela, ver
+ * kmeans_inicializacao.h). Cada processo executa as passadas sobre os próprios pontos;
+ * phi e os pesos são somados entre os processos, e os candidatos de cada rodada são
+ * trocados com MPI_Allgatherv em ordem de rank, ou seja, de índice global. Todos os
+ * processos reduzem os mesmos candidatos e obtêm as mesmas sementes das outras versões.
+ * @return O número de candidatos sobreamostrados.
+ */
+int initialize_centroids_kmeans_par(const int* coords, int num_local, long long inicio_global, int num_pontos,
+                                    int num_dimensoes, int num_clusters, uint64_t semente, NivelSimd nivel,
+                                    int* centroides) {
+  const int D = num_dimensoes;
+  CandidatosKMPar c;
+  kmpar_candidatos_iniciar(&c, D, 1 + KMPAR_RODADAS * KMPAR_FATOR * num_clusters);
+  long long* dist2 = (long long*)malloc((num_local > 0 ? num_local : 1) * sizeof(long long));
+  unsigned char* marcados = (unsigned char*)malloc(num_local > 0 ? num_local : 1);
+  int* contagens = (int*)malloc(size * sizeof(int));
+  int* deslocamentos = (int*)malloc(size * sizeof(int));
+  // O primeiro candidato é enviado pelo processo que tem o ponto sorteado
+  int* ponto = (int*)malloc(D * sizeof(int));
+  if (dist2 == NULL || marcados == NULL || contagens == NULL || deslocamentos == NULL || ponto == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+  }
+
+  const long long g = kmpar_primeiro(semente, num_pontos);
+  const long long base = num_pontos / size, resto = num_pontos % size, limite = resto * (base + 1);
+  const int dono = (int)(g < limite ? g / (base + 1) : resto + (g - limite) / base);
+  if (rank == dono) {
+    memcpy(ponto, &coords[(size_t)(g - inicio_global) * D], D * sizeof(int));
+  }
+  MPI_Bcast(ponto, D, MPI_INT, dono, MPI_COMM_WORLD);
+  kmpar_candidatos_adicionar(&c, ponto);
+  free(ponto);
+
+  long long phi_local = kmpar_atualizar_distancias(coords, num_local, &c, 0, nivel, dist2), phi;
+  MPI_Allreduce(&phi_local, &phi, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+  for (int rodada = 0; rodada < KMPAR_RODADAS && phi > 0; rodada++) {
+    const int primeiro = c.num_candidatos;
+    kmpar_sortear(dist2, num_local, inicio_global, phi, num_clusters, semente, rodada, marcados);
+
+    CandidatosKMPar locais;
+    kmpar_candidatos_iniciar(&locais, D, KMPAR_FATOR * num_clusters);
+    for (int i = 0; i < num_local; i++) {
+      if (marcados[i]) kmpar_candidatos_adicionar(&locais, &coords[(size_t)i * D]);
+    }
+    int enviados = locais.num_candidatos * D, total = 0;
+    MPI_Allgather(&enviados, 1, MPI_INT, contagens, 1, MPI_INT, MPI_COMM_WORLD);
+    for (int r = 0; r < size; r++) {
+      deslocamentos[r] = total;
+      total += contagens[r];
+    }
+    int* recebidos = (int*)malloc((total > 0 ? total : 1) * sizeof(int));
+    if (recebidos == NULL) {
+      fprintf(stderr, "Erro: falha de alocação de memória.\n");
+      MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    MPI_Allgatherv(locais.coords, enviados, MPI_INT, recebidos, contagens, deslocamentos, MPI_INT, MPI_COMM_WORLD);
+    for (int j = 0; j < total / D; j++) {
+      kmpar_candidatos_adicionar(&c, &recebidos[(size_t)j * D]);
+    }
+    free(recebidos);
+    kmpar_candidatos_liberar(&locais);
+
+    phi_local = kmpar_atualizar_distancias(coords, num_local, &c, primeiro, nivel, dist2);
+    MPI_Allreduce(&phi_local, &phi, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+  }
+
+  kmpar_pesos(coords, num_local, &c, nivel);
+  MPI_Allreduce(MPI_IN_PLACE, c.pesos, c.num_candidatos, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+  kmpar_reduzir(&c, num_clusters, semente, centroides);
+
+  const int num_candidatos = c.num_candidatos;
+  kmpar_candidatos_liberar(&c);
+  free(dist2);
+  free(marcados);
+  free(contagens);
+  free(deslocamentos);
+  return num_candidatos;
+}
+
 /**
  * @brief Fase de Atribuição: Associa cada ponto ao cluster do centroide mais próximo.
+ * A distância até os centroides é calculada pelo kernel vetorizado de kmeans_simd.h.
+ * Com 'lista' (--incremental), os pontos que mudaram são registrados nela.
+ * @return Número de pontos locais que mudaram de cluster.
  */
-void assign_points_to_clusters(Point* points, Point* centroids, int num_pontos, int num_clusters, int num_dimensoes) {
+long long assign_points_to_clusters(ConjuntoPontos* points, const int* centroids, KernelAtribuicao* kernel,
+                                    const PontosCompactos* compacto, ListaMudancas* lista) {
+  kernel_carregar_centroides(kernel, centroids);
+  const int num_pontos = points->num_pontos;
+  if (points->colunas != NULL || kernel->coords_b != NULL) {
+    return incremental_atribuir_faixa(kernel, points, compacto, 0, num_pontos, lista);
+  }
+  long long mudancas = 0;
+
   for (int i = 0; i < num_pontos; i++) {
-    long long min_dist = LLONG_MAX;
-    int best_cluster = -1;
-
-    for (int j = 0; j < num_clusters; j++) {
-      long long dist = euclidean_dist_sq(&points[i], &centroids[j], num_dimensoes);
-      if (dist < min_dist) {
-        min_dist = dist;
-        best_cluster = j;
-      }
-    }
-    points[i].cluster_id = best_cluster;
+    int cluster_id = compacto->coords != NULL
+                         ? kernel_mais_proximo_compacto(kernel, &compacto->coords[(size_t)i * compacto->largura])
+                         : kernel_mais_proximo(kernel, pontos_ponto(points, i));
+    if (lista != NULL && cluster_id != points->rotulos[i]) incremental_registrar(lista, i, points->rotulos[i]);
+    mudancas += cluster_id != points->rotulos[i];
+    points->rotulos[i] = cluster_id;
   }
+  return mudancas;
 }
 /**
  * Maior problema
@@ -110,43 +170,226 @@ void assign_points_to_clusters(Point* points, Point* centroids, int num_pontos,
  */
 
 /**
- * @brief Fase de Atualização: Recalcula a posição de cada centroide como a média
- * (usando divisão inteira) de todos os pontos atribuídos ao seu cluster.
+ * @brief Fase de Atribuição com poda pela desigualdade triangular (opção --hamerly).
+ * Produz exatamente as mesmas atribuições de assign_points_to_clusters.
+ * Em 'mudancas' é somado o número de pontos que mudaram de cluster.
+ * @return Número de distâncias ponto-centroide efetivamente calculadas.
  */
-void update_centroids(Point* points, Point* centroids, int num_pontos, int num_clusters, int num_dimensoes, int *global_sum, int *global_count) {
-  int* cluster_sums = (int*)calloc(num_clusters * num_dimensoes, sizeof(long long));
-  int* cluster_counts = (int*)calloc(num_clusters, sizeof(int));
+long long assign_points_to_clusters_hamerly(ConjuntoPontos* points, const int* centroids, KernelAtribuicao* kernel,
+                                            EstadoHamerly* hamerly, long long* mudancas, ListaMudancas* lista) {
+  kernel_carregar_centroides(kernel, centroids);
+  hamerly_preparar_iteracao(hamerly, kernel);
+
+  long long avaliacoes = 0;
+  long long* distancias = (long long*)malloc(kernel->num_clusters * sizeof(long long));
+  if (distancias == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+  }
 
-  for (int i = 0; i < num_pontos; i++) {
-    int cluster_id = points[i].cluster_id;
-    cluster_counts[cluster_id]++;
-    for (int j = 0; j < num_dimensoes; j++) {
-      cluster_sums[cluster_id * num_dimensoes + j] += points[i].coords[j];
+  for (int i = 0; i < points->num_pontos; i++) {
+    int atual = hamerly->iniciado ? points->rotulos[i] : -1;
+    int cluster_id =
+        hamerly_atribuir_ponto(hamerly, kernel, i, pontos_ponto(points, i), atual, distancias, &avaliacoes);
+    if (lista != NULL && cluster_id != points->rotulos[i]) incremental_registrar(lista, i, points->rotulos[i]);
+    *mudancas += cluster_id != points->rotulos[i];
+    points->rotulos[i] = cluster_id;
+  }
+
+  free(distancias);
+  hamerly_concluir_iteracao(hamerly);
+  return avaliacoes;
+}
+
+/**
+ * @brief Calcula os centroides a partir das somas e contagens já reduzidas.
+ * @return O maior deslocamento de um centroide, ao quadrado.
+ */
+long long finalize_centroids(int* centroids, int num_clusters, int num_dimensoes, const long long* reducao) {
+  const int largura = num_dimensoes + 1;
+  long long maior_desloc = 0;
+  for (int i = 0; i < num_clusters; i++) {
+    const long long* linha = &reducao[(size_t)i * largura];
+    if (linha[num_dimensoes] > 0) {
+      long long desloc = 0;
+      for (int j = 0; j < num_dimensoes; j++) {
+        // Divisão inteira para manter os centroides em coordenadas discretas
+        int novo = (int)(linha[j] / linha[num_dimensoes]);
+        long long diff = (long long)novo - centroids[i * num_dimensoes + j];
+        desloc += diff * diff;
+        centroids[i * num_dimensoes + j] = novo;
+      }
+      if (desloc > maior_desloc) maior_desloc = desloc;
     }
   }
+  return maior_desloc;
+}
+
+/**
+ * @brief Soma 'dados' entre todos os processos e devolve o total em todos eles: com
+ * 'hibrido' (--hibrido) pela memória compartilhada de cada nó e um MPI_Allreduce entre
+ * os líderes, senão por um MPI_Allreduce entre todos os processos.
+ */
+static void reduzir_somas(long long* dados, int tamanho, Hibrido* hibrido) {
+  if (hibrido != NULL) {
+    hibrido_reduzir(hibrido, dados, tamanho);
+  } else {
+    MPI_Allreduce(MPI_IN_PLACE, dados, tamanho, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+  }
+}
 
-  MPI_Allreduce(cluster_sums, global_sum,
-                  num_clusters * num_dimensoes,
-                  MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+/**
+ * @brief Fase de Atualização: Recalcula a posição de cada centroide como a média
+ * (usando divisão inteira) de todos os pontos atribuídos ao seu cluster.
+ *
+ * As somas e contagens locais ficam em um único buffer de 64 bits ('reducao', com
+ * K * (D + 1) + 1 posições: as D somas de cada cluster seguidas da sua contagem e,
+ * no fim, o número de pontos que mudaram de cluster), somado entre os processos por
+ * um único MPI_Allreduce (ou pela memória compartilhada do nó, com 'hibrido'). Como
+ * todos os processos recebem o total, cada um calcula os centroides localmente, sem
+ * MPI_Bcast.
+ * 'mudancas' entra com a contagem local e sai com o total de todos os processos.
+ * No modo compacto as coordenadas são lidas da cópia em int16.
+ *
+ * Com 'incremental' (--incremental), o que é reduzido é a diferença entre as somas
+ * locais desta iteração e as da anterior (guardadas no estado), e os totais ficam
+ * em 'globais' (mesmo formato de 'reducao'). Depois da primeira iteração a diferença
+ * vem só da lista de mudanças; se ela encheu, cada processo volta a acumular os seus
+ * pontos e subtrai as somas anteriores, sem precisar combinar a decisão com os demais.
+ * Com 'balanceamento' (--balancear), o fim do cálculo local é marcado antes da redução.
+ * @return O maior deslocamento de um centroide, ao quadrado (igual em todos os processos).
+ */
+long long update_centroids(const ConjuntoPontos* points, int* centroids, const PontosCompactos* compacto,
+                           int num_clusters, int num_dimensoes, long long* reducao, long long* mudancas,
+                           EstadoIncremental* incremental, long long* globais, Balanceamento* balanceamento,
+                           Hibrido* hibrido, Perfil* perfil, int iteracao) {
+  const int largura = num_dimensoes + 1;
+  memset(reducao, 0, (size_t)num_clusters * largura * sizeof(long long));
+  reducao[(size_t)num_clusters * largura] = *mudancas;
+
+  if (incremental != NULL && incremental_pronto(incremental)) {
+    const ListaMudancas* lista = &incremental->listas[0];
+    for (int j = 0; j < lista->quantidade; j++) {
+      const int i = lista->pontos[j], antigo = lista->antigos[j], novo = points->rotulos[i];
+      long long* de = &reducao[(size_t)antigo * largura];
+      long long* para = &reducao[(size_t)novo * largura];
+      incremental_mover(de, para, points, compacto, i, num_dimensoes);
+      de[num_dimensoes]--;
+      para[num_dimensoes]++;
+    }
+    incremental_aplicar(lista, points, compacto, incremental->somas, incremental->contagens, num_dimensoes);
+  } else {
+    for (int i = 0; i < points->num_pontos; i++) {
+      long long* linha = &reducao[(size_t)points->rotulos[i] * largura];
+      if (compacto->coords != NULL) {
+        kernel_somar_compacto(linha, &compacto->coords[(size_t)i * compacto->largura], num_dimensoes);
+      } else {
+        kernel_somar(linha, pontos_ponto(points, i), num_dimensoes);
+      }
+      linha[num_dimensoes]++;
+    }
+    if (incremental != NULL) {
+      // Diferença em relação às somas locais da iteração anterior (zero na primeira)
+      for (int k = 0; k < num_clusters; k++) {
+        long long* linha = &reducao[(size_t)k * largura];
+        for (int d = 0; d < num_dimensoes; d++) {
+          const long long soma = linha[d];
+          linha[d] -= incremental->somas[k * num_dimensoes + d];
+          incremental->somas[k * num_dimensoes + d] = soma;
+        }
+        const int contagem = (int)linha[num_dimensoes];
+        linha[num_dimensoes] -= incremental->contagens[k];
+        incremental->contagens[k] = contagem;
+      }
+    }
+  }
+  perfil_fase(perfil, rank, iteracao, FASE_ATUALIZACAO);
+  balanceamento_fim_calculo(balanceamento);
+  if (perfil->ativo) {
+    // Só no modo --perfil: separa a espera pelos processos mais lentos do tempo de comunicação
+    MPI_Barrier(MPI_COMM_WORLD);
+    perfil_fase(perfil, rank, iteracao, FASE_ESPERA);
+  }
 
-  MPI_Allreduce(cluster_counts, global_count,
-                num_clusters,
-                MPI_INT, MPI_SUM, MPI_COMM_WORLD);
-  
+  reduzir_somas(reducao, num_clusters * largura + 1, hibrido);
+  perfil_fase(perfil, rank, iteracao, FASE_REDUCAO);
+  *mudancas = reducao[(size_t)num_clusters * largura];
+  if (incremental != NULL) {
+    for (int x = 0; x < num_clusters * largura; x++) {
+      globais[x] += reducao[x];
+    }
+    incremental_concluir(incremental);
+  }
+  long long maior_desloc =
+      finalize_centroids(centroids, num_clusters, num_dimensoes, incremental != NULL ? globais : reducao);
+  perfil_fase(perfil, rank, iteracao, FASE_ATUALIZACAO);
+  return maior_desloc;
+}
 
-  if(rank == 0) {
-    for (int i = 0; i < num_clusters; i++) {
-      if (global_count[i] > 0) {
-        for (int j = 0; j < num_dimensoes; j++) {
-          // Divisão inteira para manter os centroides em coordenadas discretas
-          centroids[i].coords[j] = global_sum[i * num_dimensoes + j] / global_count[i];
+/**
+ * @brief Fase de Atualização em pipeline (opção --pipeline=B).
+ *
+ * Os pontos locais são ordenados por cluster (counting sort em 'ordem', com os
+ * inícios de cada cluster em 'inicio_cluster') e os clusters são divididos em B
+ * blocos. Assim que as somas de um bloco ficam prontas, a sua redução é iniciada
+ * com MPI_Iallreduce e o processo segue acumulando o bloco seguinte, sobrepondo a
+ * comunicação ao cálculo. O resultado é idêntico ao de update_centroids; a contagem
+ * de mudanças segue junto com o último bloco.
+ */
+long long update_centroids_pipeline(const ConjuntoPontos* points, int* centroids, const PontosCompactos* compacto,
+                                    int num_clusters, int num_dimensoes, long long* reducao, long long* mudancas,
+                                    int num_blocos, int* ordem, int* inicio_cluster, MPI_Request* requisicoes,
+                                    Perfil* perfil, int iteracao) {
+  const int largura = num_dimensoes + 1;
+  const int num_pontos = points->num_pontos;
+  reducao[(size_t)num_clusters * largura] = *mudancas;
+
+  // Counting sort dos pontos locais pelo cluster atribuído
+  memset(inicio_cluster, 0, (num_clusters + 1) * sizeof(int));
+  for (int i = 0; i < num_pontos; i++) {
+    inicio_cluster[points->rotulos[i] + 1]++;
+  }
+  for (int k = 0; k < num_clusters; k++) {
+    inicio_cluster[k + 1] += inicio_cluster[k];
+  }
+  for (int i = 0; i < num_pontos; i++) {
+    ordem[inicio_cluster[points->rotulos[i]]++] = i;
+  }
+  for (int k = num_clusters; k > 0; k--) {
+    inicio_cluster[k] = inicio_cluster[k - 1];
+  }
+  inicio_cluster[0] = 0;
+
+  for (int b = 0; b < num_blocos; b++) {
+    const int primeiro = (int)((long long)num_clusters * b / num_blocos);
+    const int ultimo = (int)((long long)num_clusters * (b + 1) / num_blocos);
+    long long* bloco = &reducao[(size_t)primeiro * largura];
+    memset(bloco, 0, (size_t)(ultimo - primeiro) * largura * sizeof(long long));
+
+    for (int k = primeiro; k < ultimo; k++) {
+      long long* linha = &reducao[(size_t)k * largura];
+      for (int p = inicio_cluster[k]; p < inicio_cluster[k + 1]; p++) {
+        if (compacto->coords != NULL) {
+          kernel_somar_compacto(linha, &compacto->coords[(size_t)ordem[p] * compacto->largura], num_dimensoes);
+        } else {
+          kernel_somar(linha, pontos_ponto(points, ordem[p]), num_dimensoes);
         }
       }
+      linha[num_dimensoes] = inicio_cluster[k + 1] - inicio_cluster[k];
     }
+
+    const int extra = b == num_blocos - 1;  // Posição das mudanças, logo depois do último cluster
+    MPI_Iallreduce(MPI_IN_PLACE, bloco, (ultimo - primeiro) * largura + extra, MPI_LONG_LONG, MPI_SUM,
+                   MPI_COMM_WORLD, &requisicoes[b]);
   }
-  
-  free(cluster_sums);
-  free(cluster_counts);
+  // A comunicação sobreposta ao acúmulo fica na atualização; a reducao é só o que sobra
+  perfil_fase(perfil, rank, iteracao, FASE_ATUALIZACAO);
+  MPI_Waitall(num_blocos, requisicoes, MPI_STATUSES_IGNORE);
+  perfil_fase(perfil, rank, iteracao, FASE_REDUCAO);
+  *mudancas = reducao[(size_t)num_clusters * largura];
+  long long maior_desloc = finalize_centroids(centroids, num_clusters, num_dimensoes, reducao);
+  perfil_fase(perfil, rank, iteracao, FASE_ATUALIZACAO);
+  return maior_desloc;
 }
 /**
  * Ponto secundário
@@ -158,18 +401,79 @@ void update_centroids(Point* points, Point* centroids, int num_pontos, int num_c
  *  centroids -> pública
  */
 
+/**
+ * @brief Passo do K-Means por mini-lotes (opção --minibatch, ver kmeans_minibatch.h).
+ * Cada processo sorteia a sua parte do lote entre os próprios pontos, proporcional ao
+ * número de pontos locais, e as somas do lote são reduzidas em um único MPI_Allreduce
+ * (ou pela memória compartilhada do nó, com 'hibrido').
+ */
+void minibatch_step(const ConjuntoPontos* points, int* centroids, KernelAtribuicao* kernel, EstadoMiniLote* lote,
+                    int passo, int quantidade, Hibrido* hibrido, Perfil* perfil) {
+  const int D = lote->num_dimensoes;
+  const int tamanho = lote->num_clusters * (D + 1);
+  kernel_carregar_centroides(kernel, centroids);
+  memset(lote->lote, 0, tamanho * sizeof(long long));
+
+  if (quantidade > 0) {
+    minilote_amostrar(lote, passo, rank, 0, points->num_pontos, quantidade);
+    for (int j = 0; j < quantidade; j++) {
+      const int* ponto = pontos_ponto(points, lote->indices[j]);
+      long long* linha = &lote->lote[kernel_mais_proximo(kernel, ponto) * (D + 1)];
+      for (int d = 0; d < D; d++) {
+        linha[d] += ponto[d];
+      }
+      linha[D]++;
+    }
+  }
+  perfil_fase(perfil, rank, passo, FASE_ATRIBUICAO);
+
+  reduzir_somas(lote->lote, tamanho, hibrido);
+  perfil_fase(perfil, rank, passo, FASE_REDUCAO);
+  minilote_aplicar(lote, centroids);
+  perfil_fase(perfil, rank, passo, FASE_ATUALIZACAO);
+}
+
+/**
+ * @brief Junta no processo 0 os perfis de todos os processos. Cada um só escreveu na
+ * própria posição (rank), então uma soma reconstrói o perfil completo.
+ */
+void perfil_reunir(Perfil* perfil) {
+  if (!perfil->ativo) return;
+  const int num_tempos = perfil->num_threads * perfil->max_iteracoes * PERFIL_NUM_FASES;
+  const int num_contadores = perfil->num_threads * PERFIL_NUM_FASES * PERFIL_NUM_CONTADORES;
+  MPI_Reduce(rank == 0 ? MPI_IN_PLACE : perfil->tempos, perfil->tempos, num_tempos, MPI_DOUBLE, MPI_SUM, 0,
+             MPI_COMM_WORLD);
+  MPI_Reduce(rank == 0 ? MPI_IN_PLACE : perfil->contadores, perfil->contadores, num_contadores, MPI_UINT64_T,
+             MPI_SUM, 0, MPI_COMM_WORLD);
+  MPI_Reduce(rank == 0 ? MPI_IN_PLACE : perfil->com_contadores, perfil->com_contadores, perfil->num_threads, MPI_INT,
+             MPI_SUM, 0, MPI_COMM_WORLD);
+}
+
+/**
+ * @brief Inércia dos pontos locais: soma das distâncias ao quadrado ao centroide mais próximo.
+ */
+double compute_inertia(const ConjuntoPontos* points, const int* centroids, KernelAtribuicao* kernel) {
+  kernel_carregar_centroides(kernel, centroids);
+  double inercia = 0.0;
+  for (int i = 0; i < points->num_pontos; i++) {
+    const int* ponto = pontos_ponto(points, i);
+    inercia += (double)kernel_distancia(kernel, ponto, kernel_mais_proximo(kernel, ponto));
+  }
+  return inercia;
+}
+
 /**
  * @brief Imprime os resultados finais e o checksum (como long long).
  */
-void print_results(Point* centroids, int num_clusters, int num_dimensoes) {
+void print_results(const int* centroids, int num_clusters, int num_dimensoes) {
   printf("--- Centroides Finais ---\n");
   long long checksum = 0;
   for (int i = 0; i < num_clusters; i++) {
     printf("Centroide %d: [", i);
     for (int j = 0; j < num_dimensoes; j++) {
-      printf("%d", centroids[i].coords[j]);
+      printf("%d", centroids[i * num_dimensoes + j]);
       if (j < num_dimensoes - 1) printf(", ");
-      checksum += centroids[i].coords[j];
+      checksum += centroids[i * num_dimensoes + j];
     }
     printf("]\n");
   }
@@ -183,11 +487,11 @@ void print_results(Point* centroids, int num_clusters, int num_dimensoes) {
  * Linha 1: Tempo de execução em segundos (double)
  * Linha 2: Checksum final (long long)
  */
-void print_time_and_checksum(Point* centroids, int num_clusters, int num_dimensoes, double exec_time) {
+void print_time_and_checksum(const int* centroids, int num_clusters, int num_dimensoes, double exec_time) {
   long long checksum = 0;
   for (int i = 0; i < num_clusters; i++) {
     for (int j = 0; j < num_dimensoes; j++) {
-      checksum += centroids[i].coords[j];
+      checksum += centroids[i * num_dimensoes + j];
     }
   }
   // Saída formatada para o avaliador
@@ -204,8 +508,8 @@ int main(int argc, char* argv[]) {
   double start, stop;
 
   // Validação e leitura dos argumentos de linha de comando
-  if (argc != 6) {
-    fprintf(stderr, "Uso: %s <arquivo_dados> <num_pontos> <num_dimensoes> <num_clusters> <num_iteracoes>\n", argv[0]);
+  if (argc < 6) {
+    fprintf(stderr, "Uso: %s <arquivo_dados> <num_pontos> <num_dimensoes> <num_clusters> <num_iteracoes> [opcoes]\n", argv[0]);
     return EXIT_FAILURE;
   }
 
@@ -215,6 +519,9 @@ int main(int argc, char* argv[]) {
   const int num_clusters = atoi(argv[4]);
   const int num_iteracoes = atoi(argv[5]);
 
+  OpcoesKMeans opcoes;
+  opcoes_ler(argc, argv, 6, &opcoes);
+
   if (num_pontos <= 0 || num_dimensoes <= 0 || num_clusters <= 0 || num_iteracoes <= 0 || num_clusters > num_pontos) {
     fprintf(stderr, "Erro nos parâmetros. Verifique se Numero de pontos, Numero de dimensoes, Numero de clusters,\
                         Numero de Iteracoes > 0 e Numero de clusters <= Numero de pontos.\n");
@@ -223,118 +530,328 @@ int main(int argc, char* argv[]) {
 
   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
   MPI_Comm_size(MPI_COMM_WORLD, &size);
+  if (opcoes.streaming > 0) {
+    if (rank == 0) fprintf(stderr, "Erro: o modo --streaming não está disponível na versão MPI.\n");
+    MPI_Finalize();
+    return EXIT_FAILURE;
+  }
+  if (opcoes.kdtree) {
+    if (rank == 0) fprintf(stderr, "Erro: o modo --kdtree não está disponível na versão MPI.\n");
+    MPI_Finalize();
+    return EXIT_FAILURE;
+  }
+  if (opcoes.execucoes > 0) {
+    if (rank == 0) fprintf(stderr, "Erro: o modo --execucoes não está disponível na versão MPI.\n");
+    MPI_Finalize();
+    return EXIT_FAILURE;
+  }
 
-  int* points_coords;
-  int* cluster_coords;
-  Point* points;
-  Point* centroids;
-
-  centroids = (Point*)malloc(num_clusters * sizeof(Point));
-  cluster_coords = (int *)malloc(num_clusters * num_dimensoes * sizeof(int));
-  for (int i = 0; i < num_clusters; i++) {
-    centroids[i].coords = &cluster_coords[i * num_dimensoes];
+  // No rank 0, 'points' tem o dataset inteiro: um binário é mapeado direto do arquivo,
+  // um de texto é lido para uma matriz alocada
+  ConjuntoPontos points;
+  DatasetBinario binario;
+  int eh_binario = 0;
+  int* centroids = (int*)malloc((size_t)num_clusters * num_dimensoes * sizeof(int));
+  if (centroids == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
   }
 
   if (rank == 0) {
-    points_coords = (int*)malloc(num_pontos * num_dimensoes * sizeof(int));
-    points = (Point*)malloc(num_pontos * sizeof(Point));
-    for (int i = 0; i < num_pontos; i++) {
-      points[i].coords = &points_coords[i * num_dimensoes];
+    int min_lido, max_lido;
+    eh_binario =
+        pontos_carregar(filename, num_pontos, num_dimensoes, 0, &points, &binario, &min_lido, &max_lido);
+    if (!opcoes.inicializacao_paralela) {
+      initialize_centroids(&points, centroids, num_pontos, num_clusters, num_dimensoes);
     }
+  }
 
-    
-
-    read_data_from_file(filename, points, num_pontos, num_dimensoes);
-    initialize_centroids(points, centroids, num_pontos, num_clusters, num_dimensoes);
-  } 
+  // A matriz de coordenadas é contígua, então cada processo recebe a sua faixa de
+  // pontos com um único MPI_Scatterv, contando pontos inteiros (D inteiros cada)
+  MPI_Datatype tipo_ponto;
+  MPI_Type_contiguous(num_dimensoes, MPI_INT, &tipo_ponto);
+  MPI_Type_commit(&tipo_ponto);
 
+  int *send_counts = malloc(sizeof(int) * size);
+  int *send_place = malloc(sizeof(int) * size);
 
-  int *send_counts_coords = malloc(sizeof(int) * size);
-  int *send_place_coords = malloc(sizeof(int) * size);
-  
   int base = num_pontos / size;
   int resto = num_pontos % size;
 
   int local_num_points = base + (rank < resto ? 1 : 0);
-  int* local_points_coords = (int*)malloc(local_num_points * num_dimensoes * sizeof(int));
-  Point* local_points = (Point*)malloc(local_num_points * sizeof(Point));
-
+  // Com --hibrido as faixas ficam na janela compartilhada do nó (ver kmeans_hibrido.h)
+  Hibrido hibrido;
+  ConjuntoPontos local_points;
+  if (opcoes.hibrido) {
+    hibrido_iniciar(&hibrido, rank, num_clusters * (num_dimensoes + 1) + 1);
+    hibrido_alocar_pontos(&hibrido, &local_points, local_num_points, num_dimensoes);
+  } else {
+    pontos_iniciar(&local_points, local_num_points, num_dimensoes, NULL);
+  }
+  Hibrido* estado_hibrido = opcoes.hibrido ? &hibrido : NULL;
 
   if (rank == 0) {
       int offset = 0;
       for (int i = 0; i < size; i++) {
-          int n_points = base + (i < resto ? 1 : 0);
-          send_counts_coords[i] = n_points * num_dimensoes;
-          send_place_coords[i] = offset;
-          offset += send_counts_coords[i];
+          send_counts[i] = base + (i < resto ? 1 : 0);
+          send_place[i] = offset;
+          offset += send_counts[i];
       }
   }
-  
-  MPI_Barrier(MPI_COMM_WORLD);
 
-  MPI_Scatterv(points_coords, send_counts_coords, send_place_coords, MPI_INT,
-                local_points_coords, local_num_points * num_dimensoes, MPI_INT,
-                0, MPI_COMM_WORLD);
-  MPI_Bcast(cluster_coords,
-          num_clusters * num_dimensoes,
-          MPI_INT,
-          0,
-          MPI_COMM_WORLD);
-  
-
-  for (int i = 0; i < local_num_points; i ++){
-    local_points[i].coords = &local_points_coords[i * num_dimensoes];
+  if (opcoes.hibrido) {
+    hibrido_distribuir(&hibrido, rank == 0 ? points.coords : NULL, send_counts, send_place, tipo_ponto,
+                       &local_points);
+  } else {
+    MPI_Scatterv(rank == 0 ? points.coords : NULL, send_counts, send_place, tipo_ponto,
+                 local_points.coords, local_num_points, tipo_ponto,
+                 0, MPI_COMM_WORLD);
+  }
+  // Com --balancear as fronteiras começam nessa mesma divisão e mudam pela vazão medida
+  Balanceamento balanceamento;
+  if (opcoes.balancear) {
+    balanceamento_iniciar(&balanceamento, opcoes.limiar_balanceamento, num_pontos, rank, size);
+  }
+  Balanceamento* estado_balanceamento = opcoes.balancear ? &balanceamento : NULL;
+  if (!opcoes.inicializacao_paralela) {
+    MPI_Bcast(centroids,
+            num_clusters * num_dimensoes,
+            MPI_INT,
+            0,
+            MPI_COMM_WORLD);
   }
 
-  MPI_Barrier(MPI_COMM_WORLD);
-  start = MPI_Wtime();
+  // A faixa precisa ser global: os centroides vêm de pontos de qualquer processo
+  int min_local, max_local, min_val, max_val;
+  simd_faixa(local_points.coords, (size_t)local_num_points * num_dimensoes, &min_local, &max_local);
+  MPI_Allreduce(&min_local, &min_val, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+  MPI_Allreduce(&max_local, &max_val, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  NivelSimd nivel = simd_faixa_segura(min_val, max_val) ? simd_escolher(opcoes.simd) : SIMD_ESCALAR;
+  if (opcoes.inicializacao_paralela) {
+    if (kmpar_faixa_segura(num_pontos, num_dimensoes, min_val, max_val)) {
+      long long inicio_global = (long long)rank * base + (rank < resto ? rank : resto);
+      int candidatos = initialize_centroids_kmeans_par(local_points.coords, local_num_points, inicio_global, num_pontos,
+                                                       num_dimensoes, num_clusters, opcoes.semente, nivel,
+                                                       centroids);
+      if (rank == 0) {
+        fprintf(stderr, "Inicialização k-means||: %d candidatos\n", candidatos);
+      }
+    } else {
+      if (rank == 0) {
+        fprintf(stderr, "Aviso: faixa de valores grande demais para k-means||, usando a inicialização aleatória.\n");
+        initialize_centroids(&points, centroids, num_pontos, num_clusters, num_dimensoes);
+      }
+      MPI_Bcast(centroids, num_clusters * num_dimensoes, MPI_INT, 0, MPI_COMM_WORLD);
+    }
+  }
+  // Com --hibrido o dataset completo não é mais necessário no rank 0
+  if (opcoes.hibrido && rank == 0) {
+    pontos_liberar(&points);
+    if (eh_binario) {
+      dataset_binario_fechar(&binario);
+    }
+    fprintf(stderr, "Híbrido: %d nó(s), até %d processos por nó, pontos enviados por %s\n", hibrido.num_nos,
+            hibrido.processos_no, hibrido.consecutivos ? "nó" : "processo");
+  }
+  KernelAtribuicao kernel;
+  kernel_iniciar(&kernel, nivel, num_clusters, num_dimensoes);
+  EstadoHamerly hamerly;
+  long long avaliacoes = 0;
+  if (opcoes.hamerly) {
+    hamerly_iniciar(&hamerly, local_num_points, num_clusters, num_dimensoes, min_val, max_val);
+  }
+  // A faixa é global, então todos os processos tomam a mesma decisão
+  PontosCompactos compacto = {NULL, 0};
+  if (opcoes.colunas && !opcoes.hamerly && opcoes.minibatch == 0) {
+    pontos_gerar_colunas(&local_points);
+  } else if (!opcoes.hamerly && opcoes.minibatch == 0 &&
+             simd_escolher_armazenamento(opcoes.armazenamento, min_val, max_val, num_dimensoes)) {
+    simd_compactar(local_points.coords, local_num_points, num_dimensoes, min_val, max_val, &compacto);
+    kernel_habilitar_compacto(&kernel);
+  }
+  if (simd_escolher_atribuicao(opcoes.atribuicao, num_clusters, compacto.coords != NULL, min_val, max_val,
+                               num_dimensoes)) {
+    kernel_habilitar_blocado(&kernel, min_val, max_val);
+  }
+  if (rank == 0) {
+    fprintf(stderr, "Kernel de atribuição: %s (D=%d %s), pontos: %s\n", simd_nome(nivel), num_dimensoes,
+            kernel_caminho(&kernel), simd_descrever_pontos(&compacto, local_points.colunas != NULL));
+  }
 
-  for (int iter = 0; iter < num_iteracoes; iter++) {
-    assign_points_to_clusters(local_points, centroids, 
-                              local_num_points, num_clusters, num_dimensoes);
+  // Parte do mini-lote sorteada por este processo, proporcional aos pontos locais
+  EstadoMiniLote minilote;
+  int lote_local = 0;
+  if (opcoes.minibatch > 0) {
+    long long primeiro = (long long)rank * base + (rank < resto ? rank : resto);
+    lote_local = (int)((long long)opcoes.minibatch * (primeiro + local_num_points) / num_pontos -
+                       (long long)opcoes.minibatch * primeiro / num_pontos);
+    minilote_iniciar(&minilote, lote_local > 0 ? lote_local : 1, num_clusters, num_dimensoes, centroids);
+  }
 
-    int *global_sum = calloc(num_clusters * num_dimensoes, sizeof(int));
-    int *global_count = calloc(num_clusters, sizeof(int));
+  // Buffers da fase de atualização, alocados uma única vez
+  long long* reducao = (long long*)malloc(((size_t)num_clusters * (num_dimensoes + 1) + 1) * sizeof(long long));
+  EstadoIncremental incremental;
+  long long* globais = NULL;  // Somas e contagens globais correntes (--incremental)
+  if (opcoes.incremental) {
+    incremental_iniciar(&incremental, local_num_points, num_clusters, num_dimensoes, 1);
+    globais = (long long*)calloc((size_t)num_clusters * (num_dimensoes + 1), sizeof(long long));
+    if (opcoes.pipeline > 0 && rank == 0) {
+      fprintf(stderr, "Aviso: --pipeline é ignorado com --incremental, que reduz só as diferenças.\n");
+    }
+  }
+  EstadoIncremental* estado_incremental = opcoes.incremental ? &incremental : NULL;
+  const int num_blocos = opcoes.incremental ? 0 : opcoes.pipeline < num_clusters ? opcoes.pipeline : num_clusters;
+  int* ordem = NULL;
+  int* inicio_cluster = NULL;
+  MPI_Request* requisicoes = NULL;
+  if (num_blocos > 1) {
+    ordem = (int*)malloc((local_num_points > 0 ? local_num_points : 1) * sizeof(int));
+    inicio_cluster = (int*)malloc((num_clusters + 1) * sizeof(int));
+    requisicoes = (MPI_Request*)malloc(num_blocos * sizeof(MPI_Request));
+  }
 
-    update_centroids(local_points, centroids, local_num_points, num_clusters, num_dimensoes, global_sum, global_count);
+  Perfil perfil;
+  perfil_iniciar(&perfil, opcoes.perfil, size, num_iteracoes);
+  perfil_abrir_contadores(&perfil, rank);
 
-    MPI_Bcast(cluster_coords,
-              num_clusters * num_dimensoes,
-              MPI_INT,
-              0, MPI_COMM_WORLD);
+  MPI_Barrier(MPI_COMM_WORLD);
+  start = MPI_Wtime();
 
-    for (int c = 0; c < num_clusters; c++) {
-        centroids[c].coords = &cluster_coords[c * num_dimensoes];
+  int iteracoes = 0;
+  while (iteracoes < num_iteracoes) {
+    perfil_marcar(&perfil, rank);
+    balanceamento_inicio_iteracao(estado_balanceamento);
+    if (opcoes.minibatch > 0) {
+      minibatch_step(&local_points, centroids, &kernel, &minilote, iteracoes++, lote_local, estado_hibrido,
+                     &perfil);
+      continue;
     }
-    
-    free(global_sum);
-    free(global_count);
-}
+    long long mudancas = 0, maior_desloc;
+    if (opcoes.hamerly) {
+      avaliacoes += assign_points_to_clusters_hamerly(&local_points, centroids, &kernel, &hamerly, &mudancas,
+                                                      incremental_lista(estado_incremental, 0));
+    } else {
+      mudancas = assign_points_to_clusters(&local_points, centroids, &kernel, &compacto,
+                                           incremental_lista(estado_incremental, 0));
+    }
+    perfil_fase(&perfil, rank, iteracoes, FASE_ATRIBUICAO);
+
+    if (num_blocos > 1) {
+      // No pipeline o acúmulo se sobrepõe às reduções, então só a atribuição conta como cálculo
+      balanceamento_fim_calculo(estado_balanceamento);
+      maior_desloc =
+          update_centroids_pipeline(&local_points, centroids, &compacto, num_clusters, num_dimensoes, reducao,
+                                    &mudancas, num_blocos, ordem, inicio_cluster, requisicoes, &perfil, iteracoes);
+    } else {
+      maior_desloc = update_centroids(&local_points, centroids, &compacto, num_clusters, num_dimensoes, reducao,
+                                      &mudancas, estado_incremental, globais, estado_balanceamento,
+                                      estado_hibrido, &perfil, iteracoes);
+    }
+    balanceamento_fim_iteracao(estado_balanceamento);
+    iteracoes++;
+    // Mudanças e deslocamento são globais, então todos os processos param na mesma iteração
+    if (opcoes.convergencia && opcoes_convergiu(&opcoes, mudancas, maior_desloc)) break;
+    if (estado_balanceamento != NULL && iteracoes < num_iteracoes &&
+        balanceamento_verificar(estado_balanceamento, &local_points, &compacto, tipo_ponto)) {
+      local_num_points = local_points.num_pontos;
+      if (num_blocos > 1) {
+        free(ordem);
+        ordem = (int*)malloc((local_num_points > 0 ? local_num_points : 1) * sizeof(int));
+      }
+    }
+  }
 
   MPI_Barrier(MPI_COMM_WORLD);
   stop = MPI_Wtime();
 
-  MPI_Gatherv(local_points_coords, local_num_points * num_dimensoes, MPI_INT,
-            points_coords, send_counts_coords, send_place_coords, MPI_INT,
-            0, MPI_COMM_WORLD);
-  
   double time_taken = stop - start;
 
   // --- Apresentação dos Resultados ---
+  long long avaliacoes_total = 0;
+  if (opcoes.hamerly) {
+    MPI_Reduce(&avaliacoes, &avaliacoes_total, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+  }
+  double inercia_local = 0.0, inercia = 0.0;
+  if (opcoes.minibatch > 0 || opcoes.inercia) {
+    inercia_local = compute_inertia(&local_points, centroids, &kernel);
+    MPI_Reduce(&inercia_local, &inercia, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+  }
+  // Com --estatisticas, cada processo atribui os seus pontos aos centroides finais e
+  // as contagens e somas são reduzidas no rank 0, que grava o modelo
+  ModeloKMeans modelo;
+  if (opcoes.modelo != NULL) {
+    modelo_iniciar(&modelo, centroids, num_clusters, num_dimensoes, min_val, max_val, num_pontos, iteracoes,
+                   opcoes.estatisticas);
+    if (opcoes.estatisticas) {
+      kernel_carregar_centroides(&kernel, centroids);
+      modelo_acumular_estatisticas(&modelo, &kernel, local_points.coords, local_num_points);
+      MPI_Reduce(rank == 0 ? MPI_IN_PLACE : modelo.contagens, modelo.contagens, num_clusters, MPI_LONG_LONG, MPI_SUM,
+                 0, MPI_COMM_WORLD);
+      MPI_Reduce(rank == 0 ? MPI_IN_PLACE : modelo.sse, modelo.sse, num_clusters, MPI_DOUBLE, MPI_SUM, 0,
+                 MPI_COMM_WORLD);
+    }
+  }
+  perfil_reunir(&perfil);
+
   if(rank == 0){
     print_time_and_checksum(centroids, num_clusters, num_dimensoes, time_taken);
+    if (opcoes.hamerly) {
+      fprintf(stderr, "Hamerly: %lld de %lld distâncias calculadas (%.1f%%)\n", avaliacoes_total,
+              (long long)num_pontos * num_clusters * iteracoes,
+              100.0 * avaliacoes_total / ((double)num_pontos * num_clusters * iteracoes));
+    }
+    if (opcoes.convergencia) {
+      fprintf(stderr, "Iterações executadas: %d de %d\n", iteracoes, num_iteracoes);
+    }
+    if (opcoes.minibatch > 0 || opcoes.inercia) {
+      fprintf(stderr, "Inércia final: %.6e\n", inercia);
+    }
+    perfil_escrever(&perfil, "mpi", "processos", num_pontos, num_dimensoes, num_clusters, iteracoes, time_taken);
+    if (opcoes.modelo != NULL && modelo_salvar(&modelo, opcoes.modelo) == 0) {
+      fprintf(stderr, "Modelo gravado em '%s'\n", opcoes.modelo);
+    }
+  }
+  if (opcoes.balancear) {
+    balanceamento_relatar(&balanceamento);
+  }
+  if (opcoes.modelo != NULL) {
+    modelo_liberar(&modelo);
   }
 
   // --- Limpeza ---
-  free(local_points_coords);
-  free(local_points);
-  free(cluster_coords);
-  free(send_counts_coords);
-  free(send_place_coords);
+  perfil_liberar(&perfil);
+  if (opcoes.minibatch > 0) {
+    minilote_liberar(&minilote);
+  }
+  if (opcoes.hamerly) {
+    hamerly_liberar(&hamerly);
+  }
+  if (opcoes.incremental) {
+    incremental_liberar(&incremental);
+  }
+  if (opcoes.balancear) {
+    balanceamento_liberar(&balanceamento);
+  }
+  kernel_liberar(&kernel);
+  free(compacto.coords);
+  free(reducao);
+  free(globais);
+  free(ordem);
+  free(inicio_cluster);
+  free(requisicoes);
+  pontos_liberar(&local_points);
   free(centroids);
-  if (rank == 0) {
-    free(points);
-    free(points_coords);
+  free(send_counts);
+  free(send_place);
+  MPI_Type_free(&tipo_ponto);
+  if (opcoes.hibrido) {
+    hibrido_liberar(&hibrido);
+  }
+  if (rank == 0 && !opcoes.hibrido) {
+    pontos_liberar(&points);
+    if (eh_binario) {
+      dataset_binario_fechar(&binario);
+    }
   }
 
   MPI_Finalize();
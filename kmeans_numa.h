@@ -0,0 +1,296 @@
+#ifndef KMEANS_NUMA_H
+#define KMEANS_NUMA_H
+
+#include <dirent.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kmeans_dataset.h"
+#include "kmeans_simd.h"
+
+// Posicionamento NUMA das versões de memória compartilhada (opção --numa).
+//
+// O Linux coloca cada página no nó da CPU que a toca primeiro (first touch). Como a
+// leitura do dataset é feita antes de as threads de cálculo existirem, as páginas dos
+// pontos acabam no nó de quem leu (ou, num dataset binário, de quem leu o arquivo para
+// o page cache). Com --numa:
+//   - as threads são fixadas em CPUs agrupadas por nó (threads vizinhas no mesmo nó);
+//   - os vetores por ponto são copiados para memória nova, e cada thread copia
+//     exatamente a faixa estática de pontos que vai processar nas iterações;
+//   - cada nó tem a sua réplica do kernel de atribuição (centroides), carregada por
+//     uma thread do próprio nó, e os acumuladores parciais também ficam no nó de quem
+//     os usa.
+// A topologia é lida de /sys (sem libnuma); sem essa informação tudo fica no nó 0.
+
+typedef struct {
+  int num_nos;
+  int num_cpus;
+  int* cpus;  // CPUs permitidas ao processo, agrupadas por nó
+  int* nos;   // nos[c]: nó (renumerado a partir de 0) de cpus[c]
+} TopologiaNuma;
+
+/**
+ * @brief Nó da CPU segundo /sys/devices/system/cpu/cpuN/nodeX, ou -1 se não houver.
+ */
+static inline int numa_no_da_cpu(int cpu) {
+  char caminho[64];
+  snprintf(caminho, sizeof(caminho), "/sys/devices/system/cpu/cpu%d", cpu);
+  DIR* dir = opendir(caminho);
+  if (dir == NULL) return -1;
+  int no = -1;
+  struct dirent* entrada;
+  while ((entrada = readdir(dir)) != NULL) {
+    if (strncmp(entrada->d_name, "node", 4) == 0 && entrada->d_name[4] >= '0' && entrada->d_name[4] <= '9') {
+      no = atoi(entrada->d_name + 4);
+      break;
+    }
+  }
+  closedir(dir);
+  return no;
+}
+
+/**
+ * @brief Lista as CPUs em que o processo pode executar (respeita taskset/cgroups) e
+ * as ordena por nó, mantendo a ordem numérica dentro de cada nó.
+ */
+static inline void numa_detectar(TopologiaNuma* t) {
+  cpu_set_t conjunto;
+  t->num_nos = 1;
+  t->num_cpus = 0;
+  t->cpus = NULL;
+  t->nos = NULL;
+  if (sched_getaffinity(0, sizeof(conjunto), &conjunto) != 0) return;
+  int* cpus = (int*)malloc(CPU_SETSIZE * sizeof(int));
+  int* nos = (int*)malloc(CPU_SETSIZE * sizeof(int));
+  t->cpus = (int*)malloc(CPU_SETSIZE * sizeof(int));
+  t->nos = (int*)malloc(CPU_SETSIZE * sizeof(int));
+  if (cpus == NULL || nos == NULL || t->cpus == NULL || t->nos == NULL) {
+    // Sem a lista de CPUs, segue como um único nó e sem fixar as threads
+    free(cpus);
+    free(nos);
+    free(t->cpus);
+    free(t->nos);
+    t->cpus = NULL;
+    t->nos = NULL;
+    return;
+  }
+  int n = 0, maior_no = 0;
+  for (int c = 0; c < CPU_SETSIZE; c++) {
+    if (!CPU_ISSET(c, &conjunto)) continue;
+    int no = numa_no_da_cpu(c);
+    cpus[n] = c;
+    nos[n] = no > 0 ? no : 0;
+    if (nos[n] > maior_no) maior_no = nos[n];
+    n++;
+  }
+  // Ordenação estável por nó, renumerando os nós presentes como 0, 1, ...
+  t->num_nos = 0;
+  for (int no = 0; no <= maior_no; no++) {
+    int presente = 0;
+    for (int c = 0; c < n; c++) {
+      if (nos[c] != no) continue;
+      t->cpus[t->num_cpus] = cpus[c];
+      t->nos[t->num_cpus++] = t->num_nos;
+      presente = 1;
+    }
+    t->num_nos += presente;
+  }
+  if (t->num_nos == 0) t->num_nos = 1;
+  free(cpus);
+  free(nos);
+}
+
+static inline void numa_topologia_liberar(TopologiaNuma* t) {
+  free(t->cpus);
+  free(t->nos);
+}
+
+/**
+ * @brief Fixa a thread chamadora na CPU da posição id % num_cpus.
+ */
+static inline void numa_fixar(const TopologiaNuma* t, int id) {
+  if (t->num_cpus == 0) return;
+  cpu_set_t conjunto;
+  CPU_ZERO(&conjunto);
+  CPU_SET(t->cpus[id % t->num_cpus], &conjunto);
+  sched_setaffinity(0, sizeof(conjunto), &conjunto);
+}
+
+/**
+ * @brief Decide se o posicionamento NUMA é usado: "auto" quando há mais de um nó.
+ */
+static inline int numa_escolher(const char* pedido, const TopologiaNuma* t) {
+  if (strcmp(pedido, "auto") == 0) return t->num_nos > 1;
+  if (strcmp(pedido, "sim") == 0) return 1;
+  if (strcmp(pedido, "nao") == 0) return 0;
+  fprintf(stderr, "Erro: valor inválido para --numa: '%s' (use auto, sim ou nao)\n", pedido);
+  exit(EXIT_FAILURE);
+}
+
+// --- Cópia dos pontos por first touch ---
+
+typedef struct {
+  int* coords;         // Vetores originais, liberados por numa_migracao_concluir
+  int32_t* rotulos;
+  int* colunas;
+  int16_t* compactos;
+  int coords_proprias;  // 0 quando 'coords' é o mapeamento de um dataset binário
+} MigracaoNuma;
+
+/**
+ * @brief Troca os vetores por ponto de 'p' e 'compacto' por vetores novos, ainda não
+ * tocados, e guarda os originais em 'mig'. Antes de qualquer outro uso, os novos devem
+ * ser preenchidos por numa_migracao_faixa, cada faixa pela thread que vai processá-la.
+ */
+static inline void numa_migracao_iniciar(MigracaoNuma* mig, ConjuntoPontos* p, PontosCompactos* compacto) {
+  const size_t M = (size_t)p->num_pontos, D = (size_t)p->num_dimensoes;
+  mig->coords = p->coords;
+  mig->rotulos = p->rotulos;
+  mig->colunas = p->colunas;
+  mig->compactos = compacto->coords;
+  mig->coords_proprias = p->coords_proprias;
+  p->coords = (int*)pontos_alocar(M * D * sizeof(int));
+  p->coords_proprias = 1;
+  p->rotulos = (int32_t*)pontos_alocar(M * sizeof(int32_t));
+  if (p->colunas != NULL) p->colunas = (int*)pontos_alocar(M * D * sizeof(int));
+  if (compacto->coords != NULL) {
+    compacto->coords = (int16_t*)pontos_alocar(M * compacto->largura * sizeof(int16_t));
+  }
+}
+
+/**
+ * @brief Copia os pontos [inicio, fim) dos vetores originais para os novos.
+ */
+static inline void numa_migracao_faixa(const MigracaoNuma* mig, ConjuntoPontos* p, PontosCompactos* compacto,
+                                       int inicio, int fim) {
+  if (fim <= inicio) return;
+  const size_t M = (size_t)p->num_pontos, D = (size_t)p->num_dimensoes, n = (size_t)(fim - inicio);
+  memcpy(&p->coords[inicio * D], &mig->coords[inicio * D], n * D * sizeof(int));
+  memcpy(&p->rotulos[inicio], &mig->rotulos[inicio], n * sizeof(int32_t));
+  if (p->colunas != NULL) {
+    for (size_t d = 0; d < D; d++) {
+      memcpy(&p->colunas[d * M + inicio], &mig->colunas[d * M + inicio], n * sizeof(int));
+    }
+  }
+  if (compacto->coords != NULL) {
+    const size_t largura = (size_t)compacto->largura;
+    memcpy(&compacto->coords[inicio * largura], &mig->compactos[inicio * largura], n * largura * sizeof(int16_t));
+  }
+}
+
+/**
+ * @brief Libera os vetores originais (o mapeamento de um dataset binário continua
+ * sendo fechado por dataset_binario_fechar).
+ */
+static inline void numa_migracao_concluir(MigracaoNuma* mig) {
+  if (mig->coords_proprias) free(mig->coords);
+  free(mig->rotulos);
+  free(mig->colunas);
+  free(mig->compactos);
+}
+
+// --- Réplicas por nó ---
+
+typedef struct {
+  int ativo;
+  TopologiaNuma topologia;
+  int num_threads;
+  int* no_thread;  // Nó de cada thread
+  int* lider;      // lider[no]: menor thread do nó, que cuida da réplica (-1 se o nó não tem threads)
+  KernelAtribuicao* replicas;  // Kernel de atribuição de cada nó
+  long long** somas;           // Acumuladores parciais de cada nó [no][k * D + d]
+  long long** contagens;       // [no][k]
+  long long** somas_thread;    // Acumuladores privados de cada thread, somados no parcial do nó
+  long long** contagens_thread;
+  int granularidade;           // OpenMP: pontos por unidade da divisão estática entre as threads
+} PosicionamentoNuma;
+
+/**
+ * @brief Detecta a topologia, decide se o posicionamento é usado (opção --numa, ver
+ * numa_escolher) e prepara o mapa thread -> nó para 'num_threads' threads fixadas com
+ * numa_fixar (0 = uma thread por CPU permitida). As réplicas e os acumuladores são
+ * criados depois, na thread líder de cada nó.
+ */
+static inline void numa_iniciar(PosicionamentoNuma* n, const char* pedido, int num_threads) {
+  numa_detectar(&n->topologia);
+  n->ativo = numa_escolher(pedido, &n->topologia);
+  if (num_threads <= 0) num_threads = n->topologia.num_cpus > 0 ? n->topologia.num_cpus : 1;
+  n->num_threads = num_threads;
+  n->no_thread = (int*)malloc(num_threads * sizeof(int));
+  n->lider = (int*)malloc(n->topologia.num_nos * sizeof(int));
+  n->replicas = (KernelAtribuicao*)calloc(n->topologia.num_nos, sizeof(KernelAtribuicao));
+  n->somas = (long long**)calloc(n->topologia.num_nos, sizeof(long long*));
+  n->contagens = (long long**)calloc(n->topologia.num_nos, sizeof(long long*));
+  n->somas_thread = (long long**)calloc(num_threads, sizeof(long long*));
+  n->contagens_thread = (long long**)calloc(num_threads, sizeof(long long*));
+  if (n->no_thread == NULL || n->lider == NULL || n->replicas == NULL || n->somas == NULL || n->contagens == NULL ||
+      n->somas_thread == NULL || n->contagens_thread == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    exit(EXIT_FAILURE);
+  }
+  n->granularidade = 1;
+  for (int no = 0; no < n->topologia.num_nos; no++) {
+    n->lider[no] = -1;
+  }
+  for (int t = 0; t < num_threads; t++) {
+    int no = n->topologia.num_cpus > 0 ? n->topologia.nos[t % n->topologia.num_cpus] : 0;
+    n->no_thread[t] = no;
+    if (n->lider[no] < 0) n->lider[no] = t;
+  }
+}
+
+/**
+ * @brief Executada pela thread líder do nó, já fixada: cria a réplica do kernel, com a
+ * mesma configuração de 'kernel', na memória local.
+ */
+static inline void numa_preparar_replica(PosicionamentoNuma* n, int no, const KernelAtribuicao* kernel) {
+  kernel_replicar(&n->replicas[no], kernel);
+}
+
+/**
+ * @brief Executada pela thread líder do nó, já fixada: aloca e zera os acumuladores
+ * parciais do nó (K x D somas e K contagens) na memória local.
+ */
+static inline void numa_preparar_acumuladores(PosicionamentoNuma* n, int no, int num_clusters, int num_dimensoes) {
+  const size_t K = (size_t)num_clusters, D = (size_t)num_dimensoes;
+  n->somas[no] = (long long*)pontos_alocar(K * D * sizeof(long long));
+  n->contagens[no] = (long long*)pontos_alocar(K * sizeof(long long));
+  memset(n->somas[no], 0, K * D * sizeof(long long));
+  memset(n->contagens[no], 0, K * sizeof(long long));
+}
+
+/**
+ * @brief Executada por cada thread, já fixada: aloca os seus acumuladores privados
+ * (K x D somas e K contagens) na memória do seu nó.
+ */
+static inline void numa_preparar_acumuladores_thread(PosicionamentoNuma* n, int tid, int num_clusters,
+                                                     int num_dimensoes) {
+  const size_t K = (size_t)num_clusters, D = (size_t)num_dimensoes;
+  n->somas_thread[tid] = (long long*)pontos_alocar(K * D * sizeof(long long));
+  n->contagens_thread[tid] = (long long*)pontos_alocar(K * sizeof(long long));
+}
+
+static inline void numa_liberar(PosicionamentoNuma* n) {
+  for (int no = 0; no < n->topologia.num_nos; no++) {
+    if (n->ativo && n->lider[no] >= 0) kernel_liberar(&n->replicas[no]);
+    free(n->somas[no]);
+    free(n->contagens[no]);
+  }
+  for (int t = 0; t < n->num_threads; t++) {
+    free(n->somas_thread[t]);
+    free(n->contagens_thread[t]);
+  }
+  free(n->somas_thread);
+  free(n->contagens_thread);
+  free(n->replicas);
+  free(n->somas);
+  free(n->contagens);
+  free(n->no_thread);
+  free(n->lider);
+  numa_topologia_liberar(&n->topologia);
+}
+
+#endif
@@ -0,0 +1,205 @@
+#ifndef KMEANS_OPCOES_H
+#define KMEANS_OPCOES_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Opções opcionais aceitas depois dos 5 argumentos posicionais, no formato
+// --chave=valor ou --chave. Sem nenhuma opção o comportamento é o da versão
+// de referência, e a saída continua sendo as duas linhas lidas pelo avaliador.
+
+#define OPCOES_STREAMING_PADRAO (1 << 18)  // Pontos por bloco de --streaming sem valor
+#define OPCOES_BALANCEAR_PADRAO 0.1        // Desequilíbrio tolerado por --balancear sem valor
+
+typedef struct {
+  const char* simd;  // Conjunto de instruções do kernel de atribuição: auto, escalar, avx2, avx512
+  const char* armazenamento;  // Tipo dos pontos nas varreduras de Lloyd: auto, int32, int16
+  int colunas;       // Layout dimensão-major na atribuição do Lloyd (--layout=colunas)
+  const char* atribuicao;  // Atribuição do Lloyd sobre pontos int16: auto, direta, blocada
+  int num_threads;   // Threads da versão Pthreads (0 = todas as CPUs disponíveis)
+  const char* numa;  // OpenMP e Pthreads: posicionamento NUMA (kmeans_numa.h): auto, sim, nao
+  int hamerly;       // Atribuição com poda pela desigualdade triangular (kmeans_hamerly.h)
+  int kdtree;        // Atribuição por filtragem em uma árvore KD sobre os pontos (kmeans_kdtree.h)
+  int fundido;       // OpenMP: atribuição e atualização em uma única passada, sem atomic
+  int pipeline;      // MPI: número de blocos de clusters reduzidos com MPI_Iallreduce (0 = desligado)
+  int balancear;     // MPI: redivide os pontos entre os processos pela vazão medida (kmeans_balanceamento.h)
+  double limiar_balanceamento;  // Desequilíbrio dos tempos de cálculo (max / média - 1) que dispara a migração
+  int hibrido;       // MPI: pontos e redução pela memória compartilhada de cada nó (kmeans_hibrido.h)
+  int incremental;   // Atualização pelas mudanças de cluster, com somas mantidas entre iterações
+  int convergencia;  // Encerra antes de num_iteracoes quando as atribuições se estabilizam
+  double tolerancia; // Deslocamento máximo de centroide considerado convergido (0 = nenhum)
+  int minibatch;     // Pontos por passo do K-Means por mini-lotes (0 = Lloyd completo)
+  int inercia;       // Informa a inércia final também no modo Lloyd
+  int execucoes;     // Execuções com sementes diferentes avançadas juntas (kmeans_execucoes.h); 0 = uma só
+  int streaming;     // Pontos por bloco lido do disco a cada passada (kmeans_streaming.h); 0 = pontos carregados
+  int inicializacao_paralela;  // Sementes por k-means|| (kmeans_inicializacao.h) em vez de sorteio uniforme
+  unsigned long long semente;  // Semente da inicialização k-means||
+  const char* perfil;  // Arquivo JSON da instrumentação por fase (kmeans_perfil.h); NULL = desligada
+  const char* modelo;  // Arquivo em que os centroides finais são gravados (kmeans_modelo.h); NULL = não grava
+  int estatisticas;    // Grava no modelo a contagem e a soma das distâncias ao quadrado de cada cluster
+} OpcoesKMeans;
+
+static inline void opcoes_padrao(OpcoesKMeans* op) {
+  op->simd = "auto";
+  op->armazenamento = "auto";
+  op->colunas = 0;
+  op->atribuicao = "auto";
+  op->num_threads = 0;
+  op->numa = "auto";
+  op->hamerly = 0;
+  op->kdtree = 0;
+  op->fundido = 0;
+  op->pipeline = 0;
+  op->balancear = 0;
+  op->limiar_balanceamento = OPCOES_BALANCEAR_PADRAO;
+  op->hibrido = 0;
+  op->incremental = 0;
+  op->convergencia = 0;
+  op->tolerancia = 0.0;
+  op->minibatch = 0;
+  op->inercia = 0;
+  op->execucoes = 0;
+  op->streaming = 0;
+  op->inicializacao_paralela = 0;
+  op->semente = 42;
+  op->perfil = NULL;
+  op->modelo = NULL;
+  op->estatisticas = 0;
+}
+
+/**
+ * @brief Lê as opções a partir de argv[inicio]. Encerra o programa com mensagem
+ * de erro caso encontre uma opção desconhecida.
+ */
+static inline void opcoes_ler(int argc, char* argv[], int inicio, OpcoesKMeans* op) {
+  opcoes_padrao(op);
+  for (int i = inicio; i < argc; i++) {
+    const char* arg = argv[i];
+    if (strncmp(arg, "--simd=", 7) == 0) {
+      op->simd = arg + 7;
+    } else if (strncmp(arg, "--armazenamento=", 16) == 0) {
+      op->armazenamento = arg + 16;
+    } else if (strcmp(arg, "--layout=linhas") == 0) {
+      op->colunas = 0;
+    } else if (strcmp(arg, "--layout=colunas") == 0) {
+      op->colunas = 1;
+    } else if (strncmp(arg, "--atribuicao=", 13) == 0) {
+      op->atribuicao = arg + 13;
+    } else if (strncmp(arg, "--threads=", 10) == 0) {
+      op->num_threads = atoi(arg + 10);
+      if (op->num_threads <= 0) {
+        fprintf(stderr, "Erro: --threads deve ser maior que zero.\n");
+        exit(EXIT_FAILURE);
+      }
+    } else if (strncmp(arg, "--numa=", 7) == 0) {
+      op->numa = arg + 7;
+    } else if (strcmp(arg, "--hamerly") == 0) {
+      op->hamerly = 1;
+    } else if (strcmp(arg, "--kdtree") == 0) {
+      op->kdtree = 1;
+    } else if (strcmp(arg, "--fundido") == 0) {
+      op->fundido = 1;
+    } else if (strncmp(arg, "--pipeline=", 11) == 0) {
+      op->pipeline = atoi(arg + 11);
+      if (op->pipeline <= 0) {
+        fprintf(stderr, "Erro: --pipeline deve ser maior que zero.\n");
+        exit(EXIT_FAILURE);
+      }
+    } else if (strcmp(arg, "--balancear") == 0 || strncmp(arg, "--balancear=", 12) == 0) {
+      op->balancear = 1;
+      op->limiar_balanceamento = arg[11] == '=' ? atof(arg + 12) : OPCOES_BALANCEAR_PADRAO;
+      if (op->limiar_balanceamento < 0.0) {
+        fprintf(stderr, "Erro: o limiar de --balancear não pode ser negativo.\n");
+        exit(EXIT_FAILURE);
+      }
+    } else if (strcmp(arg, "--hibrido") == 0) {
+      op->hibrido = 1;
+    } else if (strcmp(arg, "--incremental") == 0) {
+      op->incremental = 1;
+    } else if (strcmp(arg, "--convergencia") == 0 || strncmp(arg, "--convergencia=", 15) == 0) {
+      op->convergencia = 1;
+      op->tolerancia = arg[14] == '=' ? atof(arg + 15) : 0.0;
+      if (op->tolerancia < 0.0) {
+        fprintf(stderr, "Erro: a tolerância de --convergencia não pode ser negativa.\n");
+        exit(EXIT_FAILURE);
+      }
+    } else if (strncmp(arg, "--minibatch=", 12) == 0) {
+      op->minibatch = atoi(arg + 12);
+      if (op->minibatch <= 0) {
+        fprintf(stderr, "Erro: --minibatch deve ser maior que zero.\n");
+        exit(EXIT_FAILURE);
+      }
+    } else if (strcmp(arg, "--inercia") == 0) {
+      op->inercia = 1;
+    } else if (strncmp(arg, "--execucoes=", 12) == 0) {
+      op->execucoes = atoi(arg + 12);
+      if (op->execucoes <= 0) {
+        fprintf(stderr, "Erro: --execucoes deve ser maior que zero.\n");
+        exit(EXIT_FAILURE);
+      }
+    } else if (strcmp(arg, "--streaming") == 0 || strncmp(arg, "--streaming=", 12) == 0) {
+      op->streaming = arg[11] == '=' ? atoi(arg + 12) : OPCOES_STREAMING_PADRAO;
+      if (op->streaming <= 0) {
+        fprintf(stderr, "Erro: --streaming deve ser maior que zero.\n");
+        exit(EXIT_FAILURE);
+      }
+    } else if (strcmp(arg, "--inicializacao=aleatoria") == 0) {
+      op->inicializacao_paralela = 0;
+    } else if (strcmp(arg, "--inicializacao=paralela") == 0) {
+      op->inicializacao_paralela = 1;
+    } else if (strncmp(arg, "--semente=", 10) == 0) {
+      op->semente = strtoull(arg + 10, NULL, 10);
+    } else if (strncmp(arg, "--perfil=", 9) == 0 && arg[9] != '\0') {
+      op->perfil = arg + 9;
+    } else if (strncmp(arg, "--modelo=", 9) == 0 && arg[9] != '\0') {
+      op->modelo = arg + 9;
+    } else if (strcmp(arg, "--estatisticas") == 0) {
+      op->estatisticas = 1;
+    } else {
+      fprintf(stderr, "Erro: opção desconhecida '%s'\n", arg);
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (op->streaming > 0 && (op->hamerly || op->minibatch > 0 || op->incremental || op->inicializacao_paralela)) {
+    fprintf(stderr, "Erro: --streaming não pode ser combinado com --hamerly, --minibatch, --incremental nem "
+                    "--inicializacao=paralela, que precisam de acesso aleatório aos pontos.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (op->kdtree && (op->hamerly || op->minibatch > 0 || op->incremental || op->streaming > 0)) {
+    fprintf(stderr, "Erro: --kdtree não pode ser combinado com --hamerly, --minibatch, --incremental nem "
+                    "--streaming.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (op->execucoes > 0 &&
+      (op->hamerly || op->kdtree || op->minibatch > 0 || op->incremental || op->streaming > 0)) {
+    fprintf(stderr, "Erro: --execucoes não pode ser combinado com --hamerly, --kdtree, --minibatch, --incremental "
+                    "nem --streaming.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (op->balancear && (op->hamerly || op->minibatch > 0 || op->incremental)) {
+    fprintf(stderr, "Erro: --balancear não pode ser combinado com --hamerly, --minibatch nem --incremental, que "
+                    "mantêm estado por ponto local.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (op->hibrido && (op->pipeline > 0 || op->balancear)) {
+    fprintf(stderr, "Erro: --hibrido não pode ser combinado com --pipeline nem --balancear.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (op->estatisticas && op->modelo == NULL) {
+    fprintf(stderr, "Erro: --estatisticas requer --modelo=arquivo.\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+/**
+ * @brief Critério de parada do modo --convergencia: nenhum ponto mudou de cluster na
+ * última atribuição, ou o maior deslocamento de centroide (ao quadrado, em inteiros)
+ * não passou da tolerância. Com tolerância 0 a parada é exata: as iterações restantes
+ * não mudariam mais os centroides.
+ */
+static inline int opcoes_convergiu(const OpcoesKMeans* op, long long mudancas, long long maior_desloc_quadrado) {
+  return mudancas == 0 || (double)maior_desloc_quadrado <= op->tolerancia * op->tolerancia;
+}
+
+#endif
@@ -1,5 +1,5 @@
-#define _POSIX_C_SOURCE 199309L  // Necessário para CLOCK_MONOTONIC
-#include <limits.h>              // Para LLONG_MAX
+#define _GNU_SOURCE  // Necessário para CLOCK_MONOTONIC, sched_setaffinity e syscall (perf_event_open)
+#include <limits.h>  // Para LLONG_MAX
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,61 +7,69 @@
 
 #include <omp.h>
 
-// Estrutura para representar um ponto no espaço D-dimensional
+#include "kmeans_dataset.h"
+#include "kmeans_execucoes.h"
+#include "kmeans_hamerly.h"
+#include "kmeans_incremental.h"
+#include "kmeans_inicializacao.h"
+#include "kmeans_kdtree.h"
+#include "kmeans_minibatch.h"
+#include "kmeans_modelo.h"
+#include "kmeans_numa.h"
+#include "kmeans_opcoes.h"
+#include "kmeans_perfil.h"
+#include "kmeans_simd.h"
+#include "kmeans_streaming.h"
+
+#define LINHA_CACHE 64
+#define TAM_BLOCO_ATRIBUICAO 1024  // Pontos por bloco nas atribuições em colunas e blocada
+
+// Acumuladores privados de cada thread para o modo --fundido. Cada buffer é
+// alinhado e arredondado para a linha de cache, sem falso compartilhamento.
 typedef struct {
-  int* coords;     // Vetor de coordenadas inteiras
-  int cluster_id;  // ID do cluster ao qual o ponto pertence
-} Point;
+  int num_threads;
+  long long** somas;       // [thread][k * D + d]
+  long long** contagens;   // [thread][k]
+  long long** distancias;  // [thread][k], usado apenas com --hamerly
+} AcumuladoresThread;
 
 
 // --- Funções Utilitárias ---
 
 /**
- * @brief Calcula a distância Euclidiana ao quadrado entre dois pontos com coordenadas inteiras.
- * Usa 'long long' para evitar overflow no cálculo da distância e da diferença.
- * @return A distância Euclidiana ao quadrado como um long long.
+ * @brief Início de uma região paralela no modo --perfil. As demais threads começam a
+ * medir aqui; a thread 0 continua o trecho que abriu antes da região, incluindo o
+ * trabalho serial que fez entre as regiões.
  */
-long long euclidean_dist_sq(Point* p1, Point* p2, int num_dimensoes) {
-  long long dist = 0;
-  for (int i = 0; i < num_dimensoes; i++) {
-    long long diff = (long long)p1->coords[i] - p2->coords[i];
-    dist += diff * diff;
-  }
-  return dist;
+static inline void perfil_regiao(Perfil* perfil, int tid) {
+  if (tid != 0) perfil_marcar(perfil, tid);
 }
 
-// --- Funções Principais do K-Means ---
-
 /**
- * @brief Lê os dados de pontos (inteiros) de um arquivo de texto.
+ * @brief Espera medida no modo --perfil: barreira explícita cuja espera é registrada
+ * por thread. Sem --perfil não faz nada, e a barreira implícita do fim da região (ou
+ * do 'omp for' seguinte) sincroniza as threads como antes.
  */
-void read_data_from_file(const char* filename, Point* points, int num_pontos, int num_dimensoes) {
-  FILE* file = fopen(filename, "r");
-  if (file == NULL) {
-    fprintf(stderr, "Erro: Não foi possível abrir o arquivo '%s'\n", filename);
-    exit(EXIT_FAILURE);
-  }
-
-  for (int i = 0; i < num_pontos; i++) {
-    for (int j = 0; j < num_dimensoes; j++) {
-      if (fscanf(file, "%d", &points[i].coords[j]) != 1) {
-        fprintf(stderr, "Erro: Arquivo de dados mal formatado ou incompleto.\n");
-        fclose(file);
-        exit(EXIT_FAILURE);
-      }
-    }
-  }
-
-  fclose(file);
+static inline void perfil_barreira(Perfil* perfil, int tid, int iteracao) {
+  if (!perfil->ativo) return;
+  #pragma omp barrier
+  perfil_fase(perfil, tid, iteracao, FASE_ESPERA);
 }
 
+// --- Funções Principais do K-Means ---
+
 /**
  * @brief Inicializa os centroides escolhendo K pontos aleatórios do dataset.
  */
-void initialize_centroids(Point* points, Point* centroids, int num_pontos, int num_clusters, int num_dimensoes) {
+void initialize_centroids(const ConjuntoPontos* points, int* centroids, int num_pontos, int num_clusters,
+                          int num_dimensoes) {
   srand(42);  // Semente fixa para reprodutibilidade
 
   int* indices = (int*)malloc(num_pontos * sizeof(int));
+  if (indices == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    exit(EXIT_FAILURE);
+  }
   for (int i = 0; i < num_pontos; i++) {
     indices[i] = i;
   }
@@ -74,30 +82,82 @@ void initialize_centroids(Point* points, Point* centroids, int num_pontos, int n
   }
 
   for (int i = 0; i < num_clusters; i++) {
-    memcpy(centroids[i].coords, points[indices[i]].coords, num_dimensoes * sizeof(int));
+    memcpy(&centroids[(size_t)i * num_dimensoes], pontos_ponto(points, indices[i]), num_dimensoes * sizeof(int));
   }
 
   free(indices);
 }
 
+/**
+ * @brief Faixa de pontos [*inicio, *fim) da thread 'tid' entre 'T' threads, dividida como
+ * o schedule(static) sem chunk: unidades contíguas de 'granularidade' pontos, com uma
+ * unidade a mais para as (unidades % T) primeiras threads. A atribuição, a acumulação
+ * do --numa e a cópia por first touch usam a mesma divisão, então cada thread lê as
+ * páginas que ela mesma tocou primeiro.
+ */
+static inline void faixa_thread(int num_pontos, int granularidade, int tid, int T, int* inicio, int* fim) {
+  const int unidades = (num_pontos + granularidade - 1) / granularidade;
+  const int base = unidades / T, resto = unidades % T;
+  const long long primeira = (long long)tid * base + (tid < resto ? tid : resto);
+  const long long ultima = primeira + base + (tid < resto);
+  *inicio = (int)(primeira * granularidade < num_pontos ? primeira * granularidade : num_pontos);
+  *fim = (int)(ultima * granularidade < num_pontos ? ultima * granularidade : num_pontos);
+}
+
 /**
  * @brief Fase de Atribuição: Associa cada ponto ao cluster do centroide mais próximo.
+ * A distância até os centroides é calculada pelo kernel vetorizado de kmeans_simd.h.
+ * Com --numa cada thread usa a réplica do kernel do seu nó. Com --incremental cada
+ * thread registra na sua lista os pontos que mudaram de cluster.
+ * @return Número de pontos que mudaram de cluster.
  */
-void assign_points_to_clusters(Point* points, Point* centroids, int num_pontos, int num_clusters, int num_dimensoes) {
-  #pragma omp parallel for
-  for (int i = 0; i < num_pontos; i++) {
-    long long min_dist = LLONG_MAX;
-    int best_cluster = -1;
+long long assign_points_to_clusters(ConjuntoPontos* points, const int* centroids, KernelAtribuicao* kernel,
+                                    const PontosCompactos* compacto, const PosicionamentoNuma* numa,
+                                    EstadoIncremental* incremental, Perfil* perfil, int iteracao) {
+  const int num_pontos = points->num_pontos;
+  const int por_blocos = points->colunas != NULL || kernel->coords_b != NULL;
+  long long mudancas = 0;
+  if (!numa->ativo) {
+    kernel_carregar_centroides(kernel, centroids);
+  }
+
+  #pragma omp parallel reduction(+ : mudancas)
+  {
+    const int tid = omp_get_thread_num();
+    int inicio, fim;
+    faixa_thread(num_pontos, por_blocos ? TAM_BLOCO_ATRIBUICAO : 1, tid, omp_get_num_threads(), &inicio, &fim);
+    const KernelAtribuicao* k = kernel;
+    ListaMudancas* lista = incremental_lista(incremental, tid);
+    perfil_regiao(perfil, tid);
+    if (numa->ativo) {
+      const int no = numa->no_thread[tid];
+      if (numa->lider[no] == tid) kernel_carregar_centroides(&numa->replicas[no], centroids);
+      k = &numa->replicas[no];
+      perfil_fase(perfil, tid, iteracao, FASE_ATRIBUICAO);
+      #pragma omp barrier
+      perfil_fase(perfil, tid, iteracao, FASE_ESPERA);
+    }
 
-    for (int j = 0; j < num_clusters; j++) {
-      long long dist = euclidean_dist_sq(&points[i], &centroids[j], num_dimensoes);
-      if (dist < min_dist) {
-        min_dist = dist;
-        best_cluster = j;
+    if (por_blocos) {
+      // Blocos de pontos consecutivos, cada um atribuído pelo kernel de colunas ou blocado
+      for (int ini = inicio; ini < fim; ini += TAM_BLOCO_ATRIBUICAO) {
+        const int fim_bloco = ini + TAM_BLOCO_ATRIBUICAO < fim ? ini + TAM_BLOCO_ATRIBUICAO : fim;
+        mudancas += incremental_atribuir_faixa(k, points, compacto, ini, fim_bloco, lista);
+      }
+    } else {
+      for (int i = inicio; i < fim; i++) {
+        int cluster_id = compacto->coords != NULL
+                             ? kernel_mais_proximo_compacto(k, &compacto->coords[(size_t)i * compacto->largura])
+                             : kernel_mais_proximo(k, pontos_ponto(points, i));
+        if (lista != NULL && cluster_id != points->rotulos[i]) incremental_registrar(lista, i, points->rotulos[i]);
+        mudancas += cluster_id != points->rotulos[i];
+        points->rotulos[i] = cluster_id;
       }
     }
-    points[i].cluster_id = best_cluster;
+    perfil_fase(perfil, tid, iteracao, FASE_ATRIBUICAO);
+    perfil_barreira(perfil, tid, iteracao);
   }
+  return mudancas;
 }
 /**
  * Maior problema
@@ -111,35 +171,226 @@ void assign_points_to_clusters(Point* points, Point* centroids, int num_pontos,
  */
 
 /**
- * @brief Fase de Atualização: Recalcula a posição de cada centroide como a média
- * (usando divisão inteira) de todos os pontos atribuídos ao seu cluster.
+ * @brief Fase de Atribuição com poda pela desigualdade triangular (opção --hamerly).
+ * Produz exatamente as mesmas atribuições de assign_points_to_clusters.
+ * Em 'mudancas' é somado o número de pontos que mudaram de cluster.
+ * @return Número de distâncias ponto-centroide efetivamente calculadas.
  */
-void update_centroids(Point* points, Point* centroids, int num_pontos, int num_clusters, int num_dimensoes) {
-  long long* cluster_sums = (long long*)calloc(num_clusters * num_dimensoes, sizeof(long long));
-  int* cluster_counts = (int*)calloc(num_clusters, sizeof(int));
- 
-  #pragma omp parallel for
-  for (int i = 0; i < num_pontos; i++) {
-    int cluster_id = points[i].cluster_id;
-    #pragma omp atomic
-    cluster_counts[cluster_id]++;
+long long assign_points_to_clusters_hamerly(ConjuntoPontos* points, const int* centroids, KernelAtribuicao* kernel,
+                                            EstadoHamerly* hamerly, long long* mudancas,
+                                            EstadoIncremental* incremental, Perfil* perfil, int iteracao) {
+  kernel_carregar_centroides(kernel, centroids);
+  hamerly_preparar_iteracao(hamerly, kernel);
+
+  long long avaliacoes = 0, mudados = 0;
+
+  #pragma omp parallel reduction(+ : avaliacoes, mudados)
+  {
+    const int tid = omp_get_thread_num();
+    perfil_regiao(perfil, tid);
+    long long* distancias = (long long*)malloc(kernel->num_clusters * sizeof(long long));
+    if (distancias == NULL) {
+      fprintf(stderr, "Erro: falha de alocação de memória.\n");
+      exit(EXIT_FAILURE);
+    }
+    ListaMudancas* lista = incremental_lista(incremental, tid);
+    #pragma omp for nowait
+    for (int i = 0; i < points->num_pontos; i++) {
+      int atual = hamerly->iniciado ? points->rotulos[i] : -1;
+      int cluster_id =
+          hamerly_atribuir_ponto(hamerly, kernel, i, pontos_ponto(points, i), atual, distancias, &avaliacoes);
+      if (lista != NULL && cluster_id != points->rotulos[i]) incremental_registrar(lista, i, points->rotulos[i]);
+      mudados += cluster_id != points->rotulos[i];
+      points->rotulos[i] = cluster_id;
+    }
+    free(distancias);
+    perfil_fase(perfil, tid, iteracao, FASE_ATRIBUICAO);
+    perfil_barreira(perfil, tid, iteracao);
+  }
+  hamerly_concluir_iteracao(hamerly);
+  perfil_fase(perfil, 0, iteracao, FASE_ATRIBUICAO);
+  *mudancas += mudados;
+  return avaliacoes;
+}
+
+/**
+ * @brief Soma as coordenadas do ponto i em 'soma' com atomic. No modo compacto as
+ * coordenadas são lidas da cópia em int16.
+ */
+static inline void somar_ponto_atomico(long long* soma, const ConjuntoPontos* points, const PontosCompactos* compacto,
+                                       int i, int num_dimensoes) {
+  if (compacto->coords != NULL) {
+    const int16_t* p = &compacto->coords[(size_t)i * compacto->largura];
+    for (int j = 0; j < num_dimensoes; j++) {
+      #pragma omp atomic
+      soma[j] += p[j];
+    }
+  } else {
+    const int* p = pontos_ponto(points, i);
     for (int j = 0; j < num_dimensoes; j++) {
       #pragma omp atomic
-      cluster_sums[cluster_id * num_dimensoes + j] += points[i].coords[j];
+      soma[j] += p[j];
+    }
+  }
+}
+
+/**
+ * @brief Acumulação da opção --numa: cada thread soma os pontos da sua faixa (a mesma
+ * da atribuição) nos seus acumuladores privados, sem atomic; depois as threads de cada
+ * nó dividem entre si as posições do parcial do nó e somam nelas os acumuladores das
+ * threads do nó, em ordem fixa. Os parciais dos nós são somados por update_centroids.
+ */
+static void acumular_por_no(const ConjuntoPontos* points, const PontosCompactos* compacto,
+                            const PosicionamentoNuma* numa, int num_clusters, int num_dimensoes, Perfil* perfil,
+                            int iteracao) {
+  const int tamanho = num_clusters * num_dimensoes;
+  #pragma omp parallel
+  {
+    const int tid = omp_get_thread_num(), T = omp_get_num_threads(), no = numa->no_thread[tid];
+    long long* somas = numa->somas_thread[tid];
+    long long* contagens = numa->contagens_thread[tid];
+    perfil_regiao(perfil, tid);
+    memset(somas, 0, (size_t)tamanho * sizeof(long long));
+    memset(contagens, 0, (size_t)num_clusters * sizeof(long long));
+    int inicio, fim;
+    faixa_thread(points->num_pontos, numa->granularidade, tid, T, &inicio, &fim);
+    for (int i = inicio; i < fim; i++) {
+      const int cluster_id = points->rotulos[i];
+      contagens[cluster_id]++;
+      if (compacto->coords != NULL) {
+        kernel_somar_compacto(&somas[cluster_id * num_dimensoes], &compacto->coords[(size_t)i * compacto->largura],
+                              num_dimensoes);
+      } else {
+        kernel_somar(&somas[cluster_id * num_dimensoes], pontos_ponto(points, i), num_dimensoes);
+      }
+    }
+    perfil_fase(perfil, tid, iteracao, FASE_ATUALIZACAO);
+    #pragma omp barrier
+    perfil_fase(perfil, tid, iteracao, FASE_ESPERA);
+
+    // Posição desta thread entre as threads do nó, e quantas são
+    int posicao = 0, threads_no = 0;
+    for (int t = 0; t < T; t++) {
+      if (numa->no_thread[t] != no) continue;
+      if (t < tid) posicao++;
+      threads_no++;
     }
+    const int ini_somas = (int)((long long)tamanho * posicao / threads_no);
+    const int fim_somas = (int)((long long)tamanho * (posicao + 1) / threads_no);
+    const int ini_contagens = num_clusters * posicao / threads_no;
+    const int fim_contagens = num_clusters * (posicao + 1) / threads_no;
+    long long* parcial_somas = numa->somas[no];
+    long long* parcial_contagens = numa->contagens[no];
+    memset(&parcial_somas[ini_somas], 0, (size_t)(fim_somas - ini_somas) * sizeof(long long));
+    memset(&parcial_contagens[ini_contagens], 0, (size_t)(fim_contagens - ini_contagens) * sizeof(long long));
+    for (int t = 0; t < T; t++) {
+      if (numa->no_thread[t] != no) continue;
+      const long long* somas_t = numa->somas_thread[t];
+      const long long* contagens_t = numa->contagens_thread[t];
+      for (int x = ini_somas; x < fim_somas; x++) {
+        parcial_somas[x] += somas_t[x];
+      }
+      for (int x = ini_contagens; x < fim_contagens; x++) {
+        parcial_contagens[x] += contagens_t[x];
+      }
+    }
+    perfil_fase(perfil, tid, iteracao, FASE_REDUCAO);
+    perfil_barreira(perfil, tid, iteracao);
   }
+}
 
+/**
+ * @brief Calcula os centroides a partir das somas e contagens de cada cluster.
+ * Clusters vazios mantêm o centroide anterior.
+ * @return O maior deslocamento de um centroide, ao quadrado.
+ */
+long long finalize_centroids(int* centroids, int num_clusters, int num_dimensoes, const long long* cluster_sums,
+                             const int* cluster_counts) {
+  long long maior_desloc = 0;
   for (int i = 0; i < num_clusters; i++) {
     if (cluster_counts[i] > 0) {
+      long long desloc = 0;
       for (int j = 0; j < num_dimensoes; j++) {
         // Divisão inteira para manter os centroides em coordenadas discretas
-        centroids[i].coords[j] = cluster_sums[i * num_dimensoes + j] / cluster_counts[i];
+        int novo = cluster_sums[i * num_dimensoes + j] / cluster_counts[i];
+        long long diff = (long long)novo - centroids[i * num_dimensoes + j];
+        desloc += diff * diff;
+        centroids[i * num_dimensoes + j] = novo;
       }
+      if (desloc > maior_desloc) maior_desloc = desloc;
     }
   }
+  return maior_desloc;
+}
 
-  free(cluster_sums);
-  free(cluster_counts);
+/**
+ * @brief Fase de Atualização: Recalcula a posição de cada centroide como a média
+ * (usando divisão inteira) de todos os pontos atribuídos ao seu cluster.
+ * Com --numa os parciais de cada nó são somados aqui, em ordem fixa.
+ * Com --incremental as somas são as correntes do estado e, depois da primeira
+ * iteração, só as mudanças registradas nas listas das threads são aplicadas nelas.
+ * @return O maior deslocamento de um centroide, ao quadrado.
+ */
+long long update_centroids(const ConjuntoPontos* points, int* centroids, const PontosCompactos* compacto,
+                           int num_clusters, int num_dimensoes, const PosicionamentoNuma* numa,
+                           EstadoIncremental* incremental, Perfil* perfil, int iteracao) {
+  long long* cluster_sums = incremental != NULL ? incremental->somas
+                                                : (long long*)calloc(num_clusters * num_dimensoes, sizeof(long long));
+  int* cluster_counts = incremental != NULL ? incremental->contagens : (int*)calloc(num_clusters, sizeof(int));
+  if (cluster_sums == NULL || cluster_counts == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    exit(EXIT_FAILURE);
+  }
+  const int por_mudancas = incremental != NULL && incremental_pronto(incremental);
+  if (incremental != NULL && !por_mudancas) {
+    memset(cluster_sums, 0, (size_t)num_clusters * num_dimensoes * sizeof(long long));
+    memset(cluster_counts, 0, (size_t)num_clusters * sizeof(int));
+  }
+ 
+  if (por_mudancas) {
+    // O(mudanças): as listas das threads são aplicadas em série, sem atomic
+    for (int l = 0; l < incremental->num_listas; l++) {
+      incremental_aplicar(&incremental->listas[l], points, compacto, cluster_sums, cluster_counts, num_dimensoes);
+    }
+  } else if (numa->ativo) {
+    acumular_por_no(points, compacto, numa, num_clusters, num_dimensoes, perfil, iteracao);
+    for (int no = 0; no < numa->topologia.num_nos; no++) {
+      if (numa->lider[no] < 0) continue;
+      for (int i = 0; i < num_clusters; i++) {
+        cluster_counts[i] += numa->contagens[no][i];
+      }
+      for (int i = 0; i < num_clusters * num_dimensoes; i++) {
+        cluster_sums[i] += numa->somas[no][i];
+      }
+    }
+    perfil_fase(perfil, 0, iteracao, FASE_REDUCAO);
+  } else {
+    #pragma omp parallel
+    {
+      const int tid = omp_get_thread_num();
+      perfil_regiao(perfil, tid);
+      #pragma omp for schedule(static) nowait
+      for (int i = 0; i < points->num_pontos; i++) {
+        int cluster_id = points->rotulos[i];
+        #pragma omp atomic
+        cluster_counts[cluster_id]++;
+        somar_ponto_atomico(&cluster_sums[cluster_id * num_dimensoes], points, compacto, i, num_dimensoes);
+      }
+      perfil_fase(perfil, tid, iteracao, FASE_ATUALIZACAO);
+      perfil_barreira(perfil, tid, iteracao);
+    }
+  }
+
+  long long maior_desloc = finalize_centroids(centroids, num_clusters, num_dimensoes, cluster_sums, cluster_counts);
+
+  if (incremental != NULL) {
+    incremental_concluir(incremental);
+  } else {
+    free(cluster_sums);
+    free(cluster_counts);
+  }
+  perfil_fase(perfil, 0, iteracao, FASE_ATUALIZACAO);
+  return maior_desloc;
 }
 /**
  * Ponto secundário
@@ -151,18 +402,443 @@ void update_centroids(Point* points, Point* centroids, int num_pontos, int num_c
  *  centroids -> pública
  */
 
+/**
+ * @brief Aloca memória alinhada à linha de cache, com o tamanho arredondado para ela.
+ */
+static void* alocar_alinhado(size_t bytes) {
+  size_t tamanho = (bytes + LINHA_CACHE - 1) / LINHA_CACHE * LINHA_CACHE;
+  void* ptr = aligned_alloc(LINHA_CACHE, tamanho > 0 ? tamanho : LINHA_CACHE);
+  if (ptr == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    exit(EXIT_FAILURE);
+  }
+  return ptr;
+}
+
+/**
+ * @brief Aloca os acumuladores de todas as threads. Cada thread aloca e zera os seus,
+ * para que as páginas fiquem na memória local dela (first touch).
+ */
+void acumuladores_iniciar(AcumuladoresThread* acc, int num_clusters, int num_dimensoes) {
+  acc->num_threads = omp_get_max_threads();
+  acc->somas = (long long**)calloc(acc->num_threads, sizeof(long long*));
+  acc->contagens = (long long**)calloc(acc->num_threads, sizeof(long long*));
+  acc->distancias = (long long**)calloc(acc->num_threads, sizeof(long long*));
+
+  #pragma omp parallel num_threads(acc->num_threads)
+  {
+    int tid = omp_get_thread_num();
+    acc->somas[tid] = (long long*)alocar_alinhado((size_t)num_clusters * num_dimensoes * sizeof(long long));
+    acc->contagens[tid] = (long long*)alocar_alinhado((size_t)num_clusters * sizeof(long long));
+    acc->distancias[tid] = (long long*)alocar_alinhado((size_t)num_clusters * sizeof(long long));
+    memset(acc->somas[tid], 0, (size_t)num_clusters * num_dimensoes * sizeof(long long));
+    memset(acc->contagens[tid], 0, (size_t)num_clusters * sizeof(long long));
+  }
+}
+
+void acumuladores_liberar(AcumuladoresThread* acc) {
+  for (int t = 0; t < acc->num_threads; t++) {
+    free(acc->somas[t]);
+    free(acc->contagens[t]);
+    free(acc->distancias[t]);
+  }
+  free(acc->somas);
+  free(acc->contagens);
+  free(acc->distancias);
+}
+
+/**
+ * @brief Soma o ponto i, que foi de 'antigo' para 'novo', nos acumuladores privados da
+ * thread do modo --fundido: com 'por_mudancas' só a diferença, se ele mudou de cluster.
+ */
+static inline void fundido_acumular(long long* somas, long long* contagens, const ConjuntoPontos* points,
+                                    const PontosCompactos* compacto, int i, int antigo, int novo, int por_mudancas,
+                                    int D) {
+  if (por_mudancas) {
+    if (novo != antigo) {
+      contagens[antigo]--;
+      contagens[novo]++;
+      incremental_mover(&somas[antigo * D], &somas[novo * D], points, compacto, i, D);
+    }
+    return;
+  }
+  contagens[novo]++;
+  if (compacto->coords != NULL) {
+    kernel_somar_compacto(&somas[novo * D], &compacto->coords[(size_t)i * compacto->largura], D);
+  } else {
+    kernel_somar(&somas[novo * D], pontos_ponto(points, i), D);
+  }
+}
+
+/**
+ * @brief Atribuição e atualização fundidas em uma única passada sobre os pontos (opção --fundido).
+ *
+ * Cada thread atribui sua faixa de pontos e, já com o ponto em cache, soma as
+ * coordenadas nos seus acumuladores privados, sem atomic. Os acumuladores são
+ * então combinados em árvore (log2 T níveis, pares de threads em paralelo) e a
+ * divisão final é distribuída entre as threads. Tudo ocorre em uma única região
+ * paralela por iteração. Com 'hamerly' != NULL, a atribuição usa a poda de Hamerly; no
+ * modo blocado, cada bloco de TAM_BLOCO_ATRIBUICAO pontos da faixa da thread é atribuído
+ * por kernel_atribuir_blocado e somado em seguida, enquanto ainda está no cache.
+ * Com 'incremental' != NULL, depois da primeira iteração os acumuladores recebem só a
+ * diferença causada pelos pontos que mudaram de cluster, somada às somas correntes.
+ * Em 'mudancas' e 'maior_desloc' são devolvidos os pontos que mudaram de cluster e
+ * o maior deslocamento de centroide ao quadrado.
+ * @return Número de distâncias calculadas (apenas com Hamerly).
+ */
+long long assign_and_update_fused(ConjuntoPontos* points, int* centroids, KernelAtribuicao* kernel,
+                                  EstadoHamerly* hamerly, const PontosCompactos* compacto, AcumuladoresThread* acc,
+                                  EstadoIncremental* incremental, int num_clusters, int num_dimensoes,
+                                  long long* mudancas, long long* maior_desloc, Perfil* perfil, int iteracao) {
+  const int D = num_dimensoes;
+  const int por_mudancas = incremental != NULL && incremental->iniciado;
+  long long avaliacoes = 0, mudados = 0, desloc_max = 0;
+  kernel_carregar_centroides(kernel, centroids);
+  if (hamerly != NULL) {
+    hamerly_preparar_iteracao(hamerly, kernel);
+  }
+
+  #pragma omp parallel num_threads(acc->num_threads) reduction(+ : avaliacoes, mudados) \
+                                                      reduction(max : desloc_max)
+  {
+    const int tid = omp_get_thread_num();
+    const int T = omp_get_num_threads();
+    long long* somas = acc->somas[tid];
+    long long* contagens = acc->contagens[tid];
+    perfil_regiao(perfil, tid);
+    memset(somas, 0, (size_t)num_clusters * D * sizeof(long long));
+    memset(contagens, 0, (size_t)num_clusters * sizeof(long long));
+
+    if (kernel->coords_b != NULL) {
+      int inicio, fim;
+      int32_t antigos[TAM_BLOCO_ATRIBUICAO];
+      faixa_thread(points->num_pontos, TAM_BLOCO_ATRIBUICAO, tid, T, &inicio, &fim);
+      for (int ini = inicio; ini < fim; ini += TAM_BLOCO_ATRIBUICAO) {
+        const int n = fim - ini < TAM_BLOCO_ATRIBUICAO ? fim - ini : TAM_BLOCO_ATRIBUICAO;
+        memcpy(antigos, &points->rotulos[ini], n * sizeof(int32_t));
+        mudados += kernel_atribuir_blocado(kernel, compacto->coords, ini, ini + n, points->rotulos);
+        for (int j = 0; j < n; j++) {
+          fundido_acumular(somas, contagens, points, compacto, ini + j, antigos[j], points->rotulos[ini + j],
+                           por_mudancas, D);
+        }
+      }
+    } else {
+      #pragma omp for schedule(static) nowait
+      for (int i = 0; i < points->num_pontos; i++) {
+        int cluster_id;
+        if (hamerly != NULL) {
+          int atual = hamerly->iniciado ? points->rotulos[i] : -1;
+          cluster_id = hamerly_atribuir_ponto(hamerly, kernel, i, pontos_ponto(points, i), atual,
+                                              acc->distancias[tid], &avaliacoes);
+        } else if (compacto->coords != NULL) {
+          cluster_id = kernel_mais_proximo_compacto(kernel, &compacto->coords[(size_t)i * compacto->largura]);
+        } else {
+          cluster_id = kernel_mais_proximo(kernel, pontos_ponto(points, i));
+        }
+        const int antigo = points->rotulos[i];
+        mudados += cluster_id != antigo;
+        points->rotulos[i] = cluster_id;
+        fundido_acumular(somas, contagens, points, compacto, i, antigo, cluster_id, por_mudancas, D);
+      }
+    }
+    perfil_fase(perfil, tid, iteracao, FASE_ATRIBUICAO);
+    #pragma omp barrier
+    perfil_fase(perfil, tid, iteracao, FASE_ESPERA);
+
+    // Redução em árvore: no nível 'passo', a thread tid absorve a thread tid + passo
+    for (int passo = 1; passo < T; passo *= 2) {
+      if (tid % (2 * passo) == 0 && tid + passo < T) {
+        const long long* outras_somas = acc->somas[tid + passo];
+        const long long* outras_contagens = acc->contagens[tid + passo];
+        for (int k = 0; k < num_clusters; k++) {
+          contagens[k] += outras_contagens[k];
+        }
+        for (int k = 0; k < num_clusters * D; k++) {
+          somas[k] += outras_somas[k];
+        }
+      }
+      #pragma omp barrier
+    }
+    perfil_fase(perfil, tid, iteracao, FASE_REDUCAO);
+
+    #pragma omp for schedule(static) nowait
+    for (int k = 0; k < num_clusters; k++) {
+      if (incremental != NULL) {
+        // Somas correntes: a diferença da iteração (ou a soma completa, na primeira)
+        incremental->contagens[k] = (por_mudancas ? incremental->contagens[k] : 0) + (int)acc->contagens[0][k];
+        acc->contagens[0][k] = incremental->contagens[k];
+        for (int j = 0; j < D; j++) {
+          long long* corrente = &incremental->somas[k * D + j];
+          *corrente = (por_mudancas ? *corrente : 0) + acc->somas[0][k * D + j];
+          acc->somas[0][k * D + j] = *corrente;
+        }
+      }
+      if (acc->contagens[0][k] > 0) {
+        long long desloc = 0;
+        for (int j = 0; j < D; j++) {
+          // Divisão inteira para manter os centroides em coordenadas discretas
+          int novo = acc->somas[0][k * D + j] / acc->contagens[0][k];
+          long long diff = (long long)novo - centroids[k * D + j];
+          desloc += diff * diff;
+          centroids[k * D + j] = novo;
+        }
+        if (desloc > desloc_max) desloc_max = desloc;
+      }
+    }
+    perfil_fase(perfil, tid, iteracao, FASE_ATUALIZACAO);
+    perfil_barreira(perfil, tid, iteracao);
+  }
+
+  if (hamerly != NULL) {
+    hamerly_concluir_iteracao(hamerly);
+  }
+  if (incremental != NULL) {
+    incremental_concluir(incremental);
+  }
+  perfil_fase(perfil, 0, iteracao, FASE_ATUALIZACAO);
+  *mudancas = mudados;
+  *maior_desloc = desloc_max;
+  return avaliacoes;
+}
+
+/**
+ * @brief Iteração do modo --streaming (ver kmeans_streaming.h): enquanto a thread
+ * leitora carrega o bloco seguinte, as threads dividem o bloco atual em faixas
+ * estáticas, atribuem e acumulam cada ponto em somas privadas (reduction sobre os
+ * vetores), e ao fim da passada os centroides são recalculados. O tempo da thread 0
+ * parada à espera de um bloco entra no perfil como espera.
+ * Em 'mudancas' é devolvido o número de pontos que mudaram de cluster.
+ * @return O maior deslocamento de um centroide, ao quadrado.
+ */
+long long assign_and_update_streaming(LeitorStreaming* leitor, int* centroids, KernelAtribuicao* kernel,
+                                      int num_clusters, int num_dimensoes, long long* mudancas, Perfil* perfil,
+                                      int iteracao) {
+  const int D = num_dimensoes, largura = D + (D & 1);
+  kernel_carregar_centroides(kernel, centroids);
+  long long* cluster_sums = (long long*)calloc((size_t)num_clusters * D, sizeof(long long));
+  int* cluster_counts = (int*)calloc(num_clusters, sizeof(int));
+  if (cluster_sums == NULL || cluster_counts == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  long long mudados = 0;
+  for (int b = 0; b < leitor->num_blocos; b++) {
+    const BufferStreaming* bloco = streaming_proximo(leitor);
+    perfil_fase(perfil, 0, iteracao, FASE_ESPERA);
+    int32_t* rotulos = &leitor->rotulos[bloco->inicio];
+
+    #pragma omp parallel reduction(+ : mudados, cluster_sums[:num_clusters * D], cluster_counts[:num_clusters])
+    {
+      const int tid = omp_get_thread_num(), T = omp_get_num_threads();
+      const int ini = (int)((long long)bloco->quantidade * tid / T);
+      const int fim = (int)((long long)bloco->quantidade * (tid + 1) / T);
+      perfil_regiao(perfil, tid);
+      if (bloco->compactos != NULL) {
+        if (kernel->coords_b != NULL) {
+          mudados += kernel_atribuir_blocado(kernel, bloco->compactos, ini, fim, rotulos);
+        }
+        for (int j = ini; j < fim; j++) {
+          const int16_t* ponto = &bloco->compactos[(size_t)j * largura];
+          if (kernel->coords_b == NULL) {
+            int cluster_id = kernel_mais_proximo_compacto(kernel, ponto);
+            mudados += cluster_id != rotulos[j];
+            rotulos[j] = cluster_id;
+          }
+          cluster_counts[rotulos[j]]++;
+          kernel_somar_compacto(&cluster_sums[rotulos[j] * D], ponto, D);
+        }
+      } else {
+        for (int j = ini; j < fim; j++) {
+          const int* ponto = &bloco->coords[(size_t)j * D];
+          int cluster_id = kernel_mais_proximo(kernel, ponto);
+          mudados += cluster_id != rotulos[j];
+          rotulos[j] = cluster_id;
+          cluster_counts[cluster_id]++;
+          kernel_somar(&cluster_sums[cluster_id * D], ponto, D);
+        }
+      }
+      perfil_fase(perfil, tid, iteracao, FASE_ATRIBUICAO);
+      perfil_barreira(perfil, tid, iteracao);
+    }
+    streaming_devolver(leitor);
+  }
+  *mudancas = mudados;
+
+  long long maior_desloc = finalize_centroids(centroids, num_clusters, D, cluster_sums, cluster_counts);
+  free(cluster_sums);
+  free(cluster_counts);
+  perfil_fase(perfil, 0, iteracao, FASE_ATUALIZACAO);
+  return maior_desloc;
+}
+
+/**
+ * @brief Iteração do modo --kdtree (ver kmeans_kdtree.h): a thread 0 filtra a parte de
+ * cima da árvore, as subárvores-tarefa são distribuídas dinamicamente entre as threads,
+ * cada uma somando no próprio acumulador, e os acumuladores são reduzidos para
+ * recalcular os centroides.
+ * Em 'mudancas' é devolvido o número de pontos que mudaram de cluster, e em
+ * 'avaliacoes' é somado o número de testes de poda e distâncias calculados.
+ * @return O maior deslocamento de um centroide, ao quadrado.
+ */
+long long assign_and_update_kdtree(ArvoreKD* arvore, int* centroids, int num_clusters, int num_dimensoes,
+                                   long long* mudancas, long long* avaliacoes, Perfil* perfil, int iteracao) {
+  kdtree_preparar(arvore, centroids);
+
+  #pragma omp parallel
+  {
+    const int tid = omp_get_thread_num();
+    perfil_regiao(perfil, tid);
+    #pragma omp for schedule(dynamic, 1) nowait
+    for (int t = 0; t < arvore->num_tarefas; t++) {
+      kdtree_filtrar_tarefa(arvore, t, centroids, &arvore->acumuladores[tid]);
+    }
+    perfil_fase(perfil, tid, iteracao, FASE_ATRIBUICAO);
+    perfil_barreira(perfil, tid, iteracao);
+  }
+
+  *mudancas = kdtree_reduzir(arvore, avaliacoes);
+  long long maior_desloc = finalize_centroids(centroids, num_clusters, num_dimensoes, arvore->somas_clusters,
+                                              arvore->contagens_clusters);
+  perfil_fase(perfil, 0, iteracao, FASE_ATUALIZACAO);
+  return maior_desloc;
+}
+
+/**
+ * @brief Iteração do modo --execucoes (ver kmeans_execucoes.h): os blocos de pontos são
+ * divididos entre as threads, e cada bloco é atribuído e acumulado para todas as
+ * execuções ativas enquanto está no cache, com somas, contagens e mudanças reduzidas
+ * entre as threads. Com --convergencia, as execuções que convergiram deixam de ser ativas.
+ * @return Número de execuções que continuam ativas.
+ */
+int assign_and_update_multiple(ExecucoesMultiplas* execucoes, const ConjuntoPontos* points,
+                               const PontosCompactos* compacto, const OpcoesKMeans* opcoes, Perfil* perfil,
+                               int iteracao) {
+  const int R = execucoes->num_execucoes, K = execucoes->num_clusters, D = execucoes->num_dimensoes;
+  const int num_blocos = (points->num_pontos + EXECUCOES_BLOCO - 1) / EXECUCOES_BLOCO;
+  const int tamanho_somas = R * K * D, tamanho_contagens = R * K;
+  long long* somas = execucoes->somas;
+  int* contagens = execucoes->contagens;
+  long long* mudancas = execucoes->mudancas;
+  execucoes_carregar(execucoes, 0);
+  memset(somas, 0, (size_t)tamanho_somas * sizeof(long long));
+  memset(contagens, 0, (size_t)tamanho_contagens * sizeof(int));
+  memset(mudancas, 0, R * sizeof(long long));
+
+  #pragma omp parallel for schedule(static) \
+      reduction(+ : somas[:tamanho_somas], contagens[:tamanho_contagens], mudancas[:R])
+  for (int b = 0; b < num_blocos; b++) {
+    const int inicio = b * EXECUCOES_BLOCO;
+    const int fim = inicio + EXECUCOES_BLOCO < points->num_pontos ? inicio + EXECUCOES_BLOCO : points->num_pontos;
+    execucoes_bloco(execucoes, points, compacto, inicio, fim, somas, contagens, mudancas);
+  }
+  perfil_fase(perfil, 0, iteracao, FASE_ATRIBUICAO);
+
+  int ativas = 0;
+  for (int r = 0; r < R; r++) {
+    if (!execucoes->ativa[r]) continue;
+    long long maior_desloc = finalize_centroids(execucoes_centroides(execucoes, r), K, D, &somas[(size_t)r * K * D],
+                                                &contagens[r * K]);
+    execucoes->iteracoes[r]++;
+    if (opcoes->convergencia && opcoes_convergiu(opcoes, mudancas[r], maior_desloc)) {
+      execucoes->ativa[r] = 0;
+    }
+    ativas += execucoes->ativa[r];
+  }
+  perfil_fase(perfil, 0, iteracao, FASE_ATUALIZACAO);
+  return ativas;
+}
+
+/**
+ * @brief Passo do K-Means por mini-lotes (opção --minibatch, ver kmeans_minibatch.h):
+ * atribui os pontos sorteados e move os centroides em direção à média do lote.
+ */
+void minibatch_step(const ConjuntoPontos* points, int* centroids, KernelAtribuicao* kernel, EstadoMiniLote* lote,
+                    int passo, Perfil* perfil) {
+  const int D = lote->num_dimensoes;
+  const int tamanho = lote->num_clusters * (D + 1);
+  long long* acumulado = lote->lote;
+  kernel_carregar_centroides(kernel, centroids);
+  minilote_amostrar(lote, passo, 0, 0, points->num_pontos, lote->tamanho_lote);
+  memset(acumulado, 0, tamanho * sizeof(long long));
+
+  #pragma omp parallel for reduction(+ : acumulado[:tamanho])
+  for (int j = 0; j < lote->tamanho_lote; j++) {
+    const int* ponto = pontos_ponto(points, lote->indices[j]);
+    long long* linha = &acumulado[kernel_mais_proximo(kernel, ponto) * (D + 1)];
+    for (int d = 0; d < D; d++) {
+      linha[d] += ponto[d];
+    }
+    linha[D]++;
+  }
+  perfil_fase(perfil, 0, passo, FASE_ATRIBUICAO);
+
+  minilote_aplicar(lote, centroids);
+  perfil_fase(perfil, 0, passo, FASE_ATUALIZACAO);
+}
+
+/**
+ * @brief Inércia: soma das distâncias ao quadrado de cada ponto ao centroide mais próximo.
+ * Usada para comparar a qualidade do mini-lote com a do Lloyd completo.
+ */
+double compute_inertia(const ConjuntoPontos* points, const int* centroids, KernelAtribuicao* kernel) {
+  kernel_carregar_centroides(kernel, centroids);
+  double inercia = 0.0;
+  #pragma omp parallel for reduction(+ : inercia)
+  for (int i = 0; i < points->num_pontos; i++) {
+    const int* ponto = pontos_ponto(points, i);
+    inercia += (double)kernel_distancia(kernel, ponto, kernel_mais_proximo(kernel, ponto));
+  }
+  return inercia;
+}
+
+/**
+ * @brief Inércia de cada execução do modo --execucoes, com os blocos divididos entre as threads.
+ */
+void compute_inertia_multiple(ExecucoesMultiplas* execucoes, const ConjuntoPontos* points) {
+  const int R = execucoes->num_execucoes;
+  const int num_blocos = (points->num_pontos + EXECUCOES_BLOCO - 1) / EXECUCOES_BLOCO;
+  long long* inercias = execucoes->inercias;
+  execucoes_carregar(execucoes, 1);
+  memset(inercias, 0, R * sizeof(long long));
+  #pragma omp parallel for schedule(static) reduction(+ : inercias[:R])
+  for (int b = 0; b < num_blocos; b++) {
+    const int inicio = b * EXECUCOES_BLOCO;
+    const int fim = inicio + EXECUCOES_BLOCO < points->num_pontos ? inicio + EXECUCOES_BLOCO : points->num_pontos;
+    execucoes_inercia_bloco(execucoes, points, inicio, fim, inercias);
+  }
+}
+
+/**
+ * @brief Inércia no modo --streaming: uma passada extra sobre os blocos do disco.
+ */
+double compute_inertia_streaming(LeitorStreaming* leitor, const int* centroids, KernelAtribuicao* kernel) {
+  kernel_carregar_centroides(kernel, centroids);
+  double inercia = 0.0;
+  for (int b = 0; b < leitor->num_blocos; b++) {
+    const BufferStreaming* bloco = streaming_proximo(leitor);
+    #pragma omp parallel for reduction(+ : inercia)
+    for (int j = 0; j < bloco->quantidade; j++) {
+      const int* ponto = &bloco->coords[(size_t)j * leitor->num_dimensoes];
+      inercia += (double)kernel_distancia(kernel, ponto, kernel_mais_proximo(kernel, ponto));
+    }
+    streaming_devolver(leitor);
+  }
+  return inercia;
+}
+
 /**
  * @brief Imprime os resultados finais e o checksum (como long long).
  */
-void print_results(Point* centroids, int num_clusters, int num_dimensoes) {
+void print_results(const int* centroids, int num_clusters, int num_dimensoes) {
   printf("--- Centroides Finais ---\n");
   long long checksum = 0;
   for (int i = 0; i < num_clusters; i++) {
     printf("Centroide %d: [", i);
     for (int j = 0; j < num_dimensoes; j++) {
-      printf("%d", centroids[i].coords[j]);
+      printf("%d", centroids[i * num_dimensoes + j]);
       if (j < num_dimensoes - 1) printf(", ");
-      checksum += centroids[i].coords[j];
+      checksum += centroids[i * num_dimensoes + j];
     }
     printf("]\n");
   }
@@ -176,11 +852,11 @@ void print_results(Point* centroids, int num_clusters, int num_dimensoes) {
  * Linha 1: Tempo de execução em segundos (double)
  * Linha 2: Checksum final (long long)
  */
-void print_time_and_checksum(Point* centroids, int num_clusters, int num_dimensoes, double exec_time) {
+void print_time_and_checksum(const int* centroids, int num_clusters, int num_dimensoes, double exec_time) {
   long long checksum = 0;
   for (int i = 0; i < num_clusters; i++) {
     for (int j = 0; j < num_dimensoes; j++) {
-      checksum += centroids[i].coords[j];
+      checksum += centroids[i * num_dimensoes + j];
     }
   }
   // Saída formatada para o avaliador
@@ -192,8 +868,8 @@ void print_time_and_checksum(Point* centroids, int num_clusters, int num_dimenso
 
 int main(int argc, char* argv[]) {
   // Validação e leitura dos argumentos de linha de comando
-  if (argc != 6) {
-    fprintf(stderr, "Uso: %s <arquivo_dados> <num_pontos> <num_dimensoes> <num_clusters> <num_iteracoes>\n", argv[0]);
+  if (argc < 6) {
+    fprintf(stderr, "Uso: %s <arquivo_dados> <num_pontos> <num_dimensoes> <num_clusters> <num_iteracoes> [opcoes]\n", argv[0]);
     return EXIT_FAILURE;
   }
 
@@ -203,6 +879,9 @@ int main(int argc, char* argv[]) {
   const int num_clusters = atoi(argv[4]);
   const int num_iteracoes = atoi(argv[5]);
 
+  OpcoesKMeans opcoes;
+  opcoes_ler(argc, argv, 6, &opcoes);
+
   if (num_pontos <= 0 || num_dimensoes <= 0 || num_clusters <= 0 || num_iteracoes <= 0 || num_clusters > num_pontos) {
     fprintf(stderr, "Erro nos parâmetros. Verifique se Numero de pontos, Numero de dimensoes, Numero de clusters,\
                         Numero de Iteracoes > 0 e Numero de clusters <= Numero de pontos.\n");
@@ -210,20 +889,150 @@ int main(int argc, char* argv[]) {
   }
 
   // --- Alocação de Memória ---
-  int* all_coords = (int*)malloc((num_pontos + num_clusters) * num_dimensoes * sizeof(int));
-  Point* points = (Point*)malloc(num_pontos * sizeof(Point));
-  Point* centroids = (Point*)malloc(num_clusters * sizeof(Point));
-  // ... (verificação de alocação) ...
-  for (int i = 0; i < num_pontos; i++) {
-    points[i].coords = &all_coords[i * num_dimensoes];
+  // Um dataset binário é mapeado direto do arquivo; um de texto é lido para uma matriz alocada.
+  // A faixa de valores vem do cabeçalho binário ou é calculada durante a leitura do texto.
+  // Com --streaming nada é carregado: os pontos são lidos do disco em blocos a cada passada.
+  ConjuntoPontos points = {0};
+  DatasetBinario binario;
+  LeitorStreaming leitor;
+  int min_val, max_val;
+  int eh_binario = 0;
+  if (opcoes.streaming > 0) {
+    streaming_abrir(&leitor, filename, num_pontos, num_dimensoes, opcoes.streaming);
+    min_val = leitor.min_val;
+    max_val = leitor.max_val;
+  } else {
+    eh_binario = pontos_carregar(filename, num_pontos, num_dimensoes, omp_get_max_threads(), &points, &binario,
+                                 &min_val, &max_val);
   }
-  for (int i = 0; i < num_clusters; i++) {
-    centroids[i].coords = &all_coords[(num_pontos + i) * num_dimensoes];
+  int* centroids = (int*)malloc((size_t)num_clusters * num_dimensoes * sizeof(int));
+  if (centroids == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    return EXIT_FAILURE;
   }
 
   // --- Preparação (Fora da medição de tempo) ---
-  read_data_from_file(filename, points, num_pontos, num_dimensoes);
-  initialize_centroids(points, centroids, num_pontos, num_clusters, num_dimensoes);
+  NivelSimd nivel = simd_faixa_segura(min_val, max_val) ? simd_escolher(opcoes.simd) : SIMD_ESCALAR;
+  ExecucoesMultiplas execucoes;
+  if (opcoes.streaming > 0) {
+    streaming_inicializar_centroides(&leitor, centroids, num_clusters);
+  } else if (opcoes.execucoes > 0) {
+    // A execução r sorteia com a semente 42 + r, ou usa k-means|| com --semente + r
+    execucoes_iniciar(&execucoes, opcoes.execucoes, num_pontos, num_clusters, num_dimensoes);
+    const int kmpar = opcoes.inicializacao_paralela && kmpar_faixa_segura(num_pontos, num_dimensoes, min_val, max_val);
+    if (opcoes.inicializacao_paralela && !kmpar) {
+      fprintf(stderr, "Aviso: faixa de valores grande demais para k-means||, usando a inicialização aleatória.\n");
+    }
+    for (int r = 0; r < opcoes.execucoes; r++) {
+      if (kmpar) {
+        kmpar_inicializar(points.coords, num_pontos, num_dimensoes, num_clusters, opcoes.semente + r, nivel,
+                          execucoes_centroides(&execucoes, r));
+      } else {
+        execucoes_sortear_centroides(&execucoes, r, &points, 42 + r);
+      }
+    }
+  } else if (opcoes.inicializacao_paralela && kmpar_faixa_segura(num_pontos, num_dimensoes, min_val, max_val)) {
+    int candidatos = kmpar_inicializar(points.coords, num_pontos, num_dimensoes, num_clusters, opcoes.semente, nivel,
+                                       centroids);
+    fprintf(stderr, "Inicialização k-means||: %d candidatos\n", candidatos);
+  } else {
+    if (opcoes.inicializacao_paralela) {
+      fprintf(stderr, "Aviso: faixa de valores grande demais para k-means||, usando a inicialização aleatória.\n");
+    }
+    initialize_centroids(&points, centroids, num_pontos, num_clusters, num_dimensoes);
+  }
+  KernelAtribuicao kernel;
+  kernel_iniciar(&kernel, nivel, num_clusters, num_dimensoes);
+  // Com --numa as threads são fixadas antes de os buffers de cada thread serem alocados
+  PosicionamentoNuma numa;
+  numa_iniciar(&numa, opcoes.streaming > 0 ? "nao" : opcoes.numa, omp_get_max_threads());
+  if (numa.ativo) {
+    #pragma omp parallel
+    numa_fixar(&numa.topologia, omp_get_thread_num());
+  }
+  EstadoHamerly hamerly;
+  long long avaliacoes = 0;
+  if (opcoes.hamerly) {
+    hamerly_iniciar(&hamerly, num_pontos, num_clusters, num_dimensoes, min_val, max_val);
+  }
+  ArvoreKD arvore;
+  if (opcoes.kdtree && !kdtree_faixa_segura(num_dimensoes, min_val, max_val)) {
+    fprintf(stderr, "Aviso: faixa de valores grande demais para --kdtree, usando a atribuição normal.\n");
+    opcoes.kdtree = 0;
+  }
+  if (opcoes.kdtree) {
+    kdtree_construir(&arvore, points.coords, num_pontos, num_dimensoes, num_clusters, omp_get_max_threads());
+    fprintf(stderr, "Árvore KD: %d nós, folhas de até %d pontos\n", arvore.num_nos, KDTREE_FOLHA);
+  }
+  AcumuladoresThread acumuladores;
+  if (opcoes.fundido) {
+    acumuladores_iniciar(&acumuladores, num_clusters, num_dimensoes);
+  }
+  EstadoMiniLote minilote;
+  if (opcoes.minibatch > 0) {
+    minilote_iniciar(&minilote, opcoes.minibatch, num_clusters, num_dimensoes, centroids);
+  }
+  // Uma lista de mudanças por thread; o modo --fundido aplica as mudanças sem listas
+  EstadoIncremental incremental;
+  if (opcoes.incremental) {
+    incremental_iniciar(&incremental, num_pontos, num_clusters, num_dimensoes, omp_get_max_threads());
+  }
+  EstadoIncremental* estado_incremental = opcoes.incremental ? &incremental : NULL;
+  PontosCompactos compacto = {NULL, 0};
+  int usar_compacto = 0;  // No modo --streaming a conversão é feita bloco a bloco pela leitora
+  if (opcoes.colunas && !opcoes.hamerly && !opcoes.kdtree && opcoes.minibatch == 0 && !opcoes.fundido &&
+      opcoes.streaming == 0 && opcoes.execucoes == 0) {
+    pontos_gerar_colunas(&points);
+  } else if (!opcoes.hamerly && !opcoes.kdtree && opcoes.minibatch == 0 &&
+             simd_escolher_armazenamento(opcoes.armazenamento, min_val, max_val, num_dimensoes)) {
+    if (opcoes.streaming == 0) simd_compactar(points.coords, num_pontos, num_dimensoes, min_val, max_val, &compacto);
+    kernel_habilitar_compacto(&kernel);
+    usar_compacto = 1;
+  }
+  if (simd_escolher_atribuicao(opcoes.atribuicao, num_clusters, usar_compacto, min_val, max_val, num_dimensoes)) {
+    kernel_habilitar_blocado(&kernel, min_val, max_val);
+  }
+  if (opcoes.streaming > 0) {
+    streaming_iniciar(&leitor, usar_compacto);
+  }
+  if (opcoes.execucoes > 0) {
+    execucoes_replicar(&execucoes, &kernel);
+  }
+  if (numa.ativo) {
+    // Cada thread copia a faixa estática de pontos que processa nas iterações (first touch)
+    // A divisão entre as threads é a da atribuição: em blocos nos modos colunas e blocado
+    numa.granularidade = points.colunas != NULL || kernel.coords_b != NULL ? TAM_BLOCO_ATRIBUICAO : 1;
+    MigracaoNuma migracao;
+    numa_migracao_iniciar(&migracao, &points, &compacto);
+    #pragma omp parallel
+    {
+      const int tid = omp_get_thread_num(), no = numa.no_thread[tid];
+      if (numa.lider[no] == tid) {
+        numa_preparar_replica(&numa, no, &kernel);
+        numa_preparar_acumuladores(&numa, no, num_clusters, num_dimensoes);
+      }
+      numa_preparar_acumuladores_thread(&numa, tid, num_clusters, num_dimensoes);
+      int inicio, fim;
+      faixa_thread(num_pontos, numa.granularidade, tid, omp_get_num_threads(), &inicio, &fim);
+      numa_migracao_faixa(&migracao, &points, &compacto, inicio, fim);
+    }
+    numa_migracao_concluir(&migracao);
+    fprintf(stderr, "NUMA: %d nó(s), %d threads fixadas\n", numa.topologia.num_nos, numa.num_threads);
+  }
+  fprintf(stderr, "Kernel de atribuição: %s (D=%d %s), pontos: %s\n", simd_nome(nivel), num_dimensoes,
+          kernel_caminho(&kernel),
+          usar_compacto ? "int16" : simd_descrever_pontos(&compacto, points.colunas != NULL));
+  // Os contadores medem a thread que os abre, então cada thread do time abre os seus
+  Perfil perfil;
+  perfil_iniciar(&perfil, opcoes.perfil, omp_get_max_threads(), num_iteracoes);
+  if (perfil.ativo) {
+    #pragma omp parallel
+    perfil_abrir_contadores(&perfil, omp_get_thread_num());
+  }
+  if (opcoes.streaming > 0) {
+    fprintf(stderr, "Streaming: %d blocos de até %d pontos (%.1f MiB por buffer)\n", leitor.num_blocos,
+            leitor.pontos_por_bloco, (double)leitor.pontos_por_bloco * num_dimensoes * sizeof(int) / (1 << 20));
+  }
 
   // --- Medição de Tempo do Algoritmo Principal ---
   struct timespec start, end;
@@ -231,9 +1040,43 @@ int main(int argc, char* argv[]) {
 
 
   // Laço principal do K-Means (A única parte que será medida)
-  for (int iter = 0; iter < num_iteracoes; iter++) {
-    assign_points_to_clusters(points, centroids, num_pontos, num_clusters, num_dimensoes);
-    update_centroids(points, centroids, num_pontos, num_clusters, num_dimensoes);
+  int iteracoes = 0;
+  while (iteracoes < num_iteracoes) {
+    perfil_marcar(&perfil, 0);
+    if (opcoes.minibatch > 0) {
+      minibatch_step(&points, centroids, &kernel, &minilote, iteracoes++, &perfil);
+      continue;
+    }
+    if (opcoes.execucoes > 0) {
+      int ativas = assign_and_update_multiple(&execucoes, &points, &compacto, &opcoes, &perfil, iteracoes);
+      iteracoes++;
+      if (ativas == 0) break;
+      continue;
+    }
+    long long mudancas = 0, maior_desloc = 0;
+    if (opcoes.streaming > 0) {
+      maior_desloc = assign_and_update_streaming(&leitor, centroids, &kernel, num_clusters, num_dimensoes,
+                                                 &mudancas, &perfil, iteracoes);
+    } else if (opcoes.kdtree) {
+      maior_desloc = assign_and_update_kdtree(&arvore, centroids, num_clusters, num_dimensoes, &mudancas,
+                                              &avaliacoes, &perfil, iteracoes);
+    } else if (opcoes.fundido) {
+      avaliacoes += assign_and_update_fused(&points, centroids, &kernel, opcoes.hamerly ? &hamerly : NULL,
+                                            &compacto, &acumuladores, estado_incremental, num_clusters,
+                                            num_dimensoes, &mudancas, &maior_desloc, &perfil, iteracoes);
+    } else {
+      if (opcoes.hamerly) {
+        avaliacoes += assign_points_to_clusters_hamerly(&points, centroids, &kernel, &hamerly, &mudancas,
+                                                        estado_incremental, &perfil, iteracoes);
+      } else {
+        mudancas = assign_points_to_clusters(&points, centroids, &kernel, &compacto, &numa, estado_incremental,
+                                             &perfil, iteracoes);
+      }
+      maior_desloc = update_centroids(&points, centroids, &compacto, num_clusters, num_dimensoes, &numa,
+                                      estado_incremental, &perfil, iteracoes);
+    }
+    iteracoes++;
+    if (opcoes.convergencia && opcoes_convergiu(&opcoes, mudancas, maior_desloc)) break;
   }
 
 
@@ -243,11 +1086,86 @@ int main(int argc, char* argv[]) {
   double time_taken = (end.tv_sec - start.tv_sec) + 1e-9 * (end.tv_nsec - start.tv_nsec);
 
   // --- Apresentação dos Resultados ---
+  // Com --execucoes, a execução de menor inércia fornece o checksum (e o modelo)
+  if (opcoes.execucoes > 0) {
+    compute_inertia_multiple(&execucoes, &points);
+    const int melhor = execucoes_melhor(&execucoes);
+    execucoes_relatar(&execucoes, melhor);
+    memcpy(centroids, execucoes_centroides(&execucoes, melhor), (size_t)num_clusters * num_dimensoes * sizeof(int));
+  }
   print_time_and_checksum(centroids, num_clusters, num_dimensoes, time_taken);
+  if (opcoes.hamerly) {
+    fprintf(stderr, "Hamerly: %lld de %lld distâncias calculadas (%.1f%%)\n", avaliacoes,
+            (long long)num_pontos * num_clusters * iteracoes,
+            100.0 * avaliacoes / ((double)num_pontos * num_clusters * iteracoes));
+  }
+  if (opcoes.kdtree) {
+    fprintf(stderr, "Árvore KD: %lld testes de poda e distâncias para %lld distâncias do Lloyd (%.1f%%)\n",
+            avaliacoes, (long long)num_pontos * num_clusters * iteracoes,
+            100.0 * avaliacoes / ((double)num_pontos * num_clusters * iteracoes));
+  }
+  if (opcoes.convergencia) {
+    fprintf(stderr, "Iterações executadas: %d de %d\n", iteracoes, num_iteracoes);
+  }
+  if (opcoes.minibatch > 0 || opcoes.inercia) {
+    fprintf(stderr, "Inércia final: %.6e\n", opcoes.streaming > 0
+                                                  ? compute_inertia_streaming(&leitor, centroids, &kernel)
+                                                  : compute_inertia(&points, centroids, &kernel));
+  }
+  perfil_escrever(&perfil, "openmp", "threads", num_pontos, num_dimensoes, num_clusters, iteracoes, time_taken);
+  if (opcoes.modelo != NULL) {
+    // Com --estatisticas, uma passada extra atribui os pontos aos centroides finais
+    ModeloKMeans modelo;
+    modelo_iniciar(&modelo, centroids, num_clusters, num_dimensoes, min_val, max_val, num_pontos, iteracoes,
+                   opcoes.estatisticas);
+    if (opcoes.estatisticas) {
+      kernel_carregar_centroides(&kernel, centroids);
+      if (opcoes.streaming > 0) {
+        for (int b = 0; b < leitor.num_blocos; b++) {
+          const BufferStreaming* bloco = streaming_proximo(&leitor);
+          modelo_acumular_estatisticas(&modelo, &kernel, bloco->coords, bloco->quantidade);
+          streaming_devolver(&leitor);
+        }
+      } else {
+        modelo_acumular_estatisticas(&modelo, &kernel, points.coords, num_pontos);
+      }
+    }
+    if (modelo_salvar(&modelo, opcoes.modelo) == 0) {
+      fprintf(stderr, "Modelo gravado em '%s'\n", opcoes.modelo);
+    }
+    modelo_liberar(&modelo);
+  }
 
   // --- Limpeza ---
-  free(all_coords);
-  free(points);
+  perfil_liberar(&perfil);
+  if (opcoes.minibatch > 0) {
+    minilote_liberar(&minilote);
+  }
+  if (opcoes.hamerly) {
+    hamerly_liberar(&hamerly);
+  }
+  if (opcoes.kdtree) {
+    kdtree_liberar(&arvore);
+  }
+  if (opcoes.execucoes > 0) {
+    execucoes_liberar(&execucoes);
+  }
+  if (opcoes.fundido) {
+    acumuladores_liberar(&acumuladores);
+  }
+  if (opcoes.incremental) {
+    incremental_liberar(&incremental);
+  }
+  numa_liberar(&numa);
+  kernel_liberar(&kernel);
+  free(compacto.coords);
+  pontos_liberar(&points);
+  if (eh_binario) {
+    dataset_binario_fechar(&binario);
+  }
+  if (opcoes.streaming > 0) {
+    streaming_fechar(&leitor);
+  }
   free(centroids);
 
   return EXIT_SUCCESS;
@@ -0,0 +1,247 @@
+#ifndef KMEANS_PERFIL_H
+#define KMEANS_PERFIL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define KMEANS_PERFIL_PERF
+#endif
+
+// Instrumentação por fase (opção --perfil=arquivo.json).
+//
+// Cada thread (ou processo, no MPI) marca o fim de cada trecho do laço principal e o
+// tempo desde a marca anterior é somado à fase do trecho, por iteração:
+//   atribuicao  - busca do centroide mais próximo (no --fundido, também a soma dos pontos);
+//   atualizacao - acumulação das somas e contagens e cálculo dos novos centroides;
+//   reducao     - combinação dos parciais entre threads ou nós, ou a comunicação do MPI;
+//   espera      - tempo parado em barreiras esperando as outras threads/processos.
+// Onde o kernel permite, perf_event_open conta ciclos, instruções e falhas na LLC
+// (só em modo usuário) de cada thread, somados por fase. O resultado é gravado em
+// JSON ao final; a saída padrão continua sendo as duas linhas lidas pelo avaliador.
+// Sem --perfil, cada marca custa apenas o teste de 'ativo'.
+
+#define PERFIL_NUM_CONTADORES 3
+
+typedef enum { FASE_ATRIBUICAO, FASE_ATUALIZACAO, FASE_REDUCAO, FASE_ESPERA, PERFIL_NUM_FASES } FasePerfil;
+
+static const char* const PERFIL_NOMES_FASES[PERFIL_NUM_FASES] = {"atribuicao", "atualizacao", "reducao", "espera"};
+static const char* const PERFIL_NOMES_CONTADORES[PERFIL_NUM_CONTADORES] = {"ciclos", "instrucoes", "falhas_llc"};
+
+// Estado de marcação de uma thread, em sua própria linha de cache
+typedef struct {
+  _Alignas(64) double marca;                         // Instante da última marca, em segundos
+  uint64_t contadores_marca[PERFIL_NUM_CONTADORES];  // Contadores na última marca
+  int fds[PERFIL_NUM_CONTADORES];                    // Grupo perf (fds[0] é o líder; -1 = fechado)
+} MarcaThread;
+
+typedef struct {
+  int ativo;
+  const char* arquivo;
+  int num_threads;
+  int max_iteracoes;
+  MarcaThread* marcas;   // [thread]
+  double* tempos;        // [(thread * max_iteracoes + iteracao) * PERFIL_NUM_FASES + fase], em segundos
+  uint64_t* contadores;  // [(thread * PERFIL_NUM_FASES + fase) * PERFIL_NUM_CONTADORES + c]
+  int* com_contadores;   // [thread]: 1 se os contadores de hardware da thread foram abertos
+} Perfil;
+
+static inline double perfil_agora(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+/**
+ * @brief Prepara o perfil para 'num_threads' threads e até 'max_iteracoes' iterações.
+ * Com 'arquivo' == NULL o perfil fica desligado e nada é alocado.
+ */
+static inline void perfil_iniciar(Perfil* p, const char* arquivo, int num_threads, int max_iteracoes) {
+  memset(p, 0, sizeof(*p));
+  if (arquivo == NULL) return;
+  p->ativo = 1;
+  p->arquivo = arquivo;
+  p->num_threads = num_threads;
+  p->max_iteracoes = max_iteracoes;
+  p->marcas = (MarcaThread*)aligned_alloc(64, (size_t)num_threads * sizeof(MarcaThread));
+  p->tempos = (double*)calloc((size_t)num_threads * max_iteracoes * PERFIL_NUM_FASES, sizeof(double));
+  p->contadores = (uint64_t*)calloc((size_t)num_threads * PERFIL_NUM_FASES * PERFIL_NUM_CONTADORES, sizeof(uint64_t));
+  p->com_contadores = (int*)calloc(num_threads, sizeof(int));
+  if (p->marcas == NULL || p->tempos == NULL || p->contadores == NULL || p->com_contadores == NULL) {
+    fprintf(stderr, "Erro: falha ao alocar o perfil.\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int t = 0; t < num_threads; t++) {
+    memset(&p->marcas[t], 0, sizeof(MarcaThread));
+    for (int c = 0; c < PERFIL_NUM_CONTADORES; c++) {
+      p->marcas[t].fds[c] = -1;
+    }
+  }
+}
+
+static inline void perfil_ler_contadores(const MarcaThread* m, uint64_t* valores) {
+#ifdef KMEANS_PERFIL_PERF
+  if (m->fds[0] >= 0) {
+    uint64_t leitura[1 + PERFIL_NUM_CONTADORES];  // PERF_FORMAT_GROUP: número de eventos e os valores
+    if (read(m->fds[0], leitura, sizeof(leitura)) == (ssize_t)sizeof(leitura)) {
+      memcpy(valores, &leitura[1], sizeof(uint64_t) * PERFIL_NUM_CONTADORES);
+      return;
+    }
+  }
+#else
+  (void)m;
+#endif
+  memset(valores, 0, sizeof(uint64_t) * PERFIL_NUM_CONTADORES);
+}
+
+/**
+ * @brief Abre os contadores de hardware da thread chamadora (que deve ser a mesma que
+ * fará as marcas de 'thread') como um grupo, lido de uma vez a cada marca. Se algum
+ * evento não puder ser aberto (perf_event_paranoid, máquina virtual, contêiner), a
+ * thread fica só com os tempos.
+ */
+static inline void perfil_abrir_contadores(Perfil* p, int thread) {
+  if (!p->ativo) return;
+  MarcaThread* m = &p->marcas[thread];
+#ifdef KMEANS_PERFIL_PERF
+  static const uint64_t configs[PERFIL_NUM_CONTADORES] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                          PERF_COUNT_HW_CACHE_MISSES};
+  for (int c = 0; c < PERFIL_NUM_CONTADORES; c++) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = configs[c];
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.disabled = c == 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    m->fds[c] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, c == 0 ? -1 : m->fds[0], 0);
+    if (m->fds[c] < 0) {
+      for (int j = 0; j < c; j++) {
+        close(m->fds[j]);
+        m->fds[j] = -1;
+      }
+      return;
+    }
+  }
+  ioctl(m->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  p->com_contadores[thread] = 1;
+#else
+  (void)m;
+#endif
+}
+
+/**
+ * @brief Início de um trecho medido: o que passou desde a marca anterior é descartado.
+ */
+static inline void perfil_marcar(Perfil* p, int thread) {
+  if (!p->ativo) return;
+  MarcaThread* m = &p->marcas[thread];
+  perfil_ler_contadores(m, m->contadores_marca);
+  m->marca = perfil_agora();
+}
+
+/**
+ * @brief Fim de um trecho: soma à 'fase' da 'iteracao' o tempo (e os contadores) desde
+ * a marca anterior da thread, e marca o início do próximo trecho.
+ */
+static inline void perfil_fase(Perfil* p, int thread, int iteracao, FasePerfil fase) {
+  if (!p->ativo) return;
+  MarcaThread* m = &p->marcas[thread];
+  const double agora = perfil_agora();
+  uint64_t valores[PERFIL_NUM_CONTADORES];
+  perfil_ler_contadores(m, valores);
+  p->tempos[((size_t)thread * p->max_iteracoes + iteracao) * PERFIL_NUM_FASES + fase] += agora - m->marca;
+  uint64_t* totais = &p->contadores[((size_t)thread * PERFIL_NUM_FASES + fase) * PERFIL_NUM_CONTADORES];
+  for (int c = 0; c < PERFIL_NUM_CONTADORES; c++) {
+    totais[c] += valores[c] - m->contadores_marca[c];
+    m->contadores_marca[c] = valores[c];
+  }
+  m->marca = agora;
+}
+
+/**
+ * @brief Grava o perfil em JSON: tempos por thread, iteração e fase, os totais por fase
+ * e, quando disponíveis, os contadores de hardware por fase. 'unidade' nomeia a lista
+ * ("threads" ou "processos") e 'tempo_total' é o tempo informado na saída padrão.
+ */
+static inline void perfil_escrever(const Perfil* p, const char* versao, const char* unidade, int num_pontos,
+                                   int num_dimensoes, int num_clusters, int iteracoes, double tempo_total) {
+  if (!p->ativo) return;
+  FILE* arq = fopen(p->arquivo, "w");
+  if (arq == NULL) {
+    fprintf(stderr, "Aviso: não foi possível gravar o perfil em '%s'.\n", p->arquivo);
+    return;
+  }
+  fprintf(arq, "{\n  \"versao\": \"%s\",\n", versao);
+  fprintf(arq, "  \"pontos\": %d,\n  \"dimensoes\": %d,\n  \"clusters\": %d,\n", num_pontos, num_dimensoes,
+          num_clusters);
+  fprintf(arq, "  \"iteracoes\": %d,\n  \"tempo_total\": %.9f,\n  \"fases\": [", iteracoes, tempo_total);
+  for (int f = 0; f < PERFIL_NUM_FASES; f++) {
+    fprintf(arq, "%s\"%s\"", f > 0 ? ", " : "", PERFIL_NOMES_FASES[f]);
+  }
+  fprintf(arq, "],\n  \"%s\": [\n", unidade);
+  for (int t = 0; t < p->num_threads; t++) {
+    fprintf(arq, "    {\n      \"id\": %d,\n      \"totais\": {", t);
+    for (int f = 0; f < PERFIL_NUM_FASES; f++) {
+      double total = 0.0;
+      for (int it = 0; it < iteracoes; it++) {
+        total += p->tempos[((size_t)t * p->max_iteracoes + it) * PERFIL_NUM_FASES + f];
+      }
+      fprintf(arq, "%s\"%s\": %.9f", f > 0 ? ", " : "", PERFIL_NOMES_FASES[f], total);
+    }
+    fprintf(arq, "},\n      \"contadores\": ");
+    if (p->com_contadores[t]) {
+      fprintf(arq, "{");
+      for (int f = 0; f < PERFIL_NUM_FASES; f++) {
+        const uint64_t* c = &p->contadores[((size_t)t * PERFIL_NUM_FASES + f) * PERFIL_NUM_CONTADORES];
+        fprintf(arq, "%s\"%s\": {", f > 0 ? ", " : "", PERFIL_NOMES_FASES[f]);
+        for (int j = 0; j < PERFIL_NUM_CONTADORES; j++) {
+          fprintf(arq, "%s\"%s\": %llu", j > 0 ? ", " : "", PERFIL_NOMES_CONTADORES[j], (unsigned long long)c[j]);
+        }
+        fprintf(arq, "}");
+      }
+      fprintf(arq, "}");
+    } else {
+      fprintf(arq, "null");
+    }
+    fprintf(arq, ",\n      \"iteracoes\": [");
+    for (int it = 0; it < iteracoes; it++) {
+      const double* linha = &p->tempos[((size_t)t * p->max_iteracoes + it) * PERFIL_NUM_FASES];
+      fprintf(arq, "%s\n        [", it > 0 ? "," : "");
+      for (int f = 0; f < PERFIL_NUM_FASES; f++) {
+        fprintf(arq, "%s%.9f", f > 0 ? ", " : "", linha[f]);
+      }
+      fprintf(arq, "]");
+    }
+    fprintf(arq, "\n      ]\n    }%s\n", t < p->num_threads - 1 ? "," : "");
+  }
+  fprintf(arq, "  ]\n}\n");
+  fclose(arq);
+  fprintf(stderr, "Perfil gravado em '%s'\n", p->arquivo);
+}
+
+static inline void perfil_liberar(Perfil* p) {
+  if (!p->ativo) return;
+#ifdef KMEANS_PERFIL_PERF
+  for (int t = 0; t < p->num_threads; t++) {
+    for (int c = 0; c < PERFIL_NUM_CONTADORES; c++) {
+      if (p->marcas[t].fds[c] >= 0) close(p->marcas[t].fds[c]);
+    }
+  }
+#endif
+  free(p->marcas);
+  free(p->tempos);
+  free(p->contadores);
+  free(p->com_contadores);
+}
+
+#endif
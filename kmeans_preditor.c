@@ -0,0 +1,581 @@
+#define _GNU_SOURCE  // Necessário para CLOCK_MONOTONIC, sigaction e ppoll
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "kmeans_modelo.h"
+#include "kmeans_simd.h"
+
+// Servidor de predição: carrega um modelo gravado com --modelo=arquivo uma única vez
+// e responde consultas de centroide mais próximo pela entrada padrão ou por um socket
+// Unix local.
+//
+// Protocolo (texto, uma consulta por linha): cada linha tem as D coordenadas inteiras
+// de um ponto, separadas por espaços; a resposta é uma linha "cluster distancia", com
+// a distância ao quadrado até o centroide, ou "erro: ..." se a linha for inválida. As
+// respostas de cada cliente saem na ordem das consultas. As conexões não bloqueiam: as
+// respostas que um cliente ainda não leu ficam no buffer de saída dele e são enviadas
+// quando o socket aceita escrita, e o servidor para de ler as consultas de um cliente
+// enquanto ele tem mais de PREDITOR_SAIDA_PENDENTE bytes de respostas pendentes.
+//
+// As consultas que chegam juntas (de um ou de vários clientes) formam um lote de até
+// --lote pontos, atribuído de uma vez pelos kernels de kmeans_simd.h: o modo blocado
+// (ou o compacto) quando todos os pontos do lote estão na faixa de valores do treino,
+// para a qual esses kernels são exatos; fora dela, o kernel escalar. Com --janela=us
+// o servidor espera até esse tempo depois da primeira consulta para encher o lote.
+//
+// SIGHUP relê o arquivo do modelo sem reiniciar (entre dois lotes; o modelo anterior
+// é mantido se o novo for inválido ou tiver outro D). SIGUSR1 imprime as estatísticas
+// de latência e vazão em stderr; SIGINT/SIGTERM (ou o fim da entrada padrão) as
+// imprimem e encerram.
+
+#define PREDITOR_LOTE_PADRAO 256
+#define PREDITOR_LATENCIAS (1 << 20)  // Amostras de latência guardadas (as mais recentes)
+#define PREDITOR_LEITURA 65536        // Bytes por chamada de read
+#define PREDITOR_SAIDA_PENDENTE (1 << 20)  // Respostas pendentes acima das quais o cliente não é lido
+
+static volatile sig_atomic_t sinal_recarregar = 0;
+static volatile sig_atomic_t sinal_relatar = 0;
+static volatile sig_atomic_t sinal_encerrar = 0;
+
+static void tratar_sinal(int sinal) {
+  if (sinal == SIGHUP) sinal_recarregar = 1;
+  else if (sinal == SIGUSR1) sinal_relatar = 1;
+  else sinal_encerrar = 1;
+}
+
+static double agora(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+// Modelo carregado e os kernels de atribuição montados para ele
+typedef struct {
+  ModeloKMeans modelo;
+  KernelAtribuicao kernel;   // Kernel vetorizado, exato para pontos na faixa do treino
+  KernelAtribuicao escalar;  // Kernel escalar, exato para qualquer ponto
+  int compacto;              // Pontos do lote em int16 (simd_compacto_seguro)
+  int blocado;               // Atribuição blocada do lote
+} Preditor;
+
+/**
+ * @brief Lê o modelo de 'arquivo' e prepara os kernels.
+ * @return 1 em caso de sucesso, 0 se o modelo não pôde ser lido.
+ */
+static int preditor_carregar(Preditor* p, const char* arquivo, const char* simd) {
+  if (!modelo_carregar(arquivo, &p->modelo)) return 0;
+  const CabecalhoModelo* cab = &p->modelo.cabecalho;
+  const int K = (int)cab->num_clusters, D = (int)cab->num_dimensoes;
+  NivelSimd nivel = simd_faixa_segura(cab->min_val, cab->max_val) ? simd_escolher(simd) : SIMD_ESCALAR;
+  kernel_iniciar(&p->kernel, nivel, K, D);
+  kernel_iniciar(&p->escalar, SIMD_ESCALAR, K, D);
+  p->compacto = simd_escolher_armazenamento("auto", cab->min_val, cab->max_val, D);
+  if (p->compacto) kernel_habilitar_compacto(&p->kernel);
+  p->blocado = simd_escolher_atribuicao("auto", K, p->compacto, cab->min_val, cab->max_val, D);
+  if (p->blocado) kernel_habilitar_blocado(&p->kernel, cab->min_val, cab->max_val);
+  kernel_carregar_centroides(&p->kernel, p->modelo.centroides);
+  kernel_carregar_centroides(&p->escalar, p->modelo.centroides);
+  fprintf(stderr, "Modelo '%s': %d clusters, %d dimensões, faixa de treino [%d, %d]%s\n", arquivo, K, D,
+          cab->min_val, cab->max_val, cab->flags & MODELO_FLAG_ESTATISTICAS ? ", com estatísticas" : "");
+  fprintf(stderr, "Kernel de atribuição: %s (D=%d %s), pontos: %s\n", simd_nome(nivel), D, kernel_caminho(&p->kernel),
+          p->compacto ? "int16" : "int32");
+  return 1;
+}
+
+static void preditor_liberar(Preditor* p) {
+  kernel_liberar(&p->kernel);
+  kernel_liberar(&p->escalar);
+  modelo_liberar(&p->modelo);
+}
+
+// Consultas do lote corrente
+typedef struct {
+  int capacidade;
+  int quantidade;
+  int num_dimensoes;
+  int* coords;           // [i * D + d]
+  int16_t* compactos;    // Cópia int16 do lote (modo compacto)
+  int32_t* rotulos;
+  int* cliente;          // Cliente de origem de cada consulta
+  double* chegada;       // Instante em que a consulta foi lida
+  unsigned char* valida; // 0 se a linha não pôde ser interpretada
+  double primeira;       // Chegada da consulta mais antiga do lote
+} Lote;
+
+static void lote_iniciar(Lote* l, int capacidade, int num_dimensoes) {
+  const int largura = num_dimensoes + (num_dimensoes & 1);
+  l->capacidade = capacidade;
+  l->quantidade = 0;
+  l->num_dimensoes = num_dimensoes;
+  l->coords = (int*)malloc((size_t)capacidade * num_dimensoes * sizeof(int));
+  l->compactos = (int16_t*)aligned_alloc(64, ((size_t)capacidade * largura * sizeof(int16_t) + 63) / 64 * 64);
+  l->rotulos = (int32_t*)calloc(capacidade, sizeof(int32_t));  // Lidos pelo kernel blocado
+  l->cliente = (int*)malloc(capacidade * sizeof(int));
+  l->chegada = (double*)malloc(capacidade * sizeof(double));
+  l->valida = (unsigned char*)malloc(capacidade);
+  if (l->coords == NULL || l->compactos == NULL || l->rotulos == NULL || l->cliente == NULL || l->chegada == NULL ||
+      l->valida == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+static void lote_liberar(Lote* l) {
+  free(l->coords);
+  free(l->compactos);
+  free(l->rotulos);
+  free(l->cliente);
+  free(l->chegada);
+  free(l->valida);
+}
+
+/**
+ * @brief Interpreta uma linha de 'D' inteiros em 'ponto'.
+ * @return 1 se a linha tem exatamente D inteiros válidos, 0 caso contrário.
+ */
+static int ler_ponto(const char* linha, const char* fim, int D, int* ponto) {
+  const char* p = linha;
+  for (int d = 0; d < D; d++) {
+    while (p < fim && (*p == ' ' || *p == '\t')) p++;
+    int negativo = p < fim && *p == '-';
+    if (negativo || (p < fim && *p == '+')) p++;
+    if (p == fim || *p < '0' || *p > '9') return 0;
+    long long valor = 0;
+    while (p < fim && *p >= '0' && *p <= '9') {
+      valor = valor * 10 + (*p++ - '0');
+      if (valor > (long long)INT_MAX + 1) return 0;
+    }
+    valor = negativo ? -valor : valor;
+    if (valor > INT_MAX || valor < INT_MIN) return 0;
+    ponto[d] = (int)valor;
+  }
+  while (p < fim && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+  return p == fim;
+}
+
+/**
+ * @brief Atribui todas as consultas do lote. O caminho vetorizado (blocado ou compacto)
+ * só é usado quando todos os pontos estão na faixa de valores do treino.
+ */
+static void preditor_atribuir(const Preditor* p, Lote* l) {
+  const int n = l->quantidade, D = l->num_dimensoes;
+  const int min_val = p->modelo.cabecalho.min_val, max_val = p->modelo.cabecalho.max_val;
+  int na_faixa = 1;
+  for (size_t i = 0; i < (size_t)n * D && na_faixa; i++) {
+    na_faixa = l->coords[i] >= min_val && l->coords[i] <= max_val;
+  }
+  if (na_faixa && p->compacto) {
+    simd_converter_compacto(l->coords, n, D, min_val, max_val, l->compactos);
+    if (p->blocado) {
+      kernel_atribuir_blocado(&p->kernel, l->compactos, 0, n, l->rotulos);
+    } else {
+      for (int i = 0; i < n; i++) {
+        l->rotulos[i] = kernel_mais_proximo_compacto(&p->kernel, &l->compactos[(size_t)i * p->kernel.d_par]);
+      }
+    }
+    return;
+  }
+  for (int i = 0; i < n; i++) {
+    const int* ponto = &l->coords[(size_t)i * D];
+    int dentro = 1;
+    for (int d = 0; d < D && dentro; d++) {
+      dentro = ponto[d] >= min_val && ponto[d] <= max_val;
+    }
+    l->rotulos[i] = kernel_mais_proximo(dentro ? &p->kernel : &p->escalar, ponto);
+  }
+}
+
+// Uma origem de consultas: a entrada padrão (respostas na saída padrão) ou uma conexão
+typedef struct {
+  int entrada, saida;  // Descritores (iguais para uma conexão)
+  int ativo;
+  int fim;             // A origem fechou; é removida quando não há mais respostas a enviar
+  char* pendente;      // Início de linha ainda sem '\n'
+  size_t usados, capacidade;
+  char* resposta;      // Respostas ainda não enviadas, a partir de 'enviados'
+  size_t tamanho_resposta, capacidade_resposta, enviados;
+} Cliente;
+
+static void cliente_anexar(char** buffer, size_t* usados, size_t* capacidade, const char* dados, size_t bytes) {
+  if (*usados + bytes > *capacidade) {
+    size_t nova = *capacidade > 0 ? *capacidade : 4096;
+    while (nova < *usados + bytes) nova *= 2;
+    char* novo = (char*)realloc(*buffer, nova);
+    if (novo == NULL) {
+      fprintf(stderr, "Erro: falha de alocação de memória.\n");
+      exit(EXIT_FAILURE);
+    }
+    *buffer = novo;
+    *capacidade = nova;
+  }
+  memcpy(*buffer + *usados, dados, bytes);
+  *usados += bytes;
+}
+
+/**
+ * @brief Envia o que o descritor de saída do cliente aceitar sem bloquear. Um erro de
+ * escrita (cliente desconectado) descarta as respostas restantes e encerra o cliente.
+ */
+static void cliente_enviar(Cliente* c) {
+  while (c->enviados < c->tamanho_resposta) {
+    ssize_t r = write(c->saida, c->resposta + c->enviados, c->tamanho_resposta - c->enviados);
+    if (r < 0 && errno == EINTR) continue;
+    if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+    if (r <= 0) {
+      c->fim = 1;
+      break;
+    }
+    c->enviados += (size_t)r;
+  }
+  c->tamanho_resposta = 0;
+  c->enviados = 0;
+}
+
+/** @brief O cliente fechou e não tem respostas a enviar. */
+static int cliente_encerrado(const Cliente* c) {
+  return c->fim && c->enviados == c->tamanho_resposta;
+}
+
+// Latências das consultas respondidas
+typedef struct {
+  double* amostras;  // Anel com as PREDITOR_LATENCIAS mais recentes, em segundos
+  long long consultas;
+  long long lotes;
+  double inicio;     // Chegada da primeira consulta
+  double ultima;     // Resposta da última consulta
+} Latencias;
+
+static int comparar_double(const void* a, const void* b) {
+  double x = *(const double*)a, y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+static void latencias_relatar(const Latencias* lat) {
+  if (lat->consultas == 0) {
+    fprintf(stderr, "Nenhuma consulta respondida.\n");
+    return;
+  }
+  const size_t n = lat->consultas < PREDITOR_LATENCIAS ? (size_t)lat->consultas : PREDITOR_LATENCIAS;
+  double* ordenadas = (double*)malloc(n * sizeof(double));
+  if (ordenadas == NULL) return;
+  memcpy(ordenadas, lat->amostras, n * sizeof(double));
+  qsort(ordenadas, n, sizeof(double), comparar_double);
+  const double duracao = lat->ultima - lat->inicio;
+  fprintf(stderr, "Consultas: %lld em %lld lotes (%.1f por lote), vazão: %.0f consultas/s\n", lat->consultas,
+          lat->lotes, (double)lat->consultas / lat->lotes, duracao > 0 ? lat->consultas / duracao : 0.0);
+  fprintf(stderr, "Latência: p50 %.1f us, p99 %.1f us, máxima %.1f us (últimas %zu consultas)\n",
+          1e6 * ordenadas[n / 2], 1e6 * ordenadas[(size_t)(0.99 * (n - 1))], 1e6 * ordenadas[n - 1], n);
+  free(ordenadas);
+}
+
+/**
+ * @brief Atribui o lote, põe a resposta de cada consulta no buffer de saída do cliente
+ * de origem, envia o que cada cliente aceitar e registra as latências. O lote volta vazio.
+ */
+static void responder_lote(const Preditor* p, Lote* l, Cliente* clientes, Latencias* lat) {
+  if (l->quantidade == 0) return;
+  preditor_atribuir(p, l);
+  const int D = l->num_dimensoes;
+  for (int i = 0; i < l->quantidade; i++) {
+    Cliente* c = &clientes[l->cliente[i]];
+    char linha[64];
+    int bytes;
+    if (l->valida[i]) {
+      const int cluster = l->rotulos[i];
+      bytes = snprintf(linha, sizeof(linha), "%d %lld\n", cluster,
+                       kernel_distancia(&p->escalar, &l->coords[(size_t)i * D], cluster));
+    } else {
+      bytes = snprintf(linha, sizeof(linha), "erro: esperados %d inteiros\n", D);
+    }
+    cliente_anexar(&c->resposta, &c->tamanho_resposta, &c->capacidade_resposta, linha, (size_t)bytes);
+  }
+  for (Cliente* c = clientes; c->ativo; c++) {
+    cliente_enviar(c);
+  }
+  const double t = agora();
+  for (int i = 0; i < l->quantidade; i++) {
+    lat->amostras[lat->consultas % PREDITOR_LATENCIAS] = t - l->chegada[i];
+    if (lat->consultas++ == 0) lat->inicio = l->chegada[i];
+  }
+  lat->ultima = t;
+  lat->lotes++;
+  l->quantidade = 0;
+}
+
+/**
+ * @brief Lê o que houver disponível do cliente 'indice' e põe cada linha completa no
+ * lote, respondendo o lote sempre que ele enche.
+ */
+static void ler_cliente(const Preditor* p, Lote* l, Cliente* clientes, int indice, Latencias* lat) {
+  Cliente* c = &clientes[indice];
+  char buffer[PREDITOR_LEITURA];
+  ssize_t lidos = read(c->entrada, buffer, sizeof(buffer));
+  if (lidos < 0 && (errno == EINTR || errno == EAGAIN)) return;
+  const double chegada = agora();
+  if (lidos <= 0) {
+    // Uma última linha sem '\n' ainda é uma consulta
+    if (c->usados > 0) cliente_anexar(&c->pendente, &c->usados, &c->capacidade, "\n", 1);
+    c->fim = 1;
+  } else {
+    cliente_anexar(&c->pendente, &c->usados, &c->capacidade, buffer, (size_t)lidos);
+  }
+
+  const int D = l->num_dimensoes;
+  char* inicio = c->pendente;
+  char* fim = c->pendente + c->usados;
+  char* quebra;
+  while ((quebra = memchr(inicio, '\n', (size_t)(fim - inicio))) != NULL) {
+    const char* linha_fim = quebra;
+    const char* p_linha = inicio;
+    inicio = quebra + 1;
+    while (p_linha < linha_fim && (*p_linha == ' ' || *p_linha == '\t' || *p_linha == '\r')) p_linha++;
+    if (p_linha == linha_fim) continue;  // Linhas em branco são ignoradas
+    const int i = l->quantidade++;
+    int* ponto = &l->coords[(size_t)i * D];
+    l->valida[i] = (unsigned char)ler_ponto(p_linha, linha_fim, D, ponto);
+    if (!l->valida[i]) {
+      // Ponto neutro, dentro da faixa, para não tirar o lote do caminho vetorizado
+      for (int d = 0; d < D; d++) ponto[d] = p->modelo.cabecalho.min_val;
+    }
+    l->cliente[i] = indice;
+    l->chegada[i] = chegada;
+    if (i == 0) l->primeira = chegada;
+    if (l->quantidade == l->capacidade) responder_lote(p, l, clientes, lat);
+  }
+  c->usados = (size_t)(fim - inicio);
+  memmove(c->pendente, inicio, c->usados);
+}
+
+static void uso(const char* programa) {
+  fprintf(stderr, "Uso: %s <modelo> [--socket=caminho] [--lote=N] [--janela=us] [--simd=auto|escalar|avx2|avx512]\n",
+          programa);
+  fprintf(stderr, "Exemplo: %s modelo.bin --socket=/tmp/kmeans.sock\n", programa);
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    uso(argv[0]);
+    return EXIT_FAILURE;
+  }
+  const char* arquivo = argv[1];
+  const char* caminho_socket = NULL;
+  const char* simd = "auto";
+  int tamanho_lote = PREDITOR_LOTE_PADRAO;
+  double janela = 0.0;
+  for (int i = 2; i < argc; i++) {
+    const char* arg = argv[i];
+    if (strncmp(arg, "--socket=", 9) == 0 && arg[9] != '\0') {
+      caminho_socket = arg + 9;
+    } else if (strncmp(arg, "--lote=", 7) == 0) {
+      tamanho_lote = atoi(arg + 7);
+    } else if (strncmp(arg, "--janela=", 9) == 0) {
+      janela = 1e-6 * atof(arg + 9);
+    } else if (strncmp(arg, "--simd=", 7) == 0) {
+      simd = arg + 7;
+    } else {
+      fprintf(stderr, "Erro: opção desconhecida '%s'\n", arg);
+      uso(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (tamanho_lote <= 0 || janela < 0.0) {
+    fprintf(stderr, "Erro: --lote deve ser maior que zero e --janela não pode ser negativa.\n");
+    return EXIT_FAILURE;
+  }
+
+  Preditor preditor;
+  if (!preditor_carregar(&preditor, arquivo, simd)) return EXIT_FAILURE;
+  const int D = (int)preditor.modelo.cabecalho.num_dimensoes;
+
+  // Os sinais ficam bloqueados fora do ppoll, que os libera atomicamente: um sinal que
+  // chega depois da verificação das flags interrompe a espera seguinte em vez de se perder
+  struct sigaction acao;
+  memset(&acao, 0, sizeof(acao));
+  acao.sa_handler = tratar_sinal;
+  sigemptyset(&acao.sa_mask);
+  sigaction(SIGHUP, &acao, NULL);
+  sigaction(SIGUSR1, &acao, NULL);
+  sigaction(SIGINT, &acao, NULL);
+  sigaction(SIGTERM, &acao, NULL);
+  signal(SIGPIPE, SIG_IGN);
+  sigset_t tratados, mascara_espera;
+  sigemptyset(&tratados);
+  sigaddset(&tratados, SIGHUP);
+  sigaddset(&tratados, SIGUSR1);
+  sigaddset(&tratados, SIGINT);
+  sigaddset(&tratados, SIGTERM);
+  sigprocmask(SIG_BLOCK, &tratados, &mascara_espera);
+
+  int escuta = -1;
+  if (caminho_socket != NULL) {
+    struct sockaddr_un endereco;
+    memset(&endereco, 0, sizeof(endereco));
+    endereco.sun_family = AF_UNIX;
+    if (strlen(caminho_socket) >= sizeof(endereco.sun_path)) {
+      fprintf(stderr, "Erro: caminho do socket longo demais: '%s'\n", caminho_socket);
+      return EXIT_FAILURE;
+    }
+    strcpy(endereco.sun_path, caminho_socket);
+    struct stat info;
+    if (stat(caminho_socket, &info) == 0 && S_ISSOCK(info.st_mode)) unlink(caminho_socket);
+    escuta = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (escuta < 0 || bind(escuta, (struct sockaddr*)&endereco, sizeof(endereco)) != 0 || listen(escuta, 64) != 0) {
+      perror("Erro ao abrir o socket");
+      return EXIT_FAILURE;
+    }
+    fprintf(stderr, "Aguardando consultas em '%s'\n", caminho_socket);
+  }
+
+  // Vetor de clientes terminado por um elemento inativo; sem socket, só a entrada padrão
+  int capacidade_clientes = 16, num_clientes = 0;
+  Cliente* clientes = (Cliente*)calloc(capacidade_clientes + 1, sizeof(Cliente));
+  struct pollfd* espera = (struct pollfd*)malloc((capacidade_clientes + 1) * sizeof(struct pollfd));
+  Lote lote;
+  lote_iniciar(&lote, tamanho_lote, D);
+  Latencias lat = {(double*)malloc(PREDITOR_LATENCIAS * sizeof(double)), 0, 0, 0.0, 0.0};
+  if (clientes == NULL || espera == NULL || lat.amostras == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    return EXIT_FAILURE;
+  }
+  if (escuta < 0) {
+    clientes[0].entrada = STDIN_FILENO;
+    clientes[0].saida = STDOUT_FILENO;
+    clientes[0].ativo = 1;
+    num_clientes = 1;
+  }
+
+  while (!sinal_encerrar) {
+    if (sinal_recarregar) {
+      sinal_recarregar = 0;
+      responder_lote(&preditor, &lote, clientes, &lat);
+      Preditor novo;
+      if (!preditor_carregar(&novo, arquivo, simd)) {
+        fprintf(stderr, "Aviso: mantendo o modelo anterior.\n");
+      } else if ((int)novo.modelo.cabecalho.num_dimensoes != D) {
+        fprintf(stderr, "Aviso: o novo modelo tem %u dimensões em vez de %d; mantendo o modelo anterior.\n",
+                novo.modelo.cabecalho.num_dimensoes, D);
+        preditor_liberar(&novo);
+      } else {
+        preditor_liberar(&preditor);
+        preditor = novo;
+        fprintf(stderr, "Modelo recarregado.\n");
+      }
+    }
+    if (sinal_relatar) {
+      sinal_relatar = 0;
+      latencias_relatar(&lat);
+    }
+
+    int n = 0;
+    if (escuta >= 0) espera[n++] = (struct pollfd){escuta, POLLIN, 0};
+    for (int c = 0; c < num_clientes; c++) {
+      // Quem fechou ou tem respostas demais pendentes só é esperado para escrita
+      const Cliente* cl = &clientes[c];
+      const size_t pendentes = cl->tamanho_resposta - cl->enviados;
+      short eventos = !cl->fim && pendentes < PREDITOR_SAIDA_PENDENTE ? POLLIN : 0;
+      if (pendentes > 0) eventos |= POLLOUT;
+      espera[n++] = (struct pollfd){cl->entrada, eventos, 0};
+    }
+    struct timespec limite = {0, 0};
+    if (lote.quantidade > 0) {
+      const double restante = lote.primeira + janela - agora();
+      if (restante > 0) {
+        limite.tv_sec = (time_t)restante;
+        limite.tv_nsec = (long)((restante - (double)limite.tv_sec) * 1e9);
+      }
+    }
+    int prontos = ppoll(espera, n, lote.quantidade > 0 ? &limite : NULL, &mascara_espera);
+    if (prontos < 0) {
+      if (errno == EINTR) continue;
+      perror("Erro em ppoll");
+      break;
+    }
+
+    int k = 0;
+    if (escuta >= 0 && (espera[k++].revents & POLLIN)) {
+      int conexao = accept(escuta, NULL, NULL);
+      if (conexao >= 0 && fcntl(conexao, F_SETFL, fcntl(conexao, F_GETFL) | O_NONBLOCK) != 0) {
+        close(conexao);
+        conexao = -1;
+      }
+      if (conexao >= 0) {
+        if (num_clientes == capacidade_clientes) {
+          capacidade_clientes *= 2;
+          Cliente* mais = (Cliente*)realloc(clientes, (capacidade_clientes + 1) * sizeof(Cliente));
+          struct pollfd* mais_espera =
+              (struct pollfd*)realloc(espera, (capacidade_clientes + 1) * sizeof(struct pollfd));
+          if (mais == NULL || mais_espera == NULL) {
+            fprintf(stderr, "Erro: falha de alocação de memória.\n");
+            return EXIT_FAILURE;
+          }
+          clientes = mais;
+          espera = mais_espera;
+        }
+        memset(&clientes[num_clientes], 0, 2 * sizeof(Cliente));
+        clientes[num_clientes].entrada = clientes[num_clientes].saida = conexao;
+        clientes[num_clientes].ativo = 1;
+        num_clientes++;
+      }
+    }
+    for (int c = 0; c < num_clientes; c++, k++) {
+      if ((espera[k].revents & (POLLOUT | POLLHUP | POLLERR)) && clientes[c].tamanho_resposta > 0) {
+        cliente_enviar(&clientes[c]);
+      }
+      if (!clientes[c].fim && (espera[k].revents & (POLLIN | POLLHUP | POLLERR))) {
+        ler_cliente(&preditor, &lote, clientes, c, &lat);
+      }
+    }
+
+    // Sem janela, o lote é respondido com o que chegou junto; com janela, quando ela vence
+    int encerrados = 0;
+    for (int c = 0; c < num_clientes; c++) encerrados |= cliente_encerrado(&clientes[c]);
+    if (lote.quantidade > 0 && (encerrados || agora() >= lote.primeira + janela)) {
+      responder_lote(&preditor, &lote, clientes, &lat);
+    }
+
+    // Remove os clientes encerrados (o lote já foi respondido)
+    int mantidos = 0;
+    for (int c = 0; c < num_clientes; c++) {
+      if (cliente_encerrado(&clientes[c])) {
+        if (clientes[c].entrada != STDIN_FILENO) close(clientes[c].entrada);
+        free(clientes[c].pendente);
+        free(clientes[c].resposta);
+      } else {
+        clientes[mantidos++] = clientes[c];
+      }
+    }
+    memset(&clientes[mantidos], 0, sizeof(Cliente));
+    num_clientes = mantidos;
+    if (escuta < 0 && num_clientes == 0) break;  // Fim da entrada padrão
+  }
+
+  responder_lote(&preditor, &lote, clientes, &lat);
+  latencias_relatar(&lat);
+
+  for (int c = 0; c < num_clientes; c++) {
+    if (clientes[c].entrada != STDIN_FILENO) close(clientes[c].entrada);
+    free(clientes[c].pendente);
+    free(clientes[c].resposta);
+  }
+  if (escuta >= 0) {
+    close(escuta);
+    unlink(caminho_socket);
+  }
+  free(clientes);
+  free(espera);
+  free(lat.amostras);
+  lote_liberar(&lote);
+  preditor_liberar(&preditor);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,628 @@
+#define _GNU_SOURCE  // Necessário para CLOCK_MONOTONIC, pthread_barrier_t, sched_setaffinity e syscall
+#include <limits.h>  // Para LLONG_MAX
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>  // Header correto para clock_gettime e struct timespec
+
+#include "kmeans_dataset.h"
+#include "kmeans_hamerly.h"
+#include "kmeans_incremental.h"
+#include "kmeans_inicializacao.h"
+#include "kmeans_modelo.h"
+#include "kmeans_numa.h"
+#include "kmeans_opcoes.h"
+#include "kmeans_perfil.h"
+#include "kmeans_simd.h"
+
+#define LINHA_CACHE 64
+#define TAM_BLOCO 1024  // Pontos por bloco de trabalho na fase de atribuição
+
+/**
+ * Fila de blocos de uma thread, no intervalo [inicio, fim). O dono e as threads
+ * que roubam trabalho retiram blocos com o mesmo fetch_add, então um bloco nunca
+ * é processado duas vezes. Cada fila ocupa sua própria linha de cache.
+ */
+typedef struct {
+  _Alignas(LINHA_CACHE) atomic_int proximo;
+  int inicio;
+  int fim;
+} FilaBlocos;
+
+/**
+ * Contadores de convergência de uma thread (modo --convergencia). Há duas cópias,
+ * indexadas pela paridade da iteração: uma thread que já começou a iteração
+ * seguinte escreve na outra cópia enquanto as demais ainda leem a anterior.
+ */
+typedef struct {
+  _Alignas(LINHA_CACHE) long long mudancas[2];  // Pontos que mudaram de cluster
+  long long maior_desloc[2];                    // Maior deslocamento de centroide, ao quadrado
+} ContadoresThread;
+
+/**
+ * Estado compartilhado do motor. As threads são criadas uma única vez e executam
+ * todas as iterações; cada iteração é dividida em três fases separadas por barreiras:
+ *   1. Atribuição: blocos de pontos com roubo de trabalho entre as filas.
+ *   2. Acumulação: cada thread soma sua faixa estática de pontos (a mesma da sua fila
+ *      de blocos) em buffers privados. Com --incremental, depois da primeira iteração,
+ *      soma só a diferença causada pelos pontos da sua lista de mudanças.
+ *   3. Redução: cada thread reduz uma faixa de clusters somando os parciais de todas
+ *      as threads, atualiza esses centroides e os recarrega no kernel.
+ */
+typedef struct {
+  ConjuntoPontos* points;
+  int* centroids;
+  KernelAtribuicao* kernel;
+  EstadoHamerly* hamerly;  // NULL quando --hamerly não foi pedido
+  EstadoIncremental* incremental;  // NULL quando --incremental não foi pedido
+  PontosCompactos compacto;  // Cópia int16 dos pontos (coords == NULL fora do modo compacto)
+  int num_pontos;
+  int num_clusters;
+  int num_dimensoes;
+  int num_iteracoes;
+  int num_threads;
+  const OpcoesKMeans* opcoes;
+  int iteracoes_executadas;  // Escrito pela thread 0
+
+  FilaBlocos* filas;
+  long long** somas_parciais;  // [thread][k * D + d]
+  int** contagens_parciais;    // [thread][k]
+  ContadoresThread* contadores;  // [thread]
+  pthread_barrier_t barreira;
+
+  PosicionamentoNuma numa;  // Topologia usada para fixar as threads e réplicas por nó (--numa)
+  MigracaoNuma migracao;    // Vetores originais enquanto as threads copiam suas faixas
+  Perfil* perfil;           // Instrumentação por fase (--perfil); desligada por padrão
+
+  struct timespec inicio, fim;  // Medidos pela thread 0
+} Motor;
+
+typedef struct {
+  Motor* motor;
+  int id;
+  pthread_t thread;
+  long long avaliacoes;  // Distâncias calculadas por esta thread no modo --hamerly
+} Trabalhador;
+
+// --- Funções Utilitárias ---
+
+/**
+ * @brief Aloca memória alinhada à linha de cache, arredondando o tamanho para evitar
+ * falso compartilhamento com a alocação seguinte.
+ */
+static void* alocar_alinhado(size_t bytes) {
+  size_t tamanho = (bytes + LINHA_CACHE - 1) / LINHA_CACHE * LINHA_CACHE;
+  void* ptr = aligned_alloc(LINHA_CACHE, tamanho > 0 ? tamanho : LINHA_CACHE);
+  if (ptr == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    exit(EXIT_FAILURE);
+  }
+  return ptr;
+}
+
+// --- Funções Principais do K-Means ---
+
+/**
+ * @brief Inicializa os centroides escolhendo K pontos aleatórios do dataset.
+ */
+void initialize_centroids(const ConjuntoPontos* points, int* centroids, int num_pontos, int num_clusters,
+                          int num_dimensoes) {
+  srand(42);  // Semente fixa para reprodutibilidade
+
+  int* indices = (int*)malloc(num_pontos * sizeof(int));
+  if (indices == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int i = 0; i < num_pontos; i++) {
+    indices[i] = i;
+  }
+
+  for (int i = 0; i < num_pontos; i++) {
+    int j = rand() % num_pontos;
+    int temp = indices[i];
+    indices[i] = indices[j];
+    indices[j] = temp;
+  }
+
+  for (int i = 0; i < num_clusters; i++) {
+    memcpy(&centroids[(size_t)i * num_dimensoes], pontos_ponto(points, indices[i]), num_dimensoes * sizeof(int));
+  }
+
+  free(indices);
+}
+
+/**
+ * @brief Fase de Atribuição: esvazia a própria fila de blocos e depois rouba blocos
+ * das filas das outras threads, em ordem circular, até não restar trabalho.
+ * No modo --hamerly os pontos são atribuídos com poda (ver kmeans_hamerly.h). Com
+ * --incremental, os pontos que mudaram (inclusive os de blocos roubados) vão para a
+ * lista da thread.
+ */
+static void assign_points_to_clusters(Motor* m, Trabalhador* t, long long* distancias, int paridade) {
+  EstadoHamerly* h = m->hamerly;
+  ListaMudancas* lista = incremental_lista(m->incremental, t->id);
+  // Com --numa, cada thread lê os centroides da réplica do seu nó
+  const KernelAtribuicao* k = m->numa.ativo ? &m->numa.replicas[m->numa.no_thread[t->id]] : m->kernel;
+  long long avaliacoes = 0, mudancas = 0;
+  for (int v = 0; v < m->num_threads; v++) {
+    FilaBlocos* fila = &m->filas[(t->id + v) % m->num_threads];
+    int bloco;
+    while ((bloco = atomic_fetch_add_explicit(&fila->proximo, 1, memory_order_relaxed)) < fila->fim) {
+      int ini = bloco * TAM_BLOCO;
+      int fim = ini + TAM_BLOCO < m->num_pontos ? ini + TAM_BLOCO : m->num_pontos;
+      int32_t* rotulos = m->points->rotulos;
+      if (h != NULL) {
+        for (int i = ini; i < fim; i++) {
+          int atual = h->iniciado ? rotulos[i] : -1;
+          int cluster_id =
+              hamerly_atribuir_ponto(h, m->kernel, i, pontos_ponto(m->points, i), atual, distancias, &avaliacoes);
+          if (lista != NULL && cluster_id != rotulos[i]) incremental_registrar(lista, i, rotulos[i]);
+          mudancas += cluster_id != rotulos[i];
+          rotulos[i] = cluster_id;
+        }
+      } else if (m->points->colunas != NULL || k->coords_b != NULL) {
+        mudancas += incremental_atribuir_faixa(k, m->points, &m->compacto, ini, fim, lista);
+      } else {
+        for (int i = ini; i < fim; i++) {
+          int cluster_id =
+              m->compacto.coords != NULL
+                  ? kernel_mais_proximo_compacto(k, &m->compacto.coords[(size_t)i * m->compacto.largura])
+                  : kernel_mais_proximo(k, pontos_ponto(m->points, i));
+          if (lista != NULL && cluster_id != rotulos[i]) incremental_registrar(lista, i, rotulos[i]);
+          mudancas += cluster_id != rotulos[i];
+          rotulos[i] = cluster_id;
+        }
+      }
+    }
+  }
+  t->avaliacoes += avaliacoes;
+  m->contadores[t->id].mudancas[paridade] = mudancas;
+}
+
+/**
+ * @brief Faixa estática de pontos da thread: os blocos da sua própria fila. É a faixa
+ * que ela acumula e, com --numa, a que ela copia para a memória do seu nó.
+ */
+static void faixa_thread(const Motor* m, int id, int* ini, int* fim) {
+  *ini = m->filas[id].inicio * TAM_BLOCO;
+  *fim = m->filas[id].fim * TAM_BLOCO < m->num_pontos ? m->filas[id].fim * TAM_BLOCO : m->num_pontos;
+  if (*ini > *fim) *ini = *fim;
+}
+
+/**
+ * @brief Fase de Acumulação: soma a faixa estática de pontos da thread nos seus
+ * buffers privados, sem nenhuma sincronização. Com 'por_mudancas', os buffers recebem
+ * só a diferença causada pelas mudanças da lista da thread.
+ */
+static void accumulate_partial_sums(Motor* m, int id, int por_mudancas) {
+  const int D = m->num_dimensoes;
+  long long* somas = m->somas_parciais[id];
+  int* contagens = m->contagens_parciais[id];
+  memset(somas, 0, (size_t)m->num_clusters * D * sizeof(long long));
+  memset(contagens, 0, (size_t)m->num_clusters * sizeof(int));
+  if (por_mudancas) {
+    incremental_aplicar(&m->incremental->listas[id], m->points, &m->compacto, somas, contagens, D);
+    return;
+  }
+
+  int ini, fim;
+  faixa_thread(m, id, &ini, &fim);
+  for (int i = ini; i < fim; i++) {
+    int cluster_id = m->points->rotulos[i];
+    contagens[cluster_id]++;
+    if (m->compacto.coords != NULL) {
+      kernel_somar_compacto(&somas[cluster_id * D], &m->compacto.coords[(size_t)i * m->compacto.largura], D);
+    } else {
+      kernel_somar(&somas[cluster_id * D], pontos_ponto(m->points, i), D);
+    }
+  }
+}
+
+/**
+ * @brief Fase de Atualização: reduz os parciais de todas as threads para a faixa de
+ * clusters desta thread e recalcula esses centroides (divisão inteira). Com
+ * --incremental, os parciais são somados às somas correntes (ou as substituem, quando
+ * a acumulação foi completa).
+ */
+static void update_centroids(Motor* m, int id, int paridade, int por_mudancas) {
+  EstadoIncremental* inc = m->incremental;
+  const int D = m->num_dimensoes;
+  int ini = (int)((long long)m->num_clusters * id / m->num_threads);
+  int fim = (int)((long long)m->num_clusters * (id + 1) / m->num_threads);
+  long long maior_desloc = 0;
+
+  for (int c = ini; c < fim; c++) {
+    long long contagem = 0;
+    for (int t = 0; t < m->num_threads; t++) {
+      contagem += m->contagens_parciais[t][c];
+    }
+    if (inc != NULL) {
+      // As somas correntes são atualizadas mesmo quando o cluster fica vazio
+      contagem += por_mudancas ? inc->contagens[c] : 0;
+      inc->contagens[c] = (int)contagem;
+      for (int j = 0; j < D; j++) {
+        long long soma = por_mudancas ? inc->somas[c * D + j] : 0;
+        for (int t = 0; t < m->num_threads; t++) {
+          soma += m->somas_parciais[t][c * D + j];
+        }
+        inc->somas[c * D + j] = soma;
+      }
+    }
+    if (contagem == 0) continue;
+    long long desloc = 0;
+    for (int j = 0; j < D; j++) {
+      long long soma = 0;
+      if (inc != NULL) {
+        soma = inc->somas[c * D + j];
+      } else {
+        for (int t = 0; t < m->num_threads; t++) {
+          soma += m->somas_parciais[t][c * D + j];
+        }
+      }
+      // Divisão inteira para manter os centroides em coordenadas discretas
+      int novo = soma / contagem;
+      long long diff = (long long)novo - m->centroids[c * D + j];
+      desloc += diff * diff;
+      m->centroids[c * D + j] = novo;
+    }
+    if (desloc > maior_desloc) maior_desloc = desloc;
+  }
+  m->contadores[id].maior_desloc[paridade] = maior_desloc;
+  if (fim > ini) {
+    kernel_carregar_faixa(m->kernel, m->centroids, ini, fim);
+  }
+
+  // Prepara a fila desta thread para a próxima iteração (a fase 1 já terminou)
+  atomic_store_explicit(&m->filas[id].proximo, m->filas[id].inicio, memory_order_relaxed);
+  if (id == 0 && m->hamerly != NULL) {
+    hamerly_concluir_iteracao(m->hamerly);
+  }
+  // As listas já foram lidas por todas as threads na acumulação
+  if (id == 0 && inc != NULL) {
+    incremental_concluir(inc);
+  }
+}
+
+/**
+ * @brief Corpo das threads do motor (a thread principal executa como id 0).
+ */
+static void* executar_trabalhador(void* arg) {
+  Trabalhador* t = (Trabalhador*)arg;
+  Motor* m = t->motor;
+  const int id = t->id;
+
+  numa_fixar(&m->numa.topologia, id);
+  if (m->numa.ativo) {
+    // Cópia da faixa estática da thread e réplica do kernel do nó, tocadas primeiro aqui
+    int ini, fim;
+    faixa_thread(m, id, &ini, &fim);
+    numa_migracao_faixa(&m->migracao, m->points, &m->compacto, ini, fim);
+    const int no = m->numa.no_thread[id];
+    if (m->numa.lider[no] == id) numa_preparar_replica(&m->numa, no, m->kernel);
+  }
+  // Buffers parciais alocados e zerados pela própria thread (first touch na CPU dela)
+  m->somas_parciais[id] = (long long*)alocar_alinhado((size_t)m->num_clusters * m->num_dimensoes * sizeof(long long));
+  m->contagens_parciais[id] = (int*)alocar_alinhado((size_t)m->num_clusters * sizeof(int));
+  long long* distancias = m->hamerly != NULL ? (long long*)alocar_alinhado(m->num_clusters * sizeof(long long)) : NULL;
+  t->avaliacoes = 0;
+  perfil_abrir_contadores(m->perfil, id);
+
+  pthread_barrier_wait(&m->barreira);
+  if (id == 0) {
+    if (m->numa.ativo) numa_migracao_concluir(&m->migracao);
+    clock_gettime(CLOCK_MONOTONIC, &m->inicio);
+  }
+
+  // Com --perfil, cada trecho é registrado na sua fase e cada barreira como espera
+  Perfil* p = m->perfil;
+  int iter = 0;
+  perfil_marcar(p, id);
+  while (iter < m->num_iteracoes) {
+    const int paridade = iter & 1;
+    if (m->hamerly != NULL) {
+      // Deslocamentos e separações dos centroides são calculados uma vez por iteração
+      if (id == 0) hamerly_preparar_iteracao(m->hamerly, m->kernel);
+      perfil_fase(p, id, iter, FASE_ATRIBUICAO);
+      pthread_barrier_wait(&m->barreira);
+      perfil_fase(p, id, iter, FASE_ESPERA);
+    }
+    if (m->numa.ativo) {
+      const int no = m->numa.no_thread[id];
+      if (m->numa.lider[no] == id) kernel_carregar_centroides(&m->numa.replicas[no], m->centroids);
+      perfil_fase(p, id, iter, FASE_ATRIBUICAO);
+      pthread_barrier_wait(&m->barreira);
+      perfil_fase(p, id, iter, FASE_ESPERA);
+    }
+    assign_points_to_clusters(m, t, distancias, paridade);
+    perfil_fase(p, id, iter, FASE_ATRIBUICAO);
+    pthread_barrier_wait(&m->barreira);
+    perfil_fase(p, id, iter, FASE_ESPERA);
+    // Decisão tomada por todas as threads sobre as mesmas listas, já completas
+    const int por_mudancas = m->incremental != NULL && incremental_pronto(m->incremental);
+    accumulate_partial_sums(m, id, por_mudancas);
+    perfil_fase(p, id, iter, FASE_ATUALIZACAO);
+    pthread_barrier_wait(&m->barreira);
+    perfil_fase(p, id, iter, FASE_ESPERA);
+    update_centroids(m, id, paridade, por_mudancas);
+    perfil_fase(p, id, iter, FASE_REDUCAO);
+    pthread_barrier_wait(&m->barreira);
+    perfil_fase(p, id, iter, FASE_ESPERA);
+    iter++;
+
+    if (m->opcoes->convergencia) {
+      // Todas as threads leem os mesmos contadores e chegam à mesma decisão, sem barreira extra
+      long long mudancas = 0, maior_desloc = 0;
+      for (int k = 0; k < m->num_threads; k++) {
+        const ContadoresThread* c = &m->contadores[k];
+        mudancas += c->mudancas[paridade];
+        if (c->maior_desloc[paridade] > maior_desloc) maior_desloc = c->maior_desloc[paridade];
+      }
+      if (opcoes_convergiu(m->opcoes, mudancas, maior_desloc)) break;
+    }
+  }
+
+  if (id == 0) {
+    clock_gettime(CLOCK_MONOTONIC, &m->fim);
+    m->iteracoes_executadas = iter;
+  }
+  free(distancias);
+  return NULL;
+}
+
+/**
+ * @brief Imprime os resultados finais e o checksum (como long long).
+ */
+void print_results(const int* centroids, int num_clusters, int num_dimensoes) {
+  printf("--- Centroides Finais ---\n");
+  long long checksum = 0;
+  for (int i = 0; i < num_clusters; i++) {
+    printf("Centroide %d: [", i);
+    for (int j = 0; j < num_dimensoes; j++) {
+      printf("%d", centroids[i * num_dimensoes + j]);
+      if (j < num_dimensoes - 1) printf(", ");
+      checksum += centroids[i * num_dimensoes + j];
+    }
+    printf("]\n");
+  }
+  printf("\n--- Checksum ---\n");
+  printf("%lld\n", checksum);  // %lld para long long int
+}
+
+/**
+ * @brief Calcula e imprime o tempo de execução e o checksum final.
+ * A saída é formatada para ser facilmente lida por scripts:
+ * Linha 1: Tempo de execução em segundos (double)
+ * Linha 2: Checksum final (long long)
+ */
+void print_time_and_checksum(const int* centroids, int num_clusters, int num_dimensoes, double exec_time) {
+  long long checksum = 0;
+  for (int i = 0; i < num_clusters; i++) {
+    for (int j = 0; j < num_dimensoes; j++) {
+      checksum += centroids[i * num_dimensoes + j];
+    }
+  }
+  // Saída formatada para o avaliador
+  printf("%lf\n", exec_time);
+  printf("%lld\n", checksum);
+}
+
+// --- Função Principal ---
+
+int main(int argc, char* argv[]) {
+  // Validação e leitura dos argumentos de linha de comando
+  if (argc < 6) {
+    fprintf(stderr, "Uso: %s <arquivo_dados> <num_pontos> <num_dimensoes> <num_clusters> <num_iteracoes> [opcoes]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const char* filename = argv[1];
+  const int num_pontos = atoi(argv[2]);
+  const int num_dimensoes = atoi(argv[3]);
+  const int num_clusters = atoi(argv[4]);
+  const int num_iteracoes = atoi(argv[5]);
+
+  OpcoesKMeans opcoes;
+  opcoes_ler(argc, argv, 6, &opcoes);
+  if (opcoes.minibatch > 0) {
+    fprintf(stderr, "Erro: o modo --minibatch não está disponível na versão Pthreads.\n");
+    return EXIT_FAILURE;
+  }
+  if (opcoes.streaming > 0) {
+    fprintf(stderr, "Erro: o modo --streaming não está disponível na versão Pthreads.\n");
+    return EXIT_FAILURE;
+  }
+  if (opcoes.kdtree) {
+    fprintf(stderr, "Erro: o modo --kdtree não está disponível na versão Pthreads.\n");
+    return EXIT_FAILURE;
+  }
+  if (opcoes.execucoes > 0) {
+    fprintf(stderr, "Erro: o modo --execucoes não está disponível na versão Pthreads.\n");
+    return EXIT_FAILURE;
+  }
+
+  if (num_pontos <= 0 || num_dimensoes <= 0 || num_clusters <= 0 || num_iteracoes <= 0 || num_clusters > num_pontos) {
+    fprintf(stderr, "Erro nos parâmetros. Verifique se Numero de pontos, Numero de dimensoes, Numero de clusters,\
+                        Numero de Iteracoes > 0 e Numero de clusters <= Numero de pontos.\n");
+    return EXIT_FAILURE;
+  }
+
+  // --- Alocação de Memória ---
+  // Um dataset binário é mapeado direto do arquivo; um de texto é lido para uma matriz alocada.
+  // A faixa de valores vem do cabeçalho binário ou é calculada durante a leitura do texto.
+  ConjuntoPontos points;
+  DatasetBinario binario;
+  int min_val, max_val;
+  const int eh_binario = pontos_carregar(filename, num_pontos, num_dimensoes, opcoes.num_threads, &points, &binario,
+                                         &min_val, &max_val);
+  int* centroids = (int*)malloc((size_t)num_clusters * num_dimensoes * sizeof(int));
+  if (centroids == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    return EXIT_FAILURE;
+  }
+
+  // --- Preparação (Fora da medição de tempo) ---
+  NivelSimd nivel = simd_faixa_segura(min_val, max_val) ? simd_escolher(opcoes.simd) : SIMD_ESCALAR;
+  if (opcoes.inicializacao_paralela && kmpar_faixa_segura(num_pontos, num_dimensoes, min_val, max_val)) {
+    int candidatos = kmpar_inicializar(points.coords, num_pontos, num_dimensoes, num_clusters, opcoes.semente, nivel,
+                                       centroids);
+    fprintf(stderr, "Inicialização k-means||: %d candidatos\n", candidatos);
+  } else {
+    if (opcoes.inicializacao_paralela) {
+      fprintf(stderr, "Aviso: faixa de valores grande demais para k-means||, usando a inicialização aleatória.\n");
+    }
+    initialize_centroids(&points, centroids, num_pontos, num_clusters, num_dimensoes);
+  }
+  KernelAtribuicao kernel;
+  kernel_iniciar(&kernel, nivel, num_clusters, num_dimensoes);
+
+  Motor motor;
+  motor.compacto.coords = NULL;
+  if (opcoes.colunas && !opcoes.hamerly) {
+    pontos_gerar_colunas(&points);
+  } else if (!opcoes.hamerly && simd_escolher_armazenamento(opcoes.armazenamento, min_val, max_val, num_dimensoes)) {
+    simd_compactar(points.coords, num_pontos, num_dimensoes, min_val, max_val, &motor.compacto);
+    kernel_habilitar_compacto(&kernel);
+  }
+  if (simd_escolher_atribuicao(opcoes.atribuicao, num_clusters, motor.compacto.coords != NULL, min_val, max_val,
+                               num_dimensoes)) {
+    kernel_habilitar_blocado(&kernel, min_val, max_val);
+  }
+  kernel_carregar_centroides(&kernel, centroids);
+  motor.points = &points;
+  motor.centroids = centroids;
+  motor.kernel = &kernel;
+  EstadoHamerly hamerly;
+  motor.hamerly = NULL;
+  if (opcoes.hamerly) {
+    hamerly_iniciar(&hamerly, num_pontos, num_clusters, num_dimensoes, min_val, max_val);
+    motor.hamerly = &hamerly;
+  }
+  motor.num_pontos = num_pontos;
+  motor.num_clusters = num_clusters;
+  motor.num_dimensoes = num_dimensoes;
+  motor.num_iteracoes = num_iteracoes;
+  motor.opcoes = &opcoes;
+  numa_iniciar(&motor.numa, opcoes.numa, opcoes.num_threads);
+  motor.num_threads = motor.numa.num_threads;
+  EstadoIncremental incremental;
+  motor.incremental = NULL;
+  if (opcoes.incremental) {
+    incremental_iniciar(&incremental, num_pontos, num_clusters, num_dimensoes, motor.num_threads);
+    motor.incremental = &incremental;
+  }
+  fprintf(stderr, "Kernel de atribuição: %s (D=%d %s), pontos: %s, threads: %d\n", simd_nome(nivel), num_dimensoes,
+          kernel_caminho(&kernel), simd_descrever_pontos(&motor.compacto, points.colunas != NULL), motor.num_threads);
+
+  // Blocos distribuídos em faixas contíguas, uma fila por thread
+  const int T = motor.num_threads;
+  const int num_blocos = (num_pontos + TAM_BLOCO - 1) / TAM_BLOCO;
+  motor.filas = (FilaBlocos*)alocar_alinhado(T * sizeof(FilaBlocos));
+  for (int t = 0; t < T; t++) {
+    motor.filas[t].inicio = (int)((long long)num_blocos * t / T);
+    motor.filas[t].fim = (int)((long long)num_blocos * (t + 1) / T);
+    atomic_init(&motor.filas[t].proximo, motor.filas[t].inicio);
+  }
+  motor.somas_parciais = (long long**)calloc(T, sizeof(long long*));
+  motor.contagens_parciais = (int**)calloc(T, sizeof(int*));
+  if (motor.somas_parciais == NULL || motor.contagens_parciais == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    return EXIT_FAILURE;
+  }
+  motor.contadores = (ContadoresThread*)alocar_alinhado(T * sizeof(ContadoresThread));
+  pthread_barrier_init(&motor.barreira, NULL, T);
+  Perfil perfil;
+  perfil_iniciar(&perfil, opcoes.perfil, T, num_iteracoes);
+  motor.perfil = &perfil;
+  if (motor.numa.ativo) {
+    // Os vetores por ponto são trocados por vetores novos, preenchidos pelas threads
+    numa_migracao_iniciar(&motor.migracao, &points, &motor.compacto);
+    fprintf(stderr, "NUMA: %d nó(s), %d threads fixadas\n", motor.numa.topologia.num_nos, T);
+  }
+
+  // --- Execução (o tempo é medido pela thread 0 entre a primeira e a última barreira) ---
+  Trabalhador* trabalhadores = (Trabalhador*)malloc(T * sizeof(Trabalhador));
+  if (trabalhadores == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    return EXIT_FAILURE;
+  }
+  for (int t = 0; t < T; t++) {
+    trabalhadores[t].motor = &motor;
+    trabalhadores[t].id = t;
+  }
+  for (int t = 1; t < T; t++) {
+    if (pthread_create(&trabalhadores[t].thread, NULL, executar_trabalhador, &trabalhadores[t]) != 0) {
+      fprintf(stderr, "Erro: falha ao criar a thread %d.\n", t);
+      return EXIT_FAILURE;
+    }
+  }
+  executar_trabalhador(&trabalhadores[0]);
+  for (int t = 1; t < T; t++) {
+    pthread_join(trabalhadores[t].thread, NULL);
+  }
+
+  // Calcula o tempo decorrido em segundos
+  double time_taken = (motor.fim.tv_sec - motor.inicio.tv_sec) + 1e-9 * (motor.fim.tv_nsec - motor.inicio.tv_nsec);
+
+  // --- Apresentação dos Resultados ---
+  print_time_and_checksum(centroids, num_clusters, num_dimensoes, time_taken);
+  if (opcoes.hamerly) {
+    long long avaliacoes = 0;
+    for (int t = 0; t < T; t++) {
+      avaliacoes += trabalhadores[t].avaliacoes;
+    }
+    fprintf(stderr, "Hamerly: %lld de %lld distâncias calculadas (%.1f%%)\n", avaliacoes,
+            (long long)num_pontos * num_clusters * motor.iteracoes_executadas,
+            100.0 * avaliacoes / ((double)num_pontos * num_clusters * motor.iteracoes_executadas));
+  }
+  if (opcoes.convergencia) {
+    fprintf(stderr, "Iterações executadas: %d de %d\n", motor.iteracoes_executadas, num_iteracoes);
+  }
+  perfil_escrever(&perfil, "pthreads", "threads", num_pontos, num_dimensoes, num_clusters, motor.iteracoes_executadas,
+                  time_taken);
+  if (opcoes.modelo != NULL) {
+    // Com --estatisticas, uma passada extra atribui os pontos aos centroides finais
+    ModeloKMeans modelo;
+    modelo_iniciar(&modelo, centroids, num_clusters, num_dimensoes, min_val, max_val, num_pontos,
+                   motor.iteracoes_executadas, opcoes.estatisticas);
+    if (opcoes.estatisticas) {
+      kernel_carregar_centroides(&kernel, centroids);
+      modelo_acumular_estatisticas(&modelo, &kernel, points.coords, num_pontos);
+    }
+    if (modelo_salvar(&modelo, opcoes.modelo) == 0) {
+      fprintf(stderr, "Modelo gravado em '%s'\n", opcoes.modelo);
+    }
+    modelo_liberar(&modelo);
+  }
+
+  // --- Limpeza ---
+  perfil_liberar(&perfil);
+  pthread_barrier_destroy(&motor.barreira);
+  for (int t = 0; t < T; t++) {
+    free(motor.somas_parciais[t]);
+    free(motor.contagens_parciais[t]);
+  }
+  free(motor.somas_parciais);
+  free(motor.contagens_parciais);
+  free(motor.contadores);
+  free(motor.filas);
+  numa_liberar(&motor.numa);
+  free(trabalhadores);
+  if (opcoes.hamerly) {
+    hamerly_liberar(&hamerly);
+  }
+  if (opcoes.incremental) {
+    incremental_liberar(&incremental);
+  }
+  kernel_liberar(&kernel);
+  free(motor.compacto.coords);
+  pontos_liberar(&points);
+  if (eh_binario) {
+    dataset_binario_fechar(&binario);
+  }
+  free(centroids);
+
+  return EXIT_SUCCESS;
+}
@@ -1,64 +1,37 @@
-#define _POSIX_C_SOURCE 199309L  // Necessário para CLOCK_MONOTONIC
-#include <limits.h>              // Para LLONG_MAX
+#define _GNU_SOURCE  // Necessário para CLOCK_MONOTONIC e syscall (perf_event_open)
+#include <limits.h>  // Para LLONG_MAX
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>  // Header correto para clock_gettime e struct timespec
 
-// Estrutura para representar um ponto no espaço D-dimensional
-typedef struct {
-  int* coords;     // Vetor de coordenadas inteiras
-  int cluster_id;  // ID do cluster ao qual o ponto pertence
-} Point;
-
-// --- Funções Utilitárias ---
-
-/**
- * @brief Calcula a distância Euclidiana ao quadrado entre dois pontos com coordenadas inteiras.
- * Usa 'long long' para evitar overflow no cálculo da distância e da diferença.
- * @return A distância Euclidiana ao quadrado como um long long.
- */
-long long euclidean_dist_sq(Point* p1, Point* p2, int num_dimensoes) {
-  long long dist = 0;
-  for (int i = 0; i < num_dimensoes; i++) {
-    long long diff = (long long)p1->coords[i] - p2->coords[i];
-    dist += diff * diff;
-  }
-  return dist;
-}
+#include "kmeans_dataset.h"
+#include "kmeans_execucoes.h"
+#include "kmeans_hamerly.h"
+#include "kmeans_incremental.h"
+#include "kmeans_inicializacao.h"
+#include "kmeans_kdtree.h"
+#include "kmeans_minibatch.h"
+#include "kmeans_modelo.h"
+#include "kmeans_opcoes.h"
+#include "kmeans_perfil.h"
+#include "kmeans_simd.h"
+#include "kmeans_streaming.h"
 
 // --- Funções Principais do K-Means ---
 
-/**
- * @brief Lê os dados de pontos (inteiros) de um arquivo de texto.
- */
-void read_data_from_file(const char* filename, Point* points, int num_pontos, int num_dimensoes) {
-  FILE* file = fopen(filename, "r");
-  if (file == NULL) {
-    fprintf(stderr, "Erro: Não foi possível abrir o arquivo '%s'\n", filename);
-    exit(EXIT_FAILURE);
-  }
-
-  for (int i = 0; i < num_pontos; i++) {
-    for (int j = 0; j < num_dimensoes; j++) {
-      if (fscanf(file, "%d", &points[i].coords[j]) != 1) {
-        fprintf(stderr, "Erro: Arquivo de dados mal formatado ou incompleto.\n");
-        fclose(file);
-        exit(EXIT_FAILURE);
-      }
-    }
-  }
-
-  fclose(file);
-}
-
 /**
  * @brief Inicializa os centroides escolhendo K pontos aleatórios do dataset.
  */
-void initialize_centroids(Point* points, Point* centroids, int num_pontos, int num_clusters, int num_dimensoes) {
+void initialize_centroids(const ConjuntoPontos* points, int* centroids, int num_pontos, int num_clusters,
+                          int num_dimensoes) {
   srand(42);  // Semente fixa para reprodutibilidade
 
   int* indices = (int*)malloc(num_pontos * sizeof(int));
+  if (indices == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    exit(EXIT_FAILURE);
+  }
   for (int i = 0; i < num_pontos; i++) {
     indices[i] = i;
   }
@@ -71,7 +44,7 @@ void initialize_centroids(Point* points, Point* centroids, int num_pontos, int n
   }
 
   for (int i = 0; i < num_clusters; i++) {
-    memcpy(centroids[i].coords, points[indices[i]].coords, num_dimensoes * sizeof(int));
+    memcpy(&centroids[(size_t)i * num_dimensoes], pontos_ponto(points, indices[i]), num_dimensoes * sizeof(int));
   }
 
   free(indices);
@@ -79,21 +52,28 @@ void initialize_centroids(Point* points, Point* centroids, int num_pontos, int n
 
 /**
  * @brief Fase de Atribuição: Associa cada ponto ao cluster do centroide mais próximo.
+ * A distância até os centroides é calculada pelo kernel vetorizado de kmeans_simd.h.
+ * Com 'lista' (--incremental), os pontos que mudaram são registrados nela.
+ * @return Número de pontos que mudaram de cluster.
  */
-void assign_points_to_clusters(Point* points, Point* centroids, int num_pontos, int num_clusters, int num_dimensoes) {
+long long assign_points_to_clusters(ConjuntoPontos* points, const int* centroids, KernelAtribuicao* kernel,
+                                    const PontosCompactos* compacto, ListaMudancas* lista) {
+  kernel_carregar_centroides(kernel, centroids);
+  const int num_pontos = points->num_pontos;
+  if (points->colunas != NULL || kernel->coords_b != NULL) {
+    return incremental_atribuir_faixa(kernel, points, compacto, 0, num_pontos, lista);
+  }
+  long long mudancas = 0;
+
   for (int i = 0; i < num_pontos; i++) {
-    long long min_dist = LLONG_MAX;
-    int best_cluster = -1;
-
-    for (int j = 0; j < num_clusters; j++) {
-      long long dist = euclidean_dist_sq(&points[i], &centroids[j], num_dimensoes);
-      if (dist < min_dist) {
-        min_dist = dist;
-        best_cluster = j;
-      }
-    }
-    points[i].cluster_id = best_cluster;
+    int cluster_id = compacto->coords != NULL
+                         ? kernel_mais_proximo_compacto(kernel, &compacto->coords[(size_t)i * compacto->largura])
+                         : kernel_mais_proximo(kernel, pontos_ponto(points, i));
+    if (lista != NULL && cluster_id != points->rotulos[i]) incremental_registrar(lista, i, points->rotulos[i]);
+    mudancas += cluster_id != points->rotulos[i];
+    points->rotulos[i] = cluster_id;
   }
+  return mudancas;
 }
 /**
  * Maior problema
@@ -107,32 +87,108 @@ void assign_points_to_clusters(Point* points, Point* centroids, int num_pontos,
  */
 
 /**
- * @brief Fase de Atualização: Recalcula a posição de cada centroide como a média
- * (usando divisão inteira) de todos os pontos atribuídos ao seu cluster.
+ * @brief Fase de Atribuição com poda pela desigualdade triangular (opção --hamerly).
+ * Produz exatamente as mesmas atribuições de assign_points_to_clusters.
+ * Em 'mudancas' é somado o número de pontos que mudaram de cluster.
+ * @return Número de distâncias ponto-centroide efetivamente calculadas.
  */
-void update_centroids(Point* points, Point* centroids, int num_pontos, int num_clusters, int num_dimensoes) {
-  long long* cluster_sums = (long long*)calloc(num_clusters * num_dimensoes, sizeof(long long));
-  int* cluster_counts = (int*)calloc(num_clusters, sizeof(int));
+long long assign_points_to_clusters_hamerly(ConjuntoPontos* points, const int* centroids, KernelAtribuicao* kernel,
+                                            EstadoHamerly* hamerly, long long* mudancas, ListaMudancas* lista) {
+  kernel_carregar_centroides(kernel, centroids);
+  hamerly_preparar_iteracao(hamerly, kernel);
+
+  long long avaliacoes = 0, mudados = 0;
+  long long* distancias = (long long*)malloc(kernel->num_clusters * sizeof(long long));
+  if (distancias == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    exit(EXIT_FAILURE);
+  }
 
-  for (int i = 0; i < num_pontos; i++) {
-    int cluster_id = points[i].cluster_id;
-    cluster_counts[cluster_id]++;
-    for (int j = 0; j < num_dimensoes; j++) {
-      cluster_sums[cluster_id * num_dimensoes + j] += points[i].coords[j];
-    }
+  for (int i = 0; i < points->num_pontos; i++) {
+    int atual = hamerly->iniciado ? points->rotulos[i] : -1;
+    int cluster_id =
+        hamerly_atribuir_ponto(hamerly, kernel, i, pontos_ponto(points, i), atual, distancias, &avaliacoes);
+    if (lista != NULL && cluster_id != points->rotulos[i]) incremental_registrar(lista, i, points->rotulos[i]);
+    mudados += cluster_id != points->rotulos[i];
+    points->rotulos[i] = cluster_id;
   }
 
+  free(distancias);
+  hamerly_concluir_iteracao(hamerly);
+  *mudancas += mudados;
+  return avaliacoes;
+}
+
+/**
+ * @brief Calcula os centroides a partir das somas e contagens de cada cluster.
+ * Clusters vazios mantêm o centroide anterior.
+ * @return O maior deslocamento de um centroide, ao quadrado.
+ */
+long long finalize_centroids(int* centroids, int num_clusters, int num_dimensoes, const long long* cluster_sums,
+                             const int* cluster_counts) {
+  long long maior_desloc = 0;
   for (int i = 0; i < num_clusters; i++) {
     if (cluster_counts[i] > 0) {
+      long long desloc = 0;
       for (int j = 0; j < num_dimensoes; j++) {
         // Divisão inteira para manter os centroides em coordenadas discretas
-        centroids[i].coords[j] = cluster_sums[i * num_dimensoes + j] / cluster_counts[i];
+        int novo = cluster_sums[i * num_dimensoes + j] / cluster_counts[i];
+        long long diff = (long long)novo - centroids[i * num_dimensoes + j];
+        desloc += diff * diff;
+        centroids[i * num_dimensoes + j] = novo;
       }
+      if (desloc > maior_desloc) maior_desloc = desloc;
     }
   }
+  return maior_desloc;
+}
 
-  free(cluster_sums);
-  free(cluster_counts);
+/**
+ * @brief Fase de Atualização: Recalcula a posição de cada centroide como a média
+ * (usando divisão inteira) de todos os pontos atribuídos ao seu cluster.
+ * No modo compacto as coordenadas são lidas da cópia em int16.
+ * Com 'incremental' (--incremental), as somas são as correntes do estado e, depois da
+ * primeira iteração, só os pontos que mudaram de cluster são aplicados nelas.
+ * @return O maior deslocamento de um centroide, ao quadrado.
+ */
+long long update_centroids(const ConjuntoPontos* points, int* centroids, const PontosCompactos* compacto,
+                           int num_clusters, int num_dimensoes, EstadoIncremental* incremental) {
+  long long* cluster_sums = incremental != NULL ? incremental->somas
+                                                : (long long*)calloc(num_clusters * num_dimensoes, sizeof(long long));
+  int* cluster_counts = incremental != NULL ? incremental->contagens : (int*)calloc(num_clusters, sizeof(int));
+  if (cluster_sums == NULL || cluster_counts == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  if (incremental != NULL && incremental_pronto(incremental)) {
+    incremental_aplicar(&incremental->listas[0], points, compacto, cluster_sums, cluster_counts, num_dimensoes);
+  } else {
+    if (incremental != NULL) {
+      memset(cluster_sums, 0, (size_t)num_clusters * num_dimensoes * sizeof(long long));
+      memset(cluster_counts, 0, (size_t)num_clusters * sizeof(int));
+    }
+    for (int i = 0; i < points->num_pontos; i++) {
+      int cluster_id = points->rotulos[i];
+      cluster_counts[cluster_id]++;
+      long long* soma = &cluster_sums[cluster_id * num_dimensoes];
+      if (compacto->coords != NULL) {
+        kernel_somar_compacto(soma, &compacto->coords[(size_t)i * compacto->largura], num_dimensoes);
+      } else {
+        kernel_somar(soma, pontos_ponto(points, i), num_dimensoes);
+      }
+    }
+  }
+
+  long long maior_desloc = finalize_centroids(centroids, num_clusters, num_dimensoes, cluster_sums, cluster_counts);
+
+  if (incremental != NULL) {
+    incremental_concluir(incremental);
+  } else {
+    free(cluster_sums);
+    free(cluster_counts);
+  }
+  return maior_desloc;
 }
 /**
  * Ponto secundário
@@ -144,18 +200,208 @@ void update_centroids(Point* points, Point* centroids, int num_pontos, int num_c
  *  centroids -> pública
  */
 
+/**
+ * @brief Iteração do modo --streaming (ver kmeans_streaming.h): atribui e acumula os
+ * pontos de cada bloco lido do disco em uma única passada, enquanto a thread leitora
+ * carrega o bloco seguinte, e recalcula os centroides. O tempo parado à espera de um
+ * bloco entra no perfil como espera.
+ * Em 'mudancas' é devolvido o número de pontos que mudaram de cluster.
+ * @return O maior deslocamento de um centroide, ao quadrado.
+ */
+long long assign_and_update_streaming(LeitorStreaming* leitor, int* centroids, KernelAtribuicao* kernel,
+                                      int num_clusters, int num_dimensoes, long long* mudancas, Perfil* perfil,
+                                      int iteracao) {
+  kernel_carregar_centroides(kernel, centroids);
+  long long* cluster_sums = (long long*)calloc((size_t)num_clusters * num_dimensoes, sizeof(long long));
+  int* cluster_counts = (int*)calloc(num_clusters, sizeof(int));
+  if (cluster_sums == NULL || cluster_counts == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  long long mudados = 0;
+  for (int b = 0; b < leitor->num_blocos; b++) {
+    const BufferStreaming* bloco = streaming_proximo(leitor);
+    perfil_fase(perfil, 0, iteracao, FASE_ESPERA);
+    int32_t* rotulos = &leitor->rotulos[bloco->inicio];
+    if (bloco->compactos != NULL) {
+      const int largura = num_dimensoes + (num_dimensoes & 1);
+      if (kernel->coords_b != NULL) {
+        mudados += kernel_atribuir_blocado(kernel, bloco->compactos, 0, bloco->quantidade, rotulos);
+      }
+      for (int j = 0; j < bloco->quantidade; j++) {
+        const int16_t* ponto = &bloco->compactos[(size_t)j * largura];
+        if (kernel->coords_b == NULL) {
+          int cluster_id = kernel_mais_proximo_compacto(kernel, ponto);
+          mudados += cluster_id != rotulos[j];
+          rotulos[j] = cluster_id;
+        }
+        cluster_counts[rotulos[j]]++;
+        kernel_somar_compacto(&cluster_sums[rotulos[j] * num_dimensoes], ponto, num_dimensoes);
+      }
+    } else {
+      for (int j = 0; j < bloco->quantidade; j++) {
+        const int* ponto = &bloco->coords[(size_t)j * num_dimensoes];
+        int cluster_id = kernel_mais_proximo(kernel, ponto);
+        mudados += cluster_id != rotulos[j];
+        rotulos[j] = cluster_id;
+        cluster_counts[cluster_id]++;
+        kernel_somar(&cluster_sums[cluster_id * num_dimensoes], ponto, num_dimensoes);
+      }
+    }
+    streaming_devolver(leitor);
+    perfil_fase(perfil, 0, iteracao, FASE_ATRIBUICAO);
+  }
+  *mudancas = mudados;
+
+  long long maior_desloc = finalize_centroids(centroids, num_clusters, num_dimensoes, cluster_sums, cluster_counts);
+  free(cluster_sums);
+  free(cluster_counts);
+  perfil_fase(perfil, 0, iteracao, FASE_ATUALIZACAO);
+  return maior_desloc;
+}
+
+/**
+ * @brief Iteração do modo --kdtree (ver kmeans_kdtree.h): filtra os centroides pela
+ * árvore KD, somando subárvores inteiras pelos totais dos nós, e recalcula os centroides.
+ * Em 'mudancas' é devolvido o número de pontos que mudaram de cluster, e em
+ * 'avaliacoes' é somado o número de testes de poda e distâncias calculados.
+ * @return O maior deslocamento de um centroide, ao quadrado.
+ */
+long long assign_and_update_kdtree(ArvoreKD* arvore, int* centroids, int num_clusters, int num_dimensoes,
+                                   long long* mudancas, long long* avaliacoes, Perfil* perfil, int iteracao) {
+  kdtree_preparar(arvore, centroids);
+  for (int t = 0; t < arvore->num_tarefas; t++) {
+    kdtree_filtrar_tarefa(arvore, t, centroids, &arvore->acumuladores[0]);
+  }
+  *mudancas = kdtree_reduzir(arvore, avaliacoes);
+  perfil_fase(perfil, 0, iteracao, FASE_ATRIBUICAO);
+
+  long long maior_desloc = finalize_centroids(centroids, num_clusters, num_dimensoes, arvore->somas_clusters,
+                                              arvore->contagens_clusters);
+  perfil_fase(perfil, 0, iteracao, FASE_ATUALIZACAO);
+  return maior_desloc;
+}
+
+/**
+ * @brief Iteração do modo --execucoes (ver kmeans_execucoes.h): percorre os pontos em
+ * blocos, atribuindo e acumulando cada bloco para todas as execuções ativas enquanto
+ * ele está no cache, e recalcula os centroides de cada execução. Com --convergencia,
+ * as execuções que convergiram deixam de ser ativas.
+ * @return Número de execuções que continuam ativas.
+ */
+int assign_and_update_multiple(ExecucoesMultiplas* execucoes, const ConjuntoPontos* points,
+                               const PontosCompactos* compacto, const OpcoesKMeans* opcoes, Perfil* perfil,
+                               int iteracao) {
+  const int R = execucoes->num_execucoes, K = execucoes->num_clusters, D = execucoes->num_dimensoes;
+  execucoes_carregar(execucoes, 0);
+  memset(execucoes->somas, 0, (size_t)R * K * D * sizeof(long long));
+  memset(execucoes->contagens, 0, (size_t)R * K * sizeof(int));
+  memset(execucoes->mudancas, 0, R * sizeof(long long));
+  for (int inicio = 0; inicio < points->num_pontos; inicio += EXECUCOES_BLOCO) {
+    const int fim = inicio + EXECUCOES_BLOCO < points->num_pontos ? inicio + EXECUCOES_BLOCO : points->num_pontos;
+    execucoes_bloco(execucoes, points, compacto, inicio, fim, execucoes->somas, execucoes->contagens,
+                    execucoes->mudancas);
+  }
+  perfil_fase(perfil, 0, iteracao, FASE_ATRIBUICAO);
+
+  int ativas = 0;
+  for (int r = 0; r < R; r++) {
+    if (!execucoes->ativa[r]) continue;
+    long long maior_desloc = finalize_centroids(execucoes_centroides(execucoes, r), K, D,
+                                                &execucoes->somas[(size_t)r * K * D], &execucoes->contagens[r * K]);
+    execucoes->iteracoes[r]++;
+    if (opcoes->convergencia && opcoes_convergiu(opcoes, execucoes->mudancas[r], maior_desloc)) {
+      execucoes->ativa[r] = 0;
+    }
+    ativas += execucoes->ativa[r];
+  }
+  perfil_fase(perfil, 0, iteracao, FASE_ATUALIZACAO);
+  return ativas;
+}
+
+/**
+ * @brief Passo do K-Means por mini-lotes (opção --minibatch, ver kmeans_minibatch.h):
+ * atribui os pontos sorteados e move os centroides em direção à média do lote.
+ */
+void minibatch_step(const ConjuntoPontos* points, int* centroids, KernelAtribuicao* kernel, EstadoMiniLote* lote,
+                    int passo, Perfil* perfil) {
+  const int D = lote->num_dimensoes;
+  const int tamanho = lote->num_clusters * (D + 1);
+  long long* acumulado = lote->lote;
+  kernel_carregar_centroides(kernel, centroids);
+  minilote_amostrar(lote, passo, 0, 0, points->num_pontos, lote->tamanho_lote);
+  memset(acumulado, 0, tamanho * sizeof(long long));
+
+  for (int j = 0; j < lote->tamanho_lote; j++) {
+    const int* ponto = pontos_ponto(points, lote->indices[j]);
+    long long* linha = &acumulado[kernel_mais_proximo(kernel, ponto) * (D + 1)];
+    for (int d = 0; d < D; d++) {
+      linha[d] += ponto[d];
+    }
+    linha[D]++;
+  }
+  perfil_fase(perfil, 0, passo, FASE_ATRIBUICAO);
+
+  minilote_aplicar(lote, centroids);
+  perfil_fase(perfil, 0, passo, FASE_ATUALIZACAO);
+}
+
+/**
+ * @brief Inércia: soma das distâncias ao quadrado de cada ponto ao centroide mais próximo.
+ * Usada para comparar a qualidade do mini-lote com a do Lloyd completo.
+ */
+double compute_inertia(const ConjuntoPontos* points, const int* centroids, KernelAtribuicao* kernel) {
+  kernel_carregar_centroides(kernel, centroids);
+  double inercia = 0.0;
+  for (int i = 0; i < points->num_pontos; i++) {
+    const int* ponto = pontos_ponto(points, i);
+    inercia += (double)kernel_distancia(kernel, ponto, kernel_mais_proximo(kernel, ponto));
+  }
+  return inercia;
+}
+
+/**
+ * @brief Inércia de cada execução do modo --execucoes, em uma única passada em blocos.
+ */
+void compute_inertia_multiple(ExecucoesMultiplas* execucoes, const ConjuntoPontos* points) {
+  execucoes_carregar(execucoes, 1);
+  memset(execucoes->inercias, 0, execucoes->num_execucoes * sizeof(long long));
+  for (int inicio = 0; inicio < points->num_pontos; inicio += EXECUCOES_BLOCO) {
+    const int fim = inicio + EXECUCOES_BLOCO < points->num_pontos ? inicio + EXECUCOES_BLOCO : points->num_pontos;
+    execucoes_inercia_bloco(execucoes, points, inicio, fim, execucoes->inercias);
+  }
+}
+
+/**
+ * @brief Inércia no modo --streaming: uma passada extra sobre os blocos do disco.
+ */
+double compute_inertia_streaming(LeitorStreaming* leitor, const int* centroids, KernelAtribuicao* kernel) {
+  kernel_carregar_centroides(kernel, centroids);
+  double inercia = 0.0;
+  for (int b = 0; b < leitor->num_blocos; b++) {
+    const BufferStreaming* bloco = streaming_proximo(leitor);
+    for (int j = 0; j < bloco->quantidade; j++) {
+      const int* ponto = &bloco->coords[(size_t)j * leitor->num_dimensoes];
+      inercia += (double)kernel_distancia(kernel, ponto, kernel_mais_proximo(kernel, ponto));
+    }
+    streaming_devolver(leitor);
+  }
+  return inercia;
+}
+
 /**
  * @brief Imprime os resultados finais e o checksum (como long long).
  */
-void print_results(Point* centroids, int num_clusters, int num_dimensoes) {
+void print_results(const int* centroids, int num_clusters, int num_dimensoes) {
   printf("--- Centroides Finais ---\n");
   long long checksum = 0;
   for (int i = 0; i < num_clusters; i++) {
     printf("Centroide %d: [", i);
     for (int j = 0; j < num_dimensoes; j++) {
-      printf("%d", centroids[i].coords[j]);
+      printf("%d", centroids[i * num_dimensoes + j]);
       if (j < num_dimensoes - 1) printf(", ");
-      checksum += centroids[i].coords[j];
+      checksum += centroids[i * num_dimensoes + j];
     }
     printf("]\n");
   }
@@ -169,11 +415,11 @@ void print_results(Point* centroids, int num_clusters, int num_dimensoes) {
  * Linha 1: Tempo de execução em segundos (double)
  * Linha 2: Checksum final (long long)
  */
-void print_time_and_checksum(Point* centroids, int num_clusters, int num_dimensoes, double exec_time) {
+void print_time_and_checksum(const int* centroids, int num_clusters, int num_dimensoes, double exec_time) {
   long long checksum = 0;
   for (int i = 0; i < num_clusters; i++) {
     for (int j = 0; j < num_dimensoes; j++) {
-      checksum += centroids[i].coords[j];
+      checksum += centroids[i * num_dimensoes + j];
     }
   }
   // Saída formatada para o avaliador
@@ -185,8 +431,8 @@ void print_time_and_checksum(Point* centroids, int num_clusters, int num_dimenso
 
 int main(int argc, char* argv[]) {
   // Validação e leitura dos argumentos de linha de comando
-  if (argc != 6) {
-    fprintf(stderr, "Uso: %s <arquivo_dados> <num_pontos> <num_dimensoes> <num_clusters> <num_iteracoes>\n", argv[0]);
+  if (argc < 6) {
+    fprintf(stderr, "Uso: %s <arquivo_dados> <num_pontos> <num_dimensoes> <num_clusters> <num_iteracoes> [opcoes]\n", argv[0]);
     return EXIT_FAILURE;
   }
 
@@ -196,6 +442,9 @@ int main(int argc, char* argv[]) {
   const int num_clusters = atoi(argv[4]);
   const int num_iteracoes = atoi(argv[5]);
 
+  OpcoesKMeans opcoes;
+  opcoes_ler(argc, argv, 6, &opcoes);
+
   if (num_pontos <= 0 || num_dimensoes <= 0 || num_clusters <= 0 || num_iteracoes <= 0 || num_clusters > num_pontos) {
     fprintf(stderr, "Erro nos parâmetros. Verifique se Numero de pontos, Numero de dimensoes, Numero de clusters,\
                         Numero de Iteracoes > 0 e Numero de clusters <= Numero de pontos.\n");
@@ -203,29 +452,160 @@ int main(int argc, char* argv[]) {
   }
 
   // --- Alocação de Memória ---
-  int* all_coords = (int*)malloc((num_pontos + num_clusters) * num_dimensoes * sizeof(int));
-  Point* points = (Point*)malloc(num_pontos * sizeof(Point));
-  Point* centroids = (Point*)malloc(num_clusters * sizeof(Point));
-  // ... (verificação de alocação) ...
-  for (int i = 0; i < num_pontos; i++) {
-    points[i].coords = &all_coords[i * num_dimensoes];
+  // Um dataset binário é mapeado direto do arquivo; um de texto é lido para uma matriz alocada.
+  // A faixa de valores vem do cabeçalho binário ou é calculada durante a leitura do texto.
+  // Com --streaming nada é carregado: os pontos são lidos do disco em blocos a cada passada.
+  ConjuntoPontos points = {0};
+  DatasetBinario binario;
+  LeitorStreaming leitor;
+  int min_val, max_val;
+  int eh_binario = 0;
+  if (opcoes.streaming > 0) {
+    streaming_abrir(&leitor, filename, num_pontos, num_dimensoes, opcoes.streaming);
+    min_val = leitor.min_val;
+    max_val = leitor.max_val;
+  } else {
+    eh_binario = pontos_carregar(filename, num_pontos, num_dimensoes, 0, &points, &binario, &min_val, &max_val);
   }
-  for (int i = 0; i < num_clusters; i++) {
-    centroids[i].coords = &all_coords[(num_pontos + i) * num_dimensoes];
+  int* centroids = (int*)malloc((size_t)num_clusters * num_dimensoes * sizeof(int));
+  if (centroids == NULL) {
+    fprintf(stderr, "Erro: falha de alocação de memória.\n");
+    return EXIT_FAILURE;
   }
 
   // --- Preparação (Fora da medição de tempo) ---
-  read_data_from_file(filename, points, num_pontos, num_dimensoes);
-  initialize_centroids(points, centroids, num_pontos, num_clusters, num_dimensoes);
+  NivelSimd nivel = simd_faixa_segura(min_val, max_val) ? simd_escolher(opcoes.simd) : SIMD_ESCALAR;
+  ExecucoesMultiplas execucoes;
+  if (opcoes.streaming > 0) {
+    streaming_inicializar_centroides(&leitor, centroids, num_clusters);
+  } else if (opcoes.execucoes > 0) {
+    // A execução r sorteia com a semente 42 + r, ou usa k-means|| com --semente + r
+    execucoes_iniciar(&execucoes, opcoes.execucoes, num_pontos, num_clusters, num_dimensoes);
+    const int kmpar = opcoes.inicializacao_paralela && kmpar_faixa_segura(num_pontos, num_dimensoes, min_val, max_val);
+    if (opcoes.inicializacao_paralela && !kmpar) {
+      fprintf(stderr, "Aviso: faixa de valores grande demais para k-means||, usando a inicialização aleatória.\n");
+    }
+    for (int r = 0; r < opcoes.execucoes; r++) {
+      if (kmpar) {
+        kmpar_inicializar(points.coords, num_pontos, num_dimensoes, num_clusters, opcoes.semente + r, nivel,
+                          execucoes_centroides(&execucoes, r));
+      } else {
+        execucoes_sortear_centroides(&execucoes, r, &points, 42 + r);
+      }
+    }
+  } else if (opcoes.inicializacao_paralela && kmpar_faixa_segura(num_pontos, num_dimensoes, min_val, max_val)) {
+    int candidatos = kmpar_inicializar(points.coords, num_pontos, num_dimensoes, num_clusters, opcoes.semente, nivel,
+                                       centroids);
+    fprintf(stderr, "Inicialização k-means||: %d candidatos\n", candidatos);
+  } else {
+    if (opcoes.inicializacao_paralela) {
+      fprintf(stderr, "Aviso: faixa de valores grande demais para k-means||, usando a inicialização aleatória.\n");
+    }
+    initialize_centroids(&points, centroids, num_pontos, num_clusters, num_dimensoes);
+  }
+  KernelAtribuicao kernel;
+  kernel_iniciar(&kernel, nivel, num_clusters, num_dimensoes);
+  EstadoHamerly hamerly;
+  long long avaliacoes = 0;
+  if (opcoes.hamerly) {
+    hamerly_iniciar(&hamerly, num_pontos, num_clusters, num_dimensoes, min_val, max_val);
+  }
+  ArvoreKD arvore;
+  if (opcoes.kdtree && !kdtree_faixa_segura(num_dimensoes, min_val, max_val)) {
+    fprintf(stderr, "Aviso: faixa de valores grande demais para --kdtree, usando a atribuição normal.\n");
+    opcoes.kdtree = 0;
+  }
+  if (opcoes.kdtree) {
+    kdtree_construir(&arvore, points.coords, num_pontos, num_dimensoes, num_clusters, 1);
+    fprintf(stderr, "Árvore KD: %d nós, folhas de até %d pontos\n", arvore.num_nos, KDTREE_FOLHA);
+  }
+  EstadoMiniLote minilote;
+  if (opcoes.minibatch > 0) {
+    minilote_iniciar(&minilote, opcoes.minibatch, num_clusters, num_dimensoes, centroids);
+  }
+  EstadoIncremental incremental;
+  if (opcoes.incremental) {
+    incremental_iniciar(&incremental, num_pontos, num_clusters, num_dimensoes, 1);
+  }
+  EstadoIncremental* estado_incremental = opcoes.incremental ? &incremental : NULL;
+  PontosCompactos compacto = {NULL, 0};
+  int usar_compacto = 0;  // No modo --streaming a conversão é feita bloco a bloco pela leitora
+  if (opcoes.colunas && !opcoes.hamerly && !opcoes.kdtree && opcoes.minibatch == 0 && opcoes.streaming == 0 &&
+      opcoes.execucoes == 0) {
+    pontos_gerar_colunas(&points);
+  } else if (!opcoes.hamerly && !opcoes.kdtree && opcoes.minibatch == 0 &&
+             simd_escolher_armazenamento(opcoes.armazenamento, min_val, max_val, num_dimensoes)) {
+    if (opcoes.streaming == 0) simd_compactar(points.coords, num_pontos, num_dimensoes, min_val, max_val, &compacto);
+    kernel_habilitar_compacto(&kernel);
+    usar_compacto = 1;
+  }
+  if (simd_escolher_atribuicao(opcoes.atribuicao, num_clusters, usar_compacto, min_val, max_val,
+                               num_dimensoes)) {
+    kernel_habilitar_blocado(&kernel, min_val, max_val);
+  }
+  if (opcoes.streaming > 0) {
+    streaming_iniciar(&leitor, usar_compacto);
+  }
+  if (opcoes.execucoes > 0) {
+    execucoes_replicar(&execucoes, &kernel);
+  }
+  fprintf(stderr, "Kernel de atribuição: %s (D=%d %s), pontos: %s\n", simd_nome(nivel), num_dimensoes,
+          kernel_caminho(&kernel),
+          usar_compacto ? "int16" : simd_descrever_pontos(&compacto, points.colunas != NULL));
+  Perfil perfil;
+  perfil_iniciar(&perfil, opcoes.perfil, 1, num_iteracoes);
+  perfil_abrir_contadores(&perfil, 0);
+  if (opcoes.streaming > 0) {
+    fprintf(stderr, "Streaming: %d blocos de até %d pontos (%.1f MiB por buffer)\n", leitor.num_blocos,
+            leitor.pontos_por_bloco, (double)leitor.pontos_por_bloco * num_dimensoes * sizeof(int) / (1 << 20));
+  }
 
   // --- Medição de Tempo do Algoritmo Principal ---
   struct timespec start, end;
   clock_gettime(CLOCK_MONOTONIC, &start);  // Inicia o cronômetro
 
   // Laço principal do K-Means (A única parte que será medida)
-  for (int iter = 0; iter < num_iteracoes; iter++) {
-    assign_points_to_clusters(points, centroids, num_pontos, num_clusters, num_dimensoes);
-    update_centroids(points, centroids, num_pontos, num_clusters, num_dimensoes);
+  int iteracoes = 0;
+  while (iteracoes < num_iteracoes) {
+    perfil_marcar(&perfil, 0);
+    if (opcoes.minibatch > 0) {
+      minibatch_step(&points, centroids, &kernel, &minilote, iteracoes++, &perfil);
+      continue;
+    }
+    long long mudancas = 0;
+    if (opcoes.streaming > 0) {
+      long long maior_desloc = assign_and_update_streaming(&leitor, centroids, &kernel, num_clusters, num_dimensoes,
+                                                           &mudancas, &perfil, iteracoes);
+      iteracoes++;
+      if (opcoes.convergencia && opcoes_convergiu(&opcoes, mudancas, maior_desloc)) break;
+      continue;
+    }
+    if (opcoes.execucoes > 0) {
+      int ativas = assign_and_update_multiple(&execucoes, &points, &compacto, &opcoes, &perfil, iteracoes);
+      iteracoes++;
+      if (ativas == 0) break;
+      continue;
+    }
+    if (opcoes.kdtree) {
+      long long maior_desloc = assign_and_update_kdtree(&arvore, centroids, num_clusters, num_dimensoes, &mudancas,
+                                                        &avaliacoes, &perfil, iteracoes);
+      iteracoes++;
+      if (opcoes.convergencia && opcoes_convergiu(&opcoes, mudancas, maior_desloc)) break;
+      continue;
+    }
+    if (opcoes.hamerly) {
+      avaliacoes += assign_points_to_clusters_hamerly(&points, centroids, &kernel, &hamerly, &mudancas,
+                                                      incremental_lista(estado_incremental, 0));
+    } else {
+      mudancas = assign_points_to_clusters(&points, centroids, &kernel, &compacto,
+                                           incremental_lista(estado_incremental, 0));
+    }
+    perfil_fase(&perfil, 0, iteracoes, FASE_ATRIBUICAO);
+    long long maior_desloc =
+        update_centroids(&points, centroids, &compacto, num_clusters, num_dimensoes, estado_incremental);
+    perfil_fase(&perfil, 0, iteracoes, FASE_ATUALIZACAO);
+    iteracoes++;
+    if (opcoes.convergencia && opcoes_convergiu(&opcoes, mudancas, maior_desloc)) break;
   }
 
   clock_gettime(CLOCK_MONOTONIC, &end);  // Para o cronômetro
@@ -234,11 +614,82 @@ int main(int argc, char* argv[]) {
   double time_taken = (end.tv_sec - start.tv_sec) + 1e-9 * (end.tv_nsec - start.tv_nsec);
 
   // --- Apresentação dos Resultados ---
+  // Com --execucoes, a execução de menor inércia fornece o checksum (e o modelo)
+  if (opcoes.execucoes > 0) {
+    compute_inertia_multiple(&execucoes, &points);
+    const int melhor = execucoes_melhor(&execucoes);
+    execucoes_relatar(&execucoes, melhor);
+    memcpy(centroids, execucoes_centroides(&execucoes, melhor), (size_t)num_clusters * num_dimensoes * sizeof(int));
+  }
   print_time_and_checksum(centroids, num_clusters, num_dimensoes, time_taken);
+  if (opcoes.hamerly) {
+    fprintf(stderr, "Hamerly: %lld de %lld distâncias calculadas (%.1f%%)\n", avaliacoes,
+            (long long)num_pontos * num_clusters * iteracoes,
+            100.0 * avaliacoes / ((double)num_pontos * num_clusters * iteracoes));
+  }
+  if (opcoes.kdtree) {
+    fprintf(stderr, "Árvore KD: %lld testes de poda e distâncias para %lld distâncias do Lloyd (%.1f%%)\n",
+            avaliacoes, (long long)num_pontos * num_clusters * iteracoes,
+            100.0 * avaliacoes / ((double)num_pontos * num_clusters * iteracoes));
+  }
+  if (opcoes.convergencia) {
+    fprintf(stderr, "Iterações executadas: %d de %d\n", iteracoes, num_iteracoes);
+  }
+  if (opcoes.minibatch > 0 || opcoes.inercia) {
+    fprintf(stderr, "Inércia final: %.6e\n", opcoes.streaming > 0
+                                                  ? compute_inertia_streaming(&leitor, centroids, &kernel)
+                                                  : compute_inertia(&points, centroids, &kernel));
+  }
+  perfil_escrever(&perfil, "sequencial", "threads", num_pontos, num_dimensoes, num_clusters, iteracoes, time_taken);
+  if (opcoes.modelo != NULL) {
+    // Com --estatisticas, uma passada extra atribui os pontos aos centroides finais
+    ModeloKMeans modelo;
+    modelo_iniciar(&modelo, centroids, num_clusters, num_dimensoes, min_val, max_val, num_pontos, iteracoes,
+                   opcoes.estatisticas);
+    if (opcoes.estatisticas) {
+      kernel_carregar_centroides(&kernel, centroids);
+      if (opcoes.streaming > 0) {
+        for (int b = 0; b < leitor.num_blocos; b++) {
+          const BufferStreaming* bloco = streaming_proximo(&leitor);
+          modelo_acumular_estatisticas(&modelo, &kernel, bloco->coords, bloco->quantidade);
+          streaming_devolver(&leitor);
+        }
+      } else {
+        modelo_acumular_estatisticas(&modelo, &kernel, points.coords, num_pontos);
+      }
+    }
+    if (modelo_salvar(&modelo, opcoes.modelo) == 0) {
+      fprintf(stderr, "Modelo gravado em '%s'\n", opcoes.modelo);
+    }
+    modelo_liberar(&modelo);
+  }
 
   // --- Limpeza ---
-  free(all_coords);
-  free(points);
+  perfil_liberar(&perfil);
+  if (opcoes.minibatch > 0) {
+    minilote_liberar(&minilote);
+  }
+  if (opcoes.hamerly) {
+    hamerly_liberar(&hamerly);
+  }
+  if (opcoes.kdtree) {
+    kdtree_liberar(&arvore);
+  }
+  if (opcoes.execucoes > 0) {
+    execucoes_liberar(&execucoes);
+  }
+  if (opcoes.incremental) {
+    incremental_liberar(&incremental);
+  }
+  kernel_liberar(&kernel);
+  free(compacto.coords);
+  pontos_liberar(&points);
+  if (eh_binario) {
+    dataset_binario_fechar(&binario);
+  }
+  if (opcoes.streaming > 0) {
+    streaming_fechar(&leitor);
+  }
   free(centroids);
 
   return EXIT_SUCCESS;
@@ -0,0 +1,1140 @@
+#ifndef KMEANS_SIMD_H
+#define KMEANS_SIMD_H
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define KMEANS_SIMD_X86 1
+#endif
+
+// Kernel vetorizado da fase de atribuição.
+//
+// Os centroides são copiados a cada iteração para um layout transposto
+// (dimensão-major, [d * k_pad + k]), de modo que um único registrador carrega a
+// mesma coordenada de 8 (AVX2) ou 16 (AVX-512) centroides. A diferença é feita
+// em 32 bits e o quadrado acumulado em 64 bits com _mm*_mul_epi32, então a
+// distância é exatamente a mesma do cálculo escalar em long long e o checksum não muda.
+// A diferença só cabe em 32 bits se (max - min) dos dados couber em um int;
+// caso contrário o kernel escalar é usado.
+//
+// Modo compacto (--armazenamento=int16): quando os dados cabem em int16 e
+// D * (max - min)² cabe em int32, os pontos são copiados para int16 (metade dos
+// bytes por ponto nas varreduras de atribuição e atualização). Os centroides
+// ficam em pares de dimensões [(d / 2) * k_pad + k] de 32 bits, e cada
+// _mm*_madd_epi16 soma o quadrado de duas diferenças direto em 32 bits. A
+// distância continua exata, então o checksum é o mesmo.
+//
+// Layout em colunas (--layout=colunas): com os pontos em dimensão-major
+// ([d * num_pontos + i], ver ConjuntoPontos), kernel_atribuir_colunas vetoriza
+// sobre os pontos em vez dos centroides: cada registrador leva a mesma coordenada
+// de 4 (AVX2) ou 8 (AVX-512) pontos estendida para 64 bits, e os centroides são
+// percorridos em ordem com '<' estrito. Não há faixas desperdiçadas quando K é
+// menor que a largura do registrador.
+//
+// Atribuição blocada (--atribuicao, para K grande): sobre os pontos compactos, a
+// distância é escrita como ||x||² - 2 x·c + ||c||². ||x||² é o mesmo para todos os
+// centroides e não muda o argmin, então só ||c||² - 2 x·c é comparado, com ||c||²
+// calculado uma vez por iteração em kernel_carregar_faixa. Pontos e centroides são
+// ladrilhados: um bloco de centroides que cabe no L1 é reutilizado por todos os
+// pontos de um bloco, e cada carga de centroides serve a KERNEL_BLOCADO_GRUPO pontos
+// de uma vez. As coordenadas são centradas no meio da faixa dos dados, o que mantém
+// x·c e ||c||² exatos em 32 bits (kernel_blocado_seguro); como a diferença para a
+// distância é constante por ponto, o argmin e os empates são os mesmos da
+// atribuição direta.
+
+typedef enum { SIMD_ESCALAR = 0, SIMD_AVX2 = 1, SIMD_AVX512 = 2 } NivelSimd;
+
+#define SIMD_LARGURA_MAX 16  // Maior bloco de centroides processado de uma vez (AVX-512)
+
+#define KERNEL_BLOCADO_GRUPO 4        // Pontos que compartilham cada carga de centroides
+#define KERNEL_BLOCADO_PONTOS 64      // Pontos por bloco (múltiplo de KERNEL_BLOCADO_GRUPO)
+#define KERNEL_BLOCADO_BYTES 16384    // Bytes de centroides e normas por bloco de centroides
+#define KERNEL_BLOCADO_PARES_MAX 64   // Maior número de pares de dimensões (D <= 128)
+#define KERNEL_BLOCADO_MIN_K 32       // --atribuicao=auto usa o modo blocado a partir deste K
+
+typedef struct KernelAtribuicao {
+  NivelSimd nivel;
+  int num_clusters;
+  int num_dimensoes;
+  int k_pad;       // num_clusters arredondado para múltiplo de SIMD_LARGURA_MAX
+  int* coords;     // Centroides linha-a-linha [k * D + d], usado pelo caminho escalar
+  int* coords_t;   // Centroides transpostos [d * k_pad + k], alinhado em 64 bytes
+  int d_par;       // num_dimensoes arredondado para par (largura de um ponto compacto)
+  int16_t* coords_t16;  // Modo compacto: pares de dimensões transpostos [((d / 2) * k_pad + k) * 2 + d % 2]
+  int avx512bw;    // AVX-512BW disponível para o kernel compacto de 512 bits
+  int avx512vnni;  // AVX-512 VNNI disponível para o kernel blocado de 512 bits
+  int16_t* coords_b;  // Modo blocado: mesmo layout de coords_t16, coordenadas menos 'centro'
+  int32_t* normas;    // Modo blocado: ||c||² dos centroides centrados (INT32_MAX no preenchimento)
+  int centro;         // Modo blocado: meio da faixa de valores dos dados
+  int bloco_centroides;  // Modo blocado: centroides por bloco (múltiplo de SIMD_LARGURA_MAX)
+  int d_fixo;      // 1 se há kernel especializado para num_dimensoes (KERNEL_D_FIXOS)
+  int (*mais_proximo)(const struct KernelAtribuicao*, const int*);
+  int (*mais_proximo_compacto)(const struct KernelAtribuicao*, const int16_t*);
+  long long (*atribuir_colunas)(const struct KernelAtribuicao*, const int*, int, int, int, int32_t*);
+  long long (*atribuir_blocado)(const struct KernelAtribuicao*, const int16_t*, int, int, int32_t*);
+} KernelAtribuicao;
+
+// Pontos copiados para int16 no modo compacto, com largura d_par (dimensão extra zerada).
+typedef struct {
+  int16_t* coords;  // NULL quando os pontos ficam em int
+  int largura;
+} PontosCompactos;
+
+static const char* simd_nome(NivelSimd nivel) {
+  switch (nivel) {
+    case SIMD_AVX512: return "avx512";
+    case SIMD_AVX2: return "avx2";
+    default: return "escalar";
+  }
+}
+
+/**
+ * @brief Detecta em tempo de execução o conjunto de instruções mais largo suportado.
+ */
+static inline NivelSimd simd_detectar(void) {
+#ifdef KMEANS_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return SIMD_AVX512;
+  if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+#endif
+  return SIMD_ESCALAR;
+}
+
+/**
+ * @brief Converte o valor de --simd no nível a ser usado, limitado ao que a CPU suporta.
+ */
+static inline NivelSimd simd_escolher(const char* pedido) {
+  NivelSimd suportado = simd_detectar();
+  NivelSimd nivel;
+  if (strcmp(pedido, "auto") == 0) return suportado;
+  else if (strcmp(pedido, "escalar") == 0) nivel = SIMD_ESCALAR;
+  else if (strcmp(pedido, "avx2") == 0) nivel = SIMD_AVX2;
+  else if (strcmp(pedido, "avx512") == 0) nivel = SIMD_AVX512;
+  else {
+    fprintf(stderr, "Erro: valor inválido para --simd: '%s' (use auto, escalar, avx2 ou avx512)\n", pedido);
+    exit(EXIT_FAILURE);
+  }
+  return nivel < suportado ? nivel : suportado;
+}
+
+/**
+ * @brief Calcula o menor e o maior valor de um vetor de coordenadas.
+ */
+static inline void simd_faixa(const int* coords, size_t n, int* min_val, int* max_val) {
+  int mn = INT_MAX, mx = INT_MIN;
+  for (size_t i = 0; i < n; i++) {
+    if (coords[i] < mn) mn = coords[i];
+    if (coords[i] > mx) mx = coords[i];
+  }
+  *min_val = mn;
+  *max_val = mx;
+}
+
+/**
+ * @brief Indica se a diferença entre quaisquer duas coordenadas em [min_val, max_val]
+ * cabe em 32 bits. Os centroides são médias dos pontos, então ficam na mesma faixa.
+ */
+static inline int simd_faixa_segura(int min_val, int max_val) {
+  return (long long)max_val - min_val <= INT_MAX;
+}
+
+/**
+ * @brief Indica se os dados em [min_val, max_val] podem usar o modo compacto: as
+ * coordenadas e suas diferenças cabem em int16, e a distância inteira cabe em int32.
+ */
+static inline int simd_compacto_seguro(int min_val, int max_val, int num_dimensoes) {
+  long long faixa = (long long)max_val - min_val;
+  long long d_par = num_dimensoes + (num_dimensoes & 1);
+  return min_val >= INT16_MIN && max_val <= INT16_MAX && faixa <= INT16_MAX && d_par * faixa * faixa <= INT32_MAX;
+}
+
+/**
+ * @brief Converte o valor de --armazenamento na decisão de usar o modo compacto.
+ * 'auto' usa int16 sempre que simd_compacto_seguro permitir.
+ */
+static inline int simd_escolher_armazenamento(const char* pedido, int min_val, int max_val, int num_dimensoes) {
+  int seguro = simd_compacto_seguro(min_val, max_val, num_dimensoes);
+  if (strcmp(pedido, "int32") == 0) return 0;
+  if (strcmp(pedido, "auto") == 0) return seguro;
+  if (strcmp(pedido, "int16") == 0) {
+    if (!seguro) {
+      fprintf(stderr, "Aviso: a faixa de valores não cabe no modo int16, usando int32.\n");
+    }
+    return seguro;
+  }
+  fprintf(stderr, "Erro: valor inválido para --armazenamento: '%s' (use auto, int32 ou int16)\n", pedido);
+  exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief Converte 'num_pontos' pontos para int16 com largura d_par em 'destino', que
+ * precisa de num_pontos * d_par posições.
+ * @return 1 se todos os valores estão em [min_val, max_val], 0 caso contrário.
+ */
+static inline int simd_converter_compacto(const int* coords, int num_pontos, int num_dimensoes, int min_val,
+                                          int max_val, int16_t* destino) {
+  const int largura = num_dimensoes + (num_dimensoes & 1);
+  int fora = 0;
+  for (int i = 0; i < num_pontos; i++) {
+    int16_t* p = &destino[(size_t)i * largura];
+    for (int d = 0; d < num_dimensoes; d++) {
+      const int v = coords[(size_t)i * num_dimensoes + d];
+      fora |= (v < min_val) | (v > max_val);
+      p[d] = (int16_t)v;
+    }
+    if (largura > num_dimensoes) p[num_dimensoes] = 0;
+  }
+  return !fora;
+}
+
+/**
+ * @brief Copia 'num_pontos' pontos para int16 com largura d_par (modo compacto). A faixa
+ * [min_val, max_val] que escolheu o modo (a do cabeçalho, num dataset binário) é
+ * conferida na mesma passada, e um valor fora dela encerra o programa.
+ */
+static inline void simd_compactar(const int* coords, int num_pontos, int num_dimensoes, int min_val, int max_val,
+                                  PontosCompactos* saida) {
+  const int largura = num_dimensoes + (num_dimensoes & 1);
+  size_t bytes = (size_t)num_pontos * largura * sizeof(int16_t);
+  saida->largura = largura;
+  saida->coords = (int16_t*)aligned_alloc(64, (bytes + 63) / 64 * 64);
+  if (saida->coords == NULL) {
+    fprintf(stderr, "Erro: falha ao alocar os pontos compactos.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (!simd_converter_compacto(coords, num_pontos, num_dimensoes, min_val, max_val, saida->coords)) {
+    fprintf(stderr, "Erro: os pontos têm valores fora da faixa [%d, %d] declarada no cabeçalho do dataset.\n", min_val,
+            max_val);
+    exit(EXIT_FAILURE);
+  }
+}
+
+/**
+ * @brief Indica se a atribuição blocada é exata para a faixa de valores: com h a maior
+ * distância de um valor ao meio da faixa, ||c||² - 2 x·c fica em [-2 D h², 3 D h²], e
+ * esse intervalo precisa caber em int32 abaixo de INT32_MAX (valor do preenchimento).
+ */
+static inline int kernel_blocado_seguro(int min_val, int max_val, int num_dimensoes) {
+  long long centro = ((long long)min_val + max_val) / 2;
+  long long h = centro - min_val > max_val - centro ? centro - min_val : max_val - centro;
+  long long d_par = num_dimensoes + (num_dimensoes & 1);
+  return d_par <= 2 * KERNEL_BLOCADO_PARES_MAX && h <= INT16_MAX && 3 * d_par * h * h < INT32_MAX;
+}
+
+/**
+ * @brief Decide se a atribuição do Lloyd usa o modo blocado (opção --atribuicao):
+ * "direta" nunca, "blocada" sempre que possível e "auto" a partir de
+ * KERNEL_BLOCADO_MIN_K centroides. O modo blocado lê os pontos compactos, então
+ * 'compacto' indica se eles foram gerados.
+ */
+static inline int simd_escolher_atribuicao(const char* pedido, int num_clusters, int compacto, int min_val,
+                                           int max_val, int num_dimensoes) {
+  int possivel = compacto && kernel_blocado_seguro(min_val, max_val, num_dimensoes);
+  if (strcmp(pedido, "direta") == 0) return 0;
+  if (strcmp(pedido, "auto") == 0) return possivel && num_clusters >= KERNEL_BLOCADO_MIN_K;
+  if (strcmp(pedido, "blocada") == 0) {
+    if (!possivel) {
+      fprintf(stderr, "Aviso: atribuição blocada indisponível (requer pontos int16 e faixa de valores menor), "
+                      "usando a atribuição direta.\n");
+    }
+    return possivel;
+  }
+  fprintf(stderr, "Erro: valor inválido para --atribuicao: '%s' (use auto, direta ou blocada)\n", pedido);
+  exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief Descrição dos pontos usados na atribuição, para a saída.
+ */
+static inline const char* simd_descrever_pontos(const PontosCompactos* compacto, int colunas) {
+  if (compacto->coords != NULL) return "int16";
+  return colunas ? "int32 em colunas" : "int32";
+}
+
+static inline void kernel_escolher_caminho(KernelAtribuicao* k);
+
+static inline void kernel_iniciar(KernelAtribuicao* k, NivelSimd nivel, int num_clusters, int num_dimensoes) {
+  k->nivel = nivel;
+  k->num_clusters = num_clusters;
+  k->num_dimensoes = num_dimensoes;
+  k->d_par = num_dimensoes + (num_dimensoes & 1);
+  k->coords_t16 = NULL;
+  k->coords_b = NULL;
+  k->normas = NULL;
+  k->centro = 0;
+  k->bloco_centroides = 0;
+  k->avx512bw = 0;
+  k->avx512vnni = 0;
+  k->k_pad = (num_clusters + SIMD_LARGURA_MAX - 1) / SIMD_LARGURA_MAX * SIMD_LARGURA_MAX;
+  k->coords = (int*)malloc((size_t)num_clusters * num_dimensoes * sizeof(int));
+  size_t bytes_t = (size_t)k->k_pad * num_dimensoes * sizeof(int);
+  k->coords_t = (int*)aligned_alloc(64, (bytes_t + 63) / 64 * 64);
+  if (k->coords == NULL || k->coords_t == NULL) {
+    fprintf(stderr, "Erro: falha ao alocar o kernel de atribuição.\n");
+    exit(EXIT_FAILURE);
+  }
+  // As posições de preenchimento nunca são lidas como resultado, mas ficam zeradas
+  memset(k->coords_t, 0, bytes_t);
+  kernel_escolher_caminho(k);
+}
+
+/**
+ * @brief Aloca o layout de centroides do modo compacto. Só pode ser usado quando
+ * simd_compacto_seguro é verdadeiro para os dados.
+ */
+static inline void kernel_habilitar_compacto(KernelAtribuicao* k) {
+  size_t bytes = (size_t)k->k_pad * k->d_par * sizeof(int16_t);
+  k->coords_t16 = (int16_t*)aligned_alloc(64, (bytes + 63) / 64 * 64);
+  if (k->coords_t16 == NULL) {
+    fprintf(stderr, "Erro: falha ao alocar o kernel de atribuição.\n");
+    exit(EXIT_FAILURE);
+  }
+  memset(k->coords_t16, 0, bytes);
+#ifdef KMEANS_SIMD_X86
+  k->avx512bw = k->nivel == SIMD_AVX512 && __builtin_cpu_supports("avx512bw");
+  k->avx512vnni = k->avx512bw && __builtin_cpu_supports("avx512vnni");
+#endif
+  kernel_escolher_caminho(k);
+}
+
+static inline void kernel_alocar_blocado(KernelAtribuicao* k, int centro) {
+  size_t bytes = (size_t)k->k_pad * k->d_par * sizeof(int16_t);
+  k->coords_b = (int16_t*)aligned_alloc(64, (bytes + 63) / 64 * 64);
+  k->normas = (int32_t*)aligned_alloc(64, (size_t)k->k_pad * sizeof(int32_t));
+  if (k->coords_b == NULL || k->normas == NULL) {
+    fprintf(stderr, "Erro: falha ao alocar o kernel de atribuição.\n");
+    exit(EXIT_FAILURE);
+  }
+  // Os centroides de preenchimento ficam na origem com norma INT32_MAX e nunca vencem
+  memset(k->coords_b, 0, bytes);
+  for (int j = k->num_clusters; j < k->k_pad; j++) {
+    k->normas[j] = INT32_MAX;
+  }
+  k->centro = centro;
+  int bloco = KERNEL_BLOCADO_BYTES / (k->d_par * (int)sizeof(int16_t) + (int)sizeof(int32_t));
+  bloco = bloco / SIMD_LARGURA_MAX * SIMD_LARGURA_MAX;
+  k->bloco_centroides = bloco > SIMD_LARGURA_MAX ? bloco : SIMD_LARGURA_MAX;
+}
+
+/**
+ * @brief Aloca os centroides centrados e as normas do modo blocado. Requer
+ * kernel_habilitar_compacto e kernel_blocado_seguro verdadeiro para os dados.
+ */
+static inline void kernel_habilitar_blocado(KernelAtribuicao* k, int min_val, int max_val) {
+  kernel_alocar_blocado(k, (int)(((long long)min_val + max_val) / 2));
+}
+
+/**
+ * @brief Inicia 'copia' com a mesma configuração de 'original' (conjunto de instruções,
+ * modos compacto e blocado). Os layouts são alocados e zerados pela thread chamadora,
+ * e os centroides precisam ser carregados na cópia separadamente.
+ */
+static inline void kernel_replicar(KernelAtribuicao* copia, const KernelAtribuicao* original) {
+  kernel_iniciar(copia, original->nivel, original->num_clusters, original->num_dimensoes);
+  if (original->coords_t16 != NULL) kernel_habilitar_compacto(copia);
+  if (original->coords_b != NULL) kernel_alocar_blocado(copia, original->centro);
+}
+
+static inline void kernel_liberar(KernelAtribuicao* k) {
+  free(k->coords);
+  free(k->coords_t);
+  free(k->coords_t16);
+  free(k->coords_b);
+  free(k->normas);
+}
+
+/**
+ * @brief Copia os centroides [inicio, fim) (linhas de uma matriz K x D contígua) para
+ * os layouts do kernel. Faixas disjuntas podem ser carregadas por threads diferentes.
+ */
+static inline void kernel_carregar_faixa(KernelAtribuicao* k, const int* centroides, int inicio, int fim) {
+  const int D = k->num_dimensoes;
+  memcpy(&k->coords[(size_t)inicio * D], &centroides[(size_t)inicio * D], (size_t)(fim - inicio) * D * sizeof(int));
+  for (int j = inicio; j < fim; j++) {
+    for (int d = 0; d < D; d++) {
+      k->coords_t[(size_t)d * k->k_pad + j] = centroides[(size_t)j * D + d];
+    }
+  }
+  if (k->coords_t16 != NULL) {
+    for (int j = inicio; j < fim; j++) {
+      for (int d = 0; d < D; d++) {
+        k->coords_t16[((size_t)(d / 2) * k->k_pad + j) * 2 + (d & 1)] = (int16_t)centroides[(size_t)j * D + d];
+      }
+    }
+  }
+  if (k->coords_b != NULL) {
+    for (int j = inicio; j < fim; j++) {
+      int32_t norma = 0;
+      for (int d = 0; d < D; d++) {
+        int16_t v = (int16_t)(centroides[(size_t)j * D + d] - k->centro);
+        k->coords_b[((size_t)(d / 2) * k->k_pad + j) * 2 + (d & 1)] = v;
+        norma += (int32_t)v * v;
+      }
+      k->normas[j] = norma;
+    }
+  }
+}
+
+/**
+ * @brief Copia todos os centroides (K x D contíguos) para os layouts do kernel.
+ * Deve ser chamada uma vez por iteração, antes da fase de atribuição.
+ */
+static inline void kernel_carregar_centroides(KernelAtribuicao* k, const int* centroides) {
+  kernel_carregar_faixa(k, centroides, 0, k->num_clusters);
+}
+
+// Os kernels "_dim" recebem D como parâmetro e são sempre expandidos no chamador:
+// instanciados com uma constante (KERNEL_D_FIXOS, no fim deste arquivo), os laços
+// sobre as dimensões são desenrolados pelo compilador; com k->num_dimensoes, formam
+// a versão genérica usada para os demais valores de D.
+#define KERNEL_DIM static inline __attribute__((always_inline))
+
+KERNEL_DIM int kernel_mais_proximo_escalar_dim(const KernelAtribuicao* k, const int* ponto, const int D) {
+  long long min_dist = LLONG_MAX;
+  int best_cluster = -1;
+  for (int j = 0; j < k->num_clusters; j++) {
+    const int* c = &k->coords[(size_t)j * D];
+    long long dist = 0;
+    for (int d = 0; d < D; d++) {
+      long long diff = (long long)ponto[d] - c[d];
+      dist += diff * diff;
+    }
+    if (dist < min_dist) {
+      min_dist = dist;
+      best_cluster = j;
+    }
+  }
+  return best_cluster;
+}
+
+static inline void kernel_distancias_escalar(const KernelAtribuicao* k, const int* ponto, long long* saida) {
+  const int D = k->num_dimensoes;
+  for (int j = 0; j < k->num_clusters; j++) {
+    const int* c = &k->coords[(size_t)j * D];
+    long long dist = 0;
+    for (int d = 0; d < D; d++) {
+      long long diff = (long long)ponto[d] - c[d];
+      dist += diff * diff;
+    }
+    saida[j] = dist;
+  }
+}
+
+KERNEL_DIM int kernel_mais_proximo_compacto_escalar_dim(const KernelAtribuicao* k, const int16_t* ponto, const int D) {
+  int32_t min_dist = INT32_MAX;
+  int best_cluster = -1;
+  for (int j = 0; j < k->num_clusters; j++) {
+    const int* c = &k->coords[(size_t)j * D];
+    int32_t dist = 0;
+    for (int d = 0; d < D; d++) {
+      int32_t diff = ponto[d] - c[d];
+      dist += diff * diff;
+    }
+    // O primeiro centroide é sempre aceito: a distância pode ser exatamente INT32_MAX
+    if (dist < min_dist || best_cluster < 0) {
+      min_dist = dist;
+      best_cluster = j;
+    }
+  }
+  return best_cluster;
+}
+
+#ifdef KMEANS_SIMD_X86
+// Em ambos os conjuntos de instruções, o acumulador "par" recebe os centroides
+// j, j+2, j+4, ... (32 bits baixos de cada faixa de 64) e "impar" recebe j+1,
+// j+3, ... A posição do centroide j+t no bloco armazenado é dada por
+// (t & 1) * (largura / 2) + (t >> 1). As varreduras percorrem os centroides em
+// ordem crescente com '<' estrito, preservando o desempate pelo menor índice da
+// versão de referência.
+
+__attribute__((target("avx2")))
+KERNEL_DIM void kernel_bloco_avx2(const KernelAtribuicao* k, const int* ponto, int j, long long* dist, const int D) {
+  const int k_pad = k->k_pad;
+  const int* c = k->coords_t + j;
+  __m256i par = _mm256_setzero_si256();
+  __m256i impar = _mm256_setzero_si256();
+  for (int d = 0; d < D; d++) {
+    __m256i p = _mm256_set1_epi32(ponto[d]);
+    __m256i cv = _mm256_load_si256((const __m256i*)(c + (size_t)d * k_pad));
+    __m256i diff = _mm256_sub_epi32(p, cv);
+    par = _mm256_add_epi64(par, _mm256_mul_epi32(diff, diff));
+    __m256i alto = _mm256_srli_epi64(diff, 32);
+    impar = _mm256_add_epi64(impar, _mm256_mul_epi32(alto, alto));
+  }
+  _mm256_store_si256((__m256i*)dist, par);
+  _mm256_store_si256((__m256i*)(dist + 4), impar);
+}
+
+__attribute__((target("avx2")))
+KERNEL_DIM int kernel_mais_proximo_avx2_dim(const KernelAtribuicao* k, const int* ponto, const int D) {
+  long long dist[8] __attribute__((aligned(32)));
+  long long min_dist = LLONG_MAX;
+  int best_cluster = -1;
+
+  for (int j = 0; j < k->num_clusters; j += 8) {
+    kernel_bloco_avx2(k, ponto, j, dist, D);
+    int limite = k->num_clusters - j < 8 ? k->num_clusters - j : 8;
+    for (int t = 0; t < limite; t++) {
+      long long d2 = dist[(t & 1) * 4 + (t >> 1)];
+      if (d2 < min_dist) {
+        min_dist = d2;
+        best_cluster = j + t;
+      }
+    }
+  }
+  return best_cluster;
+}
+
+__attribute__((target("avx2")))
+static inline void kernel_distancias_avx2(const KernelAtribuicao* k, const int* ponto, long long* saida) {
+  long long dist[8] __attribute__((aligned(32)));
+  for (int j = 0; j < k->num_clusters; j += 8) {
+    kernel_bloco_avx2(k, ponto, j, dist, k->num_dimensoes);
+    int limite = k->num_clusters - j < 8 ? k->num_clusters - j : 8;
+    for (int t = 0; t < limite; t++) {
+      saida[j + t] = dist[(t & 1) * 4 + (t >> 1)];
+    }
+  }
+}
+
+__attribute__((target("avx512f")))
+KERNEL_DIM void kernel_bloco_avx512(const KernelAtribuicao* k, const int* ponto, int j, long long* dist, const int D) {
+  const int k_pad = k->k_pad;
+  const int* c = k->coords_t + j;
+  __m512i par = _mm512_setzero_si512();
+  __m512i impar = _mm512_setzero_si512();
+  for (int d = 0; d < D; d++) {
+    __m512i p = _mm512_set1_epi32(ponto[d]);
+    __m512i cv = _mm512_load_si512((const void*)(c + (size_t)d * k_pad));
+    __m512i diff = _mm512_sub_epi32(p, cv);
+    par = _mm512_add_epi64(par, _mm512_mul_epi32(diff, diff));
+    __m512i alto = _mm512_srli_epi64(diff, 32);
+    impar = _mm512_add_epi64(impar, _mm512_mul_epi32(alto, alto));
+  }
+  _mm512_store_si512((void*)dist, par);
+  _mm512_store_si512((void*)(dist + 8), impar);
+}
+
+__attribute__((target("avx512f")))
+KERNEL_DIM int kernel_mais_proximo_avx512_dim(const KernelAtribuicao* k, const int* ponto, const int D) {
+  long long dist[16] __attribute__((aligned(64)));
+  long long min_dist = LLONG_MAX;
+  int best_cluster = -1;
+
+  for (int j = 0; j < k->num_clusters; j += 16) {
+    kernel_bloco_avx512(k, ponto, j, dist, D);
+    int limite = k->num_clusters - j < 16 ? k->num_clusters - j : 16;
+    for (int t = 0; t < limite; t++) {
+      long long d2 = dist[(t & 1) * 8 + (t >> 1)];
+      if (d2 < min_dist) {
+        min_dist = d2;
+        best_cluster = j + t;
+      }
+    }
+  }
+  return best_cluster;
+}
+
+__attribute__((target("avx512f")))
+static inline void kernel_distancias_avx512(const KernelAtribuicao* k, const int* ponto, long long* saida) {
+  long long dist[16] __attribute__((aligned(64)));
+  for (int j = 0; j < k->num_clusters; j += 16) {
+    kernel_bloco_avx512(k, ponto, j, dist, k->num_dimensoes);
+    int limite = k->num_clusters - j < 16 ? k->num_clusters - j : 16;
+    for (int t = 0; t < limite; t++) {
+      saida[j + t] = dist[(t & 1) * 8 + (t >> 1)];
+    }
+  }
+}
+#endif
+
+#ifdef KMEANS_SIMD_X86
+// Kernels compactos: cada faixa de 32 bits tem um centroide, e cada passo do laço
+// processa duas dimensões. O mínimo de cada bloco é achado no próprio registrador
+// (as faixas além de num_clusters valem INT32_MAX) e a primeira faixa com esse valor
+// dá o menor índice; entre blocos a comparação é estrita, como nos outros kernels.
+
+__attribute__((target("avx2")))
+KERNEL_DIM int kernel_mais_proximo_compacto_avx2_dim(const KernelAtribuicao* k, const int16_t* ponto, const int D) {
+  const int pares = (D + 1) / 2, k_pad = k->k_pad;
+  const int32_t* c32 = (const int32_t*)k->coords_t16;
+  const __m256i faixas = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  int32_t min_dist = INT32_MAX;
+  int best_cluster = -1;
+
+  for (int j = 0; j < k->num_clusters; j += 8) {
+    __m256i acc = _mm256_setzero_si256();
+    for (int q = 0; q < pares; q++) {
+      int32_t par;
+      memcpy(&par, &ponto[2 * q], sizeof(par));
+      __m256i diff = _mm256_sub_epi16(_mm256_set1_epi32(par),
+                                      _mm256_load_si256((const __m256i*)(c32 + (size_t)q * k_pad + j)));
+      acc = _mm256_add_epi32(acc, _mm256_madd_epi16(diff, diff));
+    }
+    __m256i validas = _mm256_cmpgt_epi32(_mm256_set1_epi32(k->num_clusters - j), faixas);
+    acc = _mm256_blendv_epi8(_mm256_set1_epi32(INT32_MAX), acc, validas);
+    __m256i m = _mm256_min_epi32(acc, _mm256_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm256_min_epi32(m, _mm256_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    m = _mm256_min_epi32(m, _mm256_permute2x128_si256(m, m, 1));
+    int32_t minimo = _mm256_extract_epi32(m, 0);
+    if (minimo < min_dist || best_cluster < 0) {
+      int iguais = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(acc, m)));
+      min_dist = minimo;
+      best_cluster = j + __builtin_ctz(iguais);
+    }
+  }
+  return best_cluster;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+KERNEL_DIM int kernel_mais_proximo_compacto_avx512_dim(const KernelAtribuicao* k, const int16_t* ponto, const int D) {
+  const int pares = (D + 1) / 2, k_pad = k->k_pad;
+  const int32_t* c32 = (const int32_t*)k->coords_t16;
+  int32_t min_dist = INT32_MAX;
+  int best_cluster = -1;
+
+  for (int j = 0; j < k->num_clusters; j += 16) {
+    __m512i acc = _mm512_setzero_si512();
+    for (int q = 0; q < pares; q++) {
+      int32_t par;
+      memcpy(&par, &ponto[2 * q], sizeof(par));
+      __m512i diff = _mm512_sub_epi16(_mm512_set1_epi32(par),
+                                      _mm512_load_si512((const void*)(c32 + (size_t)q * k_pad + j)));
+      acc = _mm512_add_epi32(acc, _mm512_madd_epi16(diff, diff));
+    }
+    int restantes = k->num_clusters - j;
+    __mmask16 validas = restantes >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << restantes) - 1);
+    acc = _mm512_mask_blend_epi32(validas, _mm512_set1_epi32(INT32_MAX), acc);
+    int32_t minimo = _mm512_reduce_min_epi32(acc);
+    if (minimo < min_dist || best_cluster < 0) {
+      __mmask16 iguais = _mm512_cmpeq_epi32_mask(acc, _mm512_set1_epi32(minimo));
+      min_dist = minimo;
+      best_cluster = j + __builtin_ctz((unsigned)iguais);
+    }
+  }
+  return best_cluster;
+}
+#endif
+
+KERNEL_DIM long long kernel_atribuir_colunas_escalar_dim(const KernelAtribuicao* k, const int* colunas, int num_pontos,
+                                                        int inicio, int fim, int32_t* rotulos, const int D) {
+  long long mudancas = 0;
+  for (int i = inicio; i < fim; i++) {
+    long long min_dist = LLONG_MAX;
+    int best_cluster = -1;
+    for (int j = 0; j < k->num_clusters; j++) {
+      const int* c = &k->coords[(size_t)j * D];
+      long long dist = 0;
+      for (int d = 0; d < D; d++) {
+        long long diff = (long long)colunas[(size_t)d * num_pontos + i] - c[d];
+        dist += diff * diff;
+      }
+      if (dist < min_dist) {
+        min_dist = dist;
+        best_cluster = j;
+      }
+    }
+    mudancas += best_cluster != rotulos[i];
+    rotulos[i] = best_cluster;
+  }
+  return mudancas;
+}
+
+#ifdef KMEANS_SIMD_X86
+__attribute__((target("avx2")))
+KERNEL_DIM long long kernel_atribuir_colunas_avx2_dim(const KernelAtribuicao* k, const int* colunas, int num_pontos,
+                                                     int inicio, int fim, int32_t* rotulos, const int D) {
+  long long mudancas = 0;
+  int i = inicio;
+  for (; i + 4 <= fim; i += 4) {
+    __m256i min_dist = _mm256_set1_epi64x(LLONG_MAX);
+    __m256i best_cluster = _mm256_set1_epi64x(-1);
+    for (int j = 0; j < k->num_clusters; j++) {
+      const int* c = &k->coords[(size_t)j * D];
+      __m256i dist = _mm256_setzero_si256();
+      for (int d = 0; d < D; d++) {
+        __m256i x = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)&colunas[(size_t)d * num_pontos + i]));
+        __m256i diff = _mm256_sub_epi64(x, _mm256_set1_epi64x(c[d]));
+        dist = _mm256_add_epi64(dist, _mm256_mul_epi32(diff, diff));
+      }
+      __m256i menor = _mm256_cmpgt_epi64(min_dist, dist);
+      min_dist = _mm256_blendv_epi8(min_dist, dist, menor);
+      best_cluster = _mm256_blendv_epi8(best_cluster, _mm256_set1_epi64x(j), menor);
+    }
+    // Os índices estão nos 32 bits baixos de cada faixa de 64
+    __m128i novos = _mm256_castsi256_si128(
+        _mm256_permutevar8x32_epi32(best_cluster, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6)));
+    __m128i antigos = _mm_loadu_si128((const __m128i*)&rotulos[i]);
+    mudancas += 4 - __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(novos, antigos))));
+    _mm_storeu_si128((__m128i*)&rotulos[i], novos);
+  }
+  return mudancas + kernel_atribuir_colunas_escalar_dim(k, colunas, num_pontos, i, fim, rotulos, D);
+}
+
+__attribute__((target("avx512f")))
+KERNEL_DIM long long kernel_atribuir_colunas_avx512_dim(const KernelAtribuicao* k, const int* colunas, int num_pontos,
+                                                       int inicio, int fim, int32_t* rotulos, const int D) {
+  long long mudancas = 0;
+  int i = inicio;
+  for (; i + 8 <= fim; i += 8) {
+    __m512i min_dist = _mm512_set1_epi64(LLONG_MAX);
+    __m512i best_cluster = _mm512_set1_epi64(-1);
+    for (int j = 0; j < k->num_clusters; j++) {
+      const int* c = &k->coords[(size_t)j * D];
+      __m512i dist = _mm512_setzero_si512();
+      for (int d = 0; d < D; d++) {
+        __m512i x = _mm512_cvtepi32_epi64(_mm256_loadu_si256((const __m256i*)&colunas[(size_t)d * num_pontos + i]));
+        __m512i diff = _mm512_sub_epi64(x, _mm512_set1_epi64(c[d]));
+        dist = _mm512_add_epi64(dist, _mm512_mul_epi32(diff, diff));
+      }
+      __mmask8 menor = _mm512_cmplt_epi64_mask(dist, min_dist);
+      min_dist = _mm512_mask_mov_epi64(min_dist, menor, dist);
+      best_cluster = _mm512_mask_mov_epi64(best_cluster, menor, _mm512_set1_epi64(j));
+    }
+    __m256i novos = _mm512_cvtepi64_epi32(best_cluster);
+    __m256i antigos = _mm256_loadu_si256((const __m256i*)&rotulos[i]);
+    mudancas += 8 - __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(novos, antigos))));
+    _mm256_storeu_si256((__m256i*)&rotulos[i], novos);
+  }
+  return mudancas + kernel_atribuir_colunas_escalar_dim(k, colunas, num_pontos, i, fim, rotulos, D);
+}
+#endif
+
+/**
+ * @brief Centra os pontos [i, i + KERNEL_BLOCADO_GRUPO) em 'xc', um par de dimensões
+ * por int32 (xc[p * pares + q]). Pontos além de 'fim' repetem o último, e a posição
+ * de preenchimento de D ímpar pode ter qualquer valor (o centroide vale 0 nela).
+ */
+KERNEL_DIM void kernel_blocado_centrar(const KernelAtribuicao* k, const int16_t* pontos, int i, int fim, int32_t* xc,
+                                       const int D) {
+  const int pares = (D + 1) / 2;
+  const int16_t centro = (int16_t)k->centro;
+  for (int p = 0; p < KERNEL_BLOCADO_GRUPO; p++) {
+    const int16_t* x = &pontos[(size_t)(i + p < fim ? i + p : fim - 1) * k->d_par];
+    for (int q = 0; q < pares; q++) {
+      int16_t par[2] = {(int16_t)(x[2 * q] - centro), (int16_t)(x[2 * q + 1] - centro)};
+      memcpy(&xc[p * pares + q], par, sizeof(par));
+    }
+  }
+}
+
+/**
+ * @brief Grava os rótulos de 'n' pontos a partir de 'inicio' e conta os que mudaram.
+ */
+static inline long long kernel_blocado_gravar(const int32_t* melhor_i, int inicio, int n, int32_t* rotulos) {
+  long long mudancas = 0;
+  for (int p = 0; p < n; p++) {
+    mudancas += melhor_i[p] != rotulos[inicio + p];
+    rotulos[inicio + p] = melhor_i[p];
+  }
+  return mudancas;
+}
+
+KERNEL_DIM long long kernel_atribuir_blocado_escalar_dim(const KernelAtribuicao* k, const int16_t* pontos, int inicio,
+                                                        int fim, int32_t* rotulos, const int D) {
+  const int pares = (D + 1) / 2, k_pad = k->k_pad;
+  long long mudancas = 0;
+  for (int i0 = inicio; i0 < fim; i0 += KERNEL_BLOCADO_PONTOS) {
+    const int n = fim - i0 < KERNEL_BLOCADO_PONTOS ? fim - i0 : KERNEL_BLOCADO_PONTOS;
+    int32_t melhor_v[KERNEL_BLOCADO_PONTOS], melhor_i[KERNEL_BLOCADO_PONTOS];
+    for (int p = 0; p < n; p++) {
+      melhor_v[p] = INT32_MAX;
+      melhor_i[p] = -1;
+    }
+    for (int j0 = 0; j0 < k->num_clusters; j0 += k->bloco_centroides) {
+      const int j1 = j0 + k->bloco_centroides < k->num_clusters ? j0 + k->bloco_centroides : k->num_clusters;
+      for (int g = 0; g < n; g += KERNEL_BLOCADO_GRUPO) {
+        int32_t xc[KERNEL_BLOCADO_GRUPO * KERNEL_BLOCADO_PARES_MAX];
+        kernel_blocado_centrar(k, pontos, i0 + g, fim, xc, D);
+        for (int p = 0; p < KERNEL_BLOCADO_GRUPO && g + p < n; p++) {
+          for (int j = j0; j < j1; j++) {
+            int32_t dot = 0;
+            for (int q = 0; q < pares; q++) {
+              int16_t x[2];
+              memcpy(x, &xc[p * pares + q], sizeof(x));
+              const int16_t* c = &k->coords_b[((size_t)q * k_pad + j) * 2];
+              dot += (int32_t)x[0] * c[0] + (int32_t)x[1] * c[1];
+            }
+            int32_t v = k->normas[j] - 2 * dot;
+            if (v < melhor_v[g + p]) {
+              melhor_v[g + p] = v;
+              melhor_i[g + p] = j;
+            }
+          }
+        }
+      }
+    }
+    mudancas += kernel_blocado_gravar(melhor_i, i0, n, rotulos);
+  }
+  return mudancas;
+}
+
+#ifdef KMEANS_SIMD_X86
+// Kernels blocados: cada faixa de 32 bits tem um centroide, e os KERNEL_BLOCADO_GRUPO
+// pontos do grupo mantêm em registradores o menor valor de cada faixa e o índice
+// correspondente ('<' estrito, blocos em ordem crescente). No fim de cada bloco de
+// centroides o mínimo do registrador é reduzido, e entre as faixas empatadas vale o
+// menor índice.
+
+__attribute__((target("avx2")))
+static inline void kernel_blocado_reduzir_avx2(__m256i valor, __m256i indice, int32_t* melhor_v, int32_t* melhor_i) {
+  __m256i m = _mm256_min_epi32(valor, _mm256_shuffle_epi32(valor, _MM_SHUFFLE(1, 0, 3, 2)));
+  m = _mm256_min_epi32(m, _mm256_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+  m = _mm256_min_epi32(m, _mm256_permute2x128_si256(m, m, 1));
+  int32_t minimo = _mm256_extract_epi32(m, 0);
+  if (minimo >= *melhor_v) return;
+  __m256i idx = _mm256_blendv_epi8(_mm256_set1_epi32(INT32_MAX), indice, _mm256_cmpeq_epi32(valor, m));
+  idx = _mm256_min_epi32(idx, _mm256_shuffle_epi32(idx, _MM_SHUFFLE(1, 0, 3, 2)));
+  idx = _mm256_min_epi32(idx, _mm256_shuffle_epi32(idx, _MM_SHUFFLE(2, 3, 0, 1)));
+  idx = _mm256_min_epi32(idx, _mm256_permute2x128_si256(idx, idx, 1));
+  *melhor_v = minimo;
+  *melhor_i = _mm256_extract_epi32(idx, 0);
+}
+
+__attribute__((target("avx2")))
+KERNEL_DIM long long kernel_atribuir_blocado_avx2_dim(const KernelAtribuicao* k, const int16_t* pontos, int inicio,
+                                                     int fim, int32_t* rotulos, const int D) {
+  const int pares = (D + 1) / 2, k_pad = k->k_pad;
+  const int32_t* c32 = (const int32_t*)k->coords_b;
+  const __m256i faixas = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  long long mudancas = 0;
+  for (int i0 = inicio; i0 < fim; i0 += KERNEL_BLOCADO_PONTOS) {
+    const int n = fim - i0 < KERNEL_BLOCADO_PONTOS ? fim - i0 : KERNEL_BLOCADO_PONTOS;
+    int32_t melhor_v[KERNEL_BLOCADO_PONTOS], melhor_i[KERNEL_BLOCADO_PONTOS];
+    for (int p = 0; p < n; p++) {
+      melhor_v[p] = INT32_MAX;
+      melhor_i[p] = -1;
+    }
+    for (int j0 = 0; j0 < k->num_clusters; j0 += k->bloco_centroides) {
+      const int j1 = j0 + k->bloco_centroides < k->num_clusters ? j0 + k->bloco_centroides : k->num_clusters;
+      for (int g = 0; g < n; g += KERNEL_BLOCADO_GRUPO) {
+        int32_t xc[KERNEL_BLOCADO_GRUPO * KERNEL_BLOCADO_PARES_MAX];
+        kernel_blocado_centrar(k, pontos, i0 + g, fim, xc, D);
+        __m256i valor[KERNEL_BLOCADO_GRUPO], indice[KERNEL_BLOCADO_GRUPO];
+        for (int p = 0; p < KERNEL_BLOCADO_GRUPO; p++) {
+          valor[p] = _mm256_set1_epi32(INT32_MAX);
+          indice[p] = _mm256_setzero_si256();
+        }
+        for (int j = j0; j < j1; j += 8) {
+          __m256i acc[KERNEL_BLOCADO_GRUPO];
+          for (int p = 0; p < KERNEL_BLOCADO_GRUPO; p++) {
+            acc[p] = _mm256_setzero_si256();
+          }
+          for (int q = 0; q < pares; q++) {
+            __m256i c = _mm256_load_si256((const __m256i*)(c32 + (size_t)q * k_pad + j));
+            for (int p = 0; p < KERNEL_BLOCADO_GRUPO; p++) {
+              acc[p] = _mm256_add_epi32(acc[p], _mm256_madd_epi16(_mm256_set1_epi32(xc[p * pares + q]), c));
+            }
+          }
+          __m256i norma = _mm256_load_si256((const __m256i*)(k->normas + j));
+          __m256i idx = _mm256_add_epi32(_mm256_set1_epi32(j), faixas);
+          for (int p = 0; p < KERNEL_BLOCADO_GRUPO; p++) {
+            __m256i v = _mm256_sub_epi32(norma, _mm256_slli_epi32(acc[p], 1));
+            __m256i menor = _mm256_cmpgt_epi32(valor[p], v);
+            valor[p] = _mm256_blendv_epi8(valor[p], v, menor);
+            indice[p] = _mm256_blendv_epi8(indice[p], idx, menor);
+          }
+        }
+        for (int p = 0; p < KERNEL_BLOCADO_GRUPO && g + p < n; p++) {
+          kernel_blocado_reduzir_avx2(valor[p], indice[p], &melhor_v[g + p], &melhor_i[g + p]);
+        }
+      }
+    }
+    mudancas += kernel_blocado_gravar(melhor_i, i0, n, rotulos);
+  }
+  return mudancas;
+}
+
+// O kernel de 512 bits tem duas versões, que só diferem no passo de acumulação:
+// madd + add (AVX-512BW) ou uma única instrução vpdpwssd (AVX-512 VNNI).
+#define KERNEL_BLOCADO_MADD(acc, x, c) _mm512_add_epi32(acc, _mm512_madd_epi16(x, c))
+#define KERNEL_BLOCADO_DPWSSD(acc, x, c) _mm512_dpwssd_epi32(acc, x, c)
+
+#define KERNEL_BLOCADO_AVX512_DIM(NOME, ALVO, ACUMULAR)                                                         \
+  __attribute__((target(ALVO)))                                                                                 \
+  KERNEL_DIM long long NOME(const KernelAtribuicao* k, const int16_t* pontos, int inicio, int fim,              \
+                            int32_t* rotulos, const int D) {                                                    \
+    const int pares = (D + 1) / 2, k_pad = k->k_pad;                                                            \
+    const int32_t* c32 = (const int32_t*)k->coords_b;                                                           \
+    const __m512i faixas = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);             \
+    long long mudancas = 0;                                                                                     \
+    for (int i0 = inicio; i0 < fim; i0 += KERNEL_BLOCADO_PONTOS) {                                              \
+      const int n = fim - i0 < KERNEL_BLOCADO_PONTOS ? fim - i0 : KERNEL_BLOCADO_PONTOS;                        \
+      int32_t melhor_v[KERNEL_BLOCADO_PONTOS], melhor_i[KERNEL_BLOCADO_PONTOS];                                 \
+      for (int p = 0; p < n; p++) {                                                                             \
+        melhor_v[p] = INT32_MAX;                                                                                \
+        melhor_i[p] = -1;                                                                                       \
+      }                                                                                                         \
+      for (int j0 = 0; j0 < k->num_clusters; j0 += k->bloco_centroides) {                                       \
+        const int j1 = j0 + k->bloco_centroides < k->num_clusters ? j0 + k->bloco_centroides : k->num_clusters; \
+        for (int g = 0; g < n; g += KERNEL_BLOCADO_GRUPO) {                                                     \
+          int32_t xc[KERNEL_BLOCADO_GRUPO * KERNEL_BLOCADO_PARES_MAX];                                          \
+          kernel_blocado_centrar(k, pontos, i0 + g, fim, xc, D);                                                \
+          __m512i valor[KERNEL_BLOCADO_GRUPO], indice[KERNEL_BLOCADO_GRUPO];                                    \
+          for (int p = 0; p < KERNEL_BLOCADO_GRUPO; p++) {                                                      \
+            valor[p] = _mm512_set1_epi32(INT32_MAX);                                                            \
+            indice[p] = _mm512_setzero_si512();                                                                 \
+          }                                                                                                     \
+          for (int j = j0; j < j1; j += 16) {                                                                   \
+            __m512i acc[KERNEL_BLOCADO_GRUPO];                                                                  \
+            for (int p = 0; p < KERNEL_BLOCADO_GRUPO; p++) {                                                    \
+              acc[p] = _mm512_setzero_si512();                                                                  \
+            }                                                                                                   \
+            for (int q = 0; q < pares; q++) {                                                                   \
+              __m512i c = _mm512_load_si512((const void*)(c32 + (size_t)q * k_pad + j));                        \
+              for (int p = 0; p < KERNEL_BLOCADO_GRUPO; p++) {                                                  \
+                acc[p] = ACUMULAR(acc[p], _mm512_set1_epi32(xc[p * pares + q]), c);                             \
+              }                                                                                                 \
+            }                                                                                                   \
+            __m512i norma = _mm512_load_si512((const void*)(k->normas + j));                                    \
+            __m512i idx = _mm512_add_epi32(_mm512_set1_epi32(j), faixas);                                       \
+            for (int p = 0; p < KERNEL_BLOCADO_GRUPO; p++) {                                                    \
+              __m512i v = _mm512_sub_epi32(norma, _mm512_slli_epi32(acc[p], 1));                                \
+              __mmask16 menor = _mm512_cmplt_epi32_mask(v, valor[p]);                                           \
+              valor[p] = _mm512_mask_mov_epi32(valor[p], menor, v);                                             \
+              indice[p] = _mm512_mask_mov_epi32(indice[p], menor, idx);                                         \
+            }                                                                                                   \
+          }                                                                                                     \
+          for (int p = 0; p < KERNEL_BLOCADO_GRUPO && g + p < n; p++) {                                         \
+            int32_t minimo = _mm512_reduce_min_epi32(valor[p]);                                                 \
+            if (minimo < melhor_v[g + p]) {                                                                     \
+              __mmask16 iguais = _mm512_cmpeq_epi32_mask(valor[p], _mm512_set1_epi32(minimo));                  \
+              melhor_v[g + p] = minimo;                                                                         \
+              melhor_i[g + p] = _mm512_mask_reduce_min_epi32(iguais, indice[p]);                                \
+            }                                                                                                   \
+          }                                                                                                     \
+        }                                                                                                       \
+      }                                                                                                         \
+      mudancas += kernel_blocado_gravar(melhor_i, i0, n, rotulos);                                              \
+    }                                                                                                           \
+    return mudancas;                                                                                            \
+  }
+
+KERNEL_BLOCADO_AVX512_DIM(kernel_atribuir_blocado_avx512_dim, "avx512f,avx512bw", KERNEL_BLOCADO_MADD)
+KERNEL_BLOCADO_AVX512_DIM(kernel_atribuir_blocado_vnni_dim, "avx512f,avx512bw,avx512vnni", KERNEL_BLOCADO_DPWSSD)
+#endif
+
+// Instâncias dos kernels: uma genérica (D lido do kernel) e uma por valor de
+// KERNEL_D_FIXOS, em que D é constante e as coordenadas do ponto (difundidas
+// para o registrador uma vez por dimensão) ficam em registradores durante toda a
+// varredura dos centroides. kernel_escolher_caminho escolhe a instância.
+#define KERNEL_D_FIXOS(X) X(2) X(3) X(8) X(10) X(16) X(32)
+
+#define KERNEL_GERAR_ESCALAR(SUFIXO, D)                                                              \
+  static int kernel_mais_proximo_escalar_##SUFIXO(const KernelAtribuicao* k, const int* ponto) {     \
+    return kernel_mais_proximo_escalar_dim(k, ponto, D);                                              \
+  }                                                                                                   \
+  static int kernel_mais_proximo_compacto_escalar_##SUFIXO(const KernelAtribuicao* k, const int16_t* ponto) { \
+    return kernel_mais_proximo_compacto_escalar_dim(k, ponto, D);                                     \
+  }                                                                                                   \
+  static long long kernel_atribuir_colunas_escalar_##SUFIXO(const KernelAtribuicao* k, const int* colunas, \
+                                                            int num_pontos, int inicio, int fim, int32_t* rotulos) { \
+    return kernel_atribuir_colunas_escalar_dim(k, colunas, num_pontos, inicio, fim, rotulos, D);      \
+  }                                                                                                   \
+  static long long kernel_atribuir_blocado_escalar_##SUFIXO(const KernelAtribuicao* k, const int16_t* pontos, \
+                                                            int inicio, int fim, int32_t* rotulos) { \
+    return kernel_atribuir_blocado_escalar_dim(k, pontos, inicio, fim, rotulos, D);                   \
+  }
+
+#ifdef KMEANS_SIMD_X86
+#define KERNEL_GERAR(SUFIXO, D)                                                                       \
+  KERNEL_GERAR_ESCALAR(SUFIXO, D)                                                                     \
+  __attribute__((target("avx2"))) static int kernel_mais_proximo_avx2_##SUFIXO(const KernelAtribuicao* k, \
+                                                                               const int* ponto) {    \
+    return kernel_mais_proximo_avx2_dim(k, ponto, D);                                                 \
+  }                                                                                                   \
+  __attribute__((target("avx512f"))) static int kernel_mais_proximo_avx512_##SUFIXO(const KernelAtribuicao* k, \
+                                                                                    const int* ponto) { \
+    return kernel_mais_proximo_avx512_dim(k, ponto, D);                                               \
+  }                                                                                                   \
+  __attribute__((target("avx2"))) static int kernel_mais_proximo_compacto_avx2_##SUFIXO(              \
+      const KernelAtribuicao* k, const int16_t* ponto) {                                              \
+    return kernel_mais_proximo_compacto_avx2_dim(k, ponto, D);                                        \
+  }                                                                                                   \
+  __attribute__((target("avx512f,avx512bw"))) static int kernel_mais_proximo_compacto_avx512_##SUFIXO( \
+      const KernelAtribuicao* k, const int16_t* ponto) {                                              \
+    return kernel_mais_proximo_compacto_avx512_dim(k, ponto, D);                                      \
+  }                                                                                                   \
+  __attribute__((target("avx2"))) static long long kernel_atribuir_colunas_avx2_##SUFIXO(             \
+      const KernelAtribuicao* k, const int* colunas, int num_pontos, int inicio, int fim, int32_t* rotulos) { \
+    return kernel_atribuir_colunas_avx2_dim(k, colunas, num_pontos, inicio, fim, rotulos, D);         \
+  }                                                                                                   \
+  __attribute__((target("avx512f"))) static long long kernel_atribuir_colunas_avx512_##SUFIXO(        \
+      const KernelAtribuicao* k, const int* colunas, int num_pontos, int inicio, int fim, int32_t* rotulos) { \
+    return kernel_atribuir_colunas_avx512_dim(k, colunas, num_pontos, inicio, fim, rotulos, D);       \
+  }                                                                                                   \
+  __attribute__((target("avx2"))) static long long kernel_atribuir_blocado_avx2_##SUFIXO(             \
+      const KernelAtribuicao* k, const int16_t* pontos, int inicio, int fim, int32_t* rotulos) {      \
+    return kernel_atribuir_blocado_avx2_dim(k, pontos, inicio, fim, rotulos, D);                      \
+  }                                                                                                   \
+  __attribute__((target("avx512f,avx512bw"))) static long long kernel_atribuir_blocado_avx512_##SUFIXO( \
+      const KernelAtribuicao* k, const int16_t* pontos, int inicio, int fim, int32_t* rotulos) {      \
+    return kernel_atribuir_blocado_avx512_dim(k, pontos, inicio, fim, rotulos, D);                    \
+  }                                                                                                   \
+  __attribute__((target("avx512f,avx512bw,avx512vnni"))) static long long kernel_atribuir_blocado_vnni_##SUFIXO( \
+      const KernelAtribuicao* k, const int16_t* pontos, int inicio, int fim, int32_t* rotulos) {      \
+    return kernel_atribuir_blocado_vnni_dim(k, pontos, inicio, fim, rotulos, D);                      \
+  }
+#else
+#define KERNEL_GERAR(SUFIXO, D) KERNEL_GERAR_ESCALAR(SUFIXO, D)
+#endif
+
+#define KERNEL_GERAR_FIXO(D) KERNEL_GERAR(d##D, D)
+KERNEL_GERAR(generico, k->num_dimensoes)
+KERNEL_D_FIXOS(KERNEL_GERAR_FIXO)
+
+#ifdef KMEANS_SIMD_X86
+#define KERNEL_ESCOLHER(SUFIXO)                                                                      \
+  do {                                                                                               \
+    k->mais_proximo = k->nivel == SIMD_AVX512 ? kernel_mais_proximo_avx512_##SUFIXO                  \
+                      : k->nivel == SIMD_AVX2 ? kernel_mais_proximo_avx2_##SUFIXO                    \
+                                              : kernel_mais_proximo_escalar_##SUFIXO;                \
+    k->mais_proximo_compacto = k->avx512bw                  ? kernel_mais_proximo_compacto_avx512_##SUFIXO \
+                               : k->nivel != SIMD_ESCALAR ? kernel_mais_proximo_compacto_avx2_##SUFIXO \
+                                                          : kernel_mais_proximo_compacto_escalar_##SUFIXO; \
+    k->atribuir_colunas = k->nivel == SIMD_AVX512 ? kernel_atribuir_colunas_avx512_##SUFIXO          \
+                          : k->nivel == SIMD_AVX2 ? kernel_atribuir_colunas_avx2_##SUFIXO            \
+                                                  : kernel_atribuir_colunas_escalar_##SUFIXO;        \
+    k->atribuir_blocado = k->avx512vnni                ? kernel_atribuir_blocado_vnni_##SUFIXO        \
+                          : k->avx512bw                ? kernel_atribuir_blocado_avx512_##SUFIXO      \
+                          : k->nivel != SIMD_ESCALAR ? kernel_atribuir_blocado_avx2_##SUFIXO        \
+                                                     : kernel_atribuir_blocado_escalar_##SUFIXO;    \
+  } while (0)
+#else
+#define KERNEL_ESCOLHER(SUFIXO)                                                                      \
+  do {                                                                                               \
+    k->mais_proximo = kernel_mais_proximo_escalar_##SUFIXO;                                          \
+    k->mais_proximo_compacto = kernel_mais_proximo_compacto_escalar_##SUFIXO;                        \
+    k->atribuir_colunas = kernel_atribuir_colunas_escalar_##SUFIXO;                                  \
+    k->atribuir_blocado = kernel_atribuir_blocado_escalar_##SUFIXO;                                  \
+  } while (0)
+#endif
+
+static inline void kernel_escolher_caminho(KernelAtribuicao* k) {
+#define KERNEL_CASO_FIXO(D) \
+  case D: KERNEL_ESCOLHER(d##D); k->d_fixo = 1; return;
+  switch (k->num_dimensoes) {
+    KERNEL_D_FIXOS(KERNEL_CASO_FIXO)
+    default: KERNEL_ESCOLHER(generico); k->d_fixo = 0; return;
+  }
+#undef KERNEL_CASO_FIXO
+}
+
+/**
+ * @brief Nome do caminho escolhido por kernel_escolher_caminho, para a saída.
+ */
+static inline const char* kernel_caminho(const KernelAtribuicao* k) {
+  if (k->coords_b != NULL) return k->d_fixo ? "fixo, blocado" : "genérico, blocado";
+  return k->d_fixo ? "fixo" : "genérico";
+}
+
+/**
+ * @brief Retorna o índice do centroide mais próximo de 'ponto' (menor índice em caso de empate).
+ * O kernel (conjunto de instruções e D fixo ou genérico) é escolhido em kernel_iniciar.
+ */
+static inline int kernel_mais_proximo(const KernelAtribuicao* k, const int* ponto) {
+  return k->mais_proximo(k, ponto);
+}
+
+/**
+ * @brief Versão de kernel_mais_proximo para um ponto compacto (int16, largura d_par).
+ * Requer kernel_habilitar_compacto.
+ */
+static inline int kernel_mais_proximo_compacto(const KernelAtribuicao* k, const int16_t* ponto) {
+  return k->mais_proximo_compacto(k, ponto);
+}
+
+/**
+ * @brief Atribui os pontos [inicio, fim) de uma matriz dimensão-major com 'num_pontos'
+ * colunas (colunas[d * num_pontos + i]) e grava o cluster de cada um em 'rotulos'.
+ * @return Número de pontos cujo rótulo mudou.
+ */
+static inline long long kernel_atribuir_colunas(const KernelAtribuicao* k, const int* colunas, int num_pontos,
+                                                int inicio, int fim, int32_t* rotulos) {
+  return k->atribuir_colunas(k, colunas, num_pontos, inicio, fim, rotulos);
+}
+
+/**
+ * @brief Atribui os pontos compactos [inicio, fim) (largura d_par) pelo modo blocado e
+ * grava o cluster de cada um em 'rotulos'. Requer kernel_habilitar_blocado.
+ * @return Número de pontos cujo rótulo mudou.
+ */
+static inline long long kernel_atribuir_blocado(const KernelAtribuicao* k, const int16_t* pontos, int inicio, int fim,
+                                                int32_t* rotulos) {
+  return k->atribuir_blocado(k, pontos, inicio, fim, rotulos);
+}
+
+/**
+ * @brief Calcula a distância de 'ponto' até todos os centroides, em ordem, em 'saida'
+ * (pelo menos num_clusters posições).
+ */
+static inline void kernel_distancias(const KernelAtribuicao* k, const int* ponto, long long* saida) {
+#ifdef KMEANS_SIMD_X86
+  switch (k->nivel) {
+    case SIMD_AVX512: kernel_distancias_avx512(k, ponto, saida); return;
+    case SIMD_AVX2: kernel_distancias_avx2(k, ponto, saida); return;
+    default: break;
+  }
+#endif
+  kernel_distancias_escalar(k, ponto, saida);
+}
+
+KERNEL_DIM void kernel_somar_dim(long long* soma, const int* ponto, const int D) {
+  for (int d = 0; d < D; d++) {
+    soma[d] += ponto[d];
+  }
+}
+
+KERNEL_DIM void kernel_somar_compacto_dim(long long* soma, const int16_t* ponto, const int D) {
+  for (int d = 0; d < D; d++) {
+    soma[d] += ponto[d];
+  }
+}
+
+/**
+ * @brief Acumula as D coordenadas de 'ponto' em 'soma' (fase de atualização), com o
+ * laço desenrolado quando D está em KERNEL_D_FIXOS.
+ */
+static inline void kernel_somar(long long* soma, const int* ponto, int D) {
+#define KERNEL_CASO_SOMA(DF) \
+  case DF: kernel_somar_dim(soma, ponto, DF); return;
+  switch (D) {
+    KERNEL_D_FIXOS(KERNEL_CASO_SOMA)
+    default: kernel_somar_dim(soma, ponto, D); return;
+  }
+#undef KERNEL_CASO_SOMA
+}
+
+/**
+ * @brief Versão de kernel_somar para um ponto compacto.
+ */
+static inline void kernel_somar_compacto(long long* soma, const int16_t* ponto, int D) {
+#define KERNEL_CASO_SOMA(DF) \
+  case DF: kernel_somar_compacto_dim(soma, ponto, DF); return;
+  switch (D) {
+    KERNEL_D_FIXOS(KERNEL_CASO_SOMA)
+    default: kernel_somar_compacto_dim(soma, ponto, D); return;
+  }
+#undef KERNEL_CASO_SOMA
+}
+
+/**
+ * @brief Distância exata de 'ponto' até um único centroide.
+ */
+static inline long long kernel_distancia(const KernelAtribuicao* k, const int* ponto, int cluster) {
+  const int D = k->num_dimensoes;
+  const int* c = &k->coords[(size_t)cluster * D];
+  long long dist = 0;
+  for (int d = 0; d < D; d++) {
+    long long diff = (long long)ponto[d] - c[d];
+    dist += diff * diff;
+  }
+  return dist;
+}
+
+#endif
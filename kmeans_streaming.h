@@ -0,0 +1,311 @@
+#ifndef KMEANS_STREAMING_H
+#define KMEANS_STREAMING_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "kmeans_dataset.h"
+#include "kmeans_simd.h"
+
+// Execução fora da memória (opção --streaming[=P], só para datasets binários).
+//
+// Os pontos não são carregados: a cada passada o dataset é lido do disco em blocos
+// de P pontos com pread, em dois buffers. Uma thread leitora dedicada preenche um
+// buffer enquanto o laço do K-Means atribui e acumula os pontos do outro, então a
+// leitura do bloco b+1 se sobrepõe ao processamento do bloco b. No modo compacto a
+// leitora também converte o bloco para int16, fora do caminho do laço. A leitora percorre
+// os blocos em ciclo (0, 1, ..., n-1, 0, ...), e cada passada consome exatamente n
+// blocos, de modo que a passada seguinte já encontra o bloco 0 a caminho.
+//
+// Os rótulos (4 bytes por ponto) ficam em um arquivo temporário mapeado com
+// MAP_SHARED: o kernel os grava de volta no disco quando precisa da memória, sem
+// que precisem ficar residentes. Como a atribuição e as somas inteiras são as mesmas
+// do Lloyd em memória, o resultado é idêntico.
+//
+// A representação compacta é escolhida pela faixa do cabeçalho sem ler os dados, então
+// a leitora confere a faixa de cada bloco lido, e um valor fora dela encerra o programa.
+
+#define STREAMING_FORA_DA_FAIXA (-1)  // Erro da leitora: bloco com valores fora da faixa do cabeçalho
+
+typedef struct {
+  int* coords;         // Coordenadas do bloco lidas do disco, ponto a ponto
+  int16_t* compactos;  // Cópia int16 com largura d_par (modo compacto), ou NULL
+  int inicio;          // Índice do primeiro ponto do bloco
+  int quantidade;      // Pontos do bloco
+  int cheio;           // 1 quando guarda o próximo bloco a consumir dele
+} BufferStreaming;
+
+typedef struct {
+  int fd;
+  const char* arquivo;
+  int num_pontos;
+  int num_dimensoes;
+  int pontos_por_bloco;
+  int num_blocos;
+  int min_val, max_val;  // Faixa de valores do cabeçalho
+  BufferStreaming buffers[2];
+  long long lidos;       // Blocos lidos desde o início, contando as voltas
+  long long consumidos;  // Blocos consumidos desde o início
+  int parar;
+  int erro;              // errno da leitura que falhou (0 = nenhuma, STREAMING_FORA_DA_FAIXA)
+  int inicio_invalido;   // Primeiro ponto do bloco com valores fora da faixa
+  pthread_t leitora;
+  pthread_mutex_t trava;
+  pthread_cond_t mudou;
+  int32_t* rotulos;      // Rótulos de todos os pontos, no arquivo temporário
+  size_t tamanho_rotulos;
+} LeitorStreaming;
+
+/**
+ * @brief Mapeia 'bytes' de um arquivo temporário (MAP_SHARED), criado ao lado de
+ * 'referencia' ou, se o diretório não aceitar escrita, em $TMPDIR ou /tmp. O arquivo
+ * é removido logo após a criação e some quando o mapeamento é desfeito.
+ */
+static inline void* streaming_mapa_temporario(const char* referencia, size_t bytes) {
+  const char* barra = strrchr(referencia, '/');
+  const char* tmpdir = getenv("TMPDIR");
+  for (int t = 0; t < 2; t++) {
+    char caminho[4096];
+    if (t == 0) {
+      snprintf(caminho, sizeof(caminho), "%.*s/.kmeans_streaming_XXXXXX", barra != NULL ? (int)(barra - referencia) : 1,
+               barra != NULL ? referencia : ".");
+    } else {
+      snprintf(caminho, sizeof(caminho), "%s/.kmeans_streaming_XXXXXX",
+               tmpdir != NULL && tmpdir[0] != '\0' ? tmpdir : "/tmp");
+    }
+    int fd = mkstemp(caminho);
+    if (fd < 0) continue;
+    unlink(caminho);
+    void* mapa = MAP_FAILED;
+    if (ftruncate(fd, (off_t)bytes) == 0) {
+      mapa = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (mapa != MAP_FAILED) return mapa;
+  }
+  fprintf(stderr, "Erro: não foi possível criar o arquivo temporário de %zu bytes do modo --streaming.\n", bytes);
+  exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief Lê 'bytes' a partir de 'offset' com pread, repetindo em leituras parciais.
+ * @return 0 em caso de sucesso ou o errno da falha (EIO se o arquivo acabou antes).
+ */
+static inline int streaming_pread(int fd, void* destino, size_t bytes, off_t offset) {
+  char* p = (char*)destino;
+  while (bytes > 0) {
+    ssize_t lido = pread(fd, p, bytes, offset);
+    if (lido < 0 && errno == EINTR) continue;
+    if (lido <= 0) return lido < 0 ? errno : EIO;
+    p += lido;
+    bytes -= (size_t)lido;
+    offset += lido;
+  }
+  return 0;
+}
+
+/**
+ * @brief Laço da thread leitora: lê o próximo bloco do ciclo assim que o buffer dele
+ * é devolvido pelo consumidor e confere a faixa dos seus valores.
+ */
+static inline void* streaming_ler_blocos(void* arg) {
+  LeitorStreaming* s = (LeitorStreaming*)arg;
+  const size_t tamanho_ponto = (size_t)s->num_dimensoes * sizeof(int);
+  pthread_mutex_lock(&s->trava);
+  while (!s->parar && s->erro == 0) {
+    BufferStreaming* buffer = &s->buffers[s->lidos % 2];
+    if (buffer->cheio) {
+      pthread_cond_wait(&s->mudou, &s->trava);
+      continue;
+    }
+    const int inicio = (int)(s->lidos % s->num_blocos) * s->pontos_por_bloco;
+    const int quantidade = s->num_pontos - inicio < s->pontos_por_bloco ? s->num_pontos - inicio : s->pontos_por_bloco;
+    pthread_mutex_unlock(&s->trava);
+    int erro = streaming_pread(s->fd, buffer->coords, (size_t)quantidade * tamanho_ponto,
+                               (off_t)DATASET_OFFSET_DADOS + (off_t)inicio * tamanho_ponto);
+    if (erro == 0 && buffer->compactos != NULL) {
+      if (!simd_converter_compacto(buffer->coords, quantidade, s->num_dimensoes, s->min_val, s->max_val,
+                                   buffer->compactos)) {
+        erro = STREAMING_FORA_DA_FAIXA;
+      }
+    } else if (erro == 0) {
+      int menor, maior;
+      simd_faixa(buffer->coords, (size_t)quantidade * s->num_dimensoes, &menor, &maior);
+      if (menor < s->min_val || maior > s->max_val) erro = STREAMING_FORA_DA_FAIXA;
+    }
+    pthread_mutex_lock(&s->trava);
+    if (erro == STREAMING_FORA_DA_FAIXA) s->inicio_invalido = inicio;
+    buffer->inicio = inicio;
+    buffer->quantidade = quantidade;
+    buffer->cheio = 1;
+    s->erro = erro;
+    s->lidos++;
+    pthread_cond_broadcast(&s->mudou);
+  }
+  pthread_mutex_unlock(&s->trava);
+  return NULL;
+}
+
+/**
+ * @brief Abre o dataset binário para leitura em blocos de 'pontos_por_bloco' pontos e
+ * aloca os buffers e os rótulos (iniciados em -1). A leitura só começa em
+ * streaming_iniciar. Datasets de texto não são aceitos.
+ */
+static inline void streaming_abrir(LeitorStreaming* s, const char* filename, int num_pontos, int num_dimensoes,
+                                   int pontos_por_bloco) {
+  CabecalhoDataset cab;
+  s->fd = open(filename, O_RDONLY);
+  if (s->fd < 0) {
+    fprintf(stderr, "Erro: Não foi possível abrir o arquivo '%s'\n", filename);
+    exit(EXIT_FAILURE);
+  }
+  if (!dataset_ler_cabecalho(s->fd, &cab)) {
+    fprintf(stderr, "Erro: --streaming requer um dataset binário; converta '%s' com conversor_dataset.\n", filename);
+    exit(EXIT_FAILURE);
+  }
+  dataset_binario_validar(s->fd, filename, num_pontos, num_dimensoes, &cab);
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(s->fd, DATASET_OFFSET_DADOS, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+  s->arquivo = filename;
+  s->num_pontos = num_pontos;
+  s->num_dimensoes = num_dimensoes;
+  s->pontos_por_bloco = pontos_por_bloco < num_pontos ? pontos_por_bloco : num_pontos;
+  s->num_blocos = (num_pontos + s->pontos_por_bloco - 1) / s->pontos_por_bloco;
+  s->min_val = cab.min_val;
+  s->max_val = cab.max_val;
+  for (int b = 0; b < 2; b++) {
+    s->buffers[b].coords = (int*)pontos_alocar((size_t)s->pontos_por_bloco * num_dimensoes * sizeof(int));
+    s->buffers[b].compactos = NULL;
+    s->buffers[b].cheio = 0;
+  }
+  s->lidos = 0;
+  s->consumidos = 0;
+  s->parar = 0;
+  s->erro = 0;
+  s->inicio_invalido = -1;
+  s->tamanho_rotulos = (size_t)num_pontos * sizeof(int32_t);
+  s->rotulos = (int32_t*)streaming_mapa_temporario(filename, s->tamanho_rotulos);
+  memset(s->rotulos, 0xff, s->tamanho_rotulos);
+}
+
+/**
+ * @brief Inicia a thread leitora. Com 'compacto', cada bloco também é convertido para
+ * int16 (simd_converter_compacto) antes de ser entregue.
+ */
+static inline void streaming_iniciar(LeitorStreaming* s, int compacto) {
+  if (compacto) {
+    const int largura = s->num_dimensoes + (s->num_dimensoes & 1);
+    for (int b = 0; b < 2; b++) {
+      s->buffers[b].compactos = (int16_t*)pontos_alocar((size_t)s->pontos_por_bloco * largura * sizeof(int16_t));
+    }
+  }
+  pthread_mutex_init(&s->trava, NULL);
+  pthread_cond_init(&s->mudou, NULL);
+  if (pthread_create(&s->leitora, NULL, streaming_ler_blocos, s) != 0) {
+    fprintf(stderr, "Erro: não foi possível criar a thread leitora do modo --streaming.\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+/**
+ * @brief Espera o próximo bloco da passada. O buffer continua válido até
+ * streaming_devolver.
+ */
+static inline const BufferStreaming* streaming_proximo(LeitorStreaming* s) {
+  BufferStreaming* buffer = &s->buffers[s->consumidos % 2];
+  pthread_mutex_lock(&s->trava);
+  while (!buffer->cheio && s->erro == 0) {
+    pthread_cond_wait(&s->mudou, &s->trava);
+  }
+  const int erro = s->erro;
+  pthread_mutex_unlock(&s->trava);
+  if (erro == STREAMING_FORA_DA_FAIXA) {
+    fprintf(stderr, "Erro: '%s' tem valores fora da faixa [%d, %d] do cabeçalho no bloco a partir do ponto %d.\n",
+            s->arquivo, s->min_val, s->max_val, s->inicio_invalido);
+    exit(EXIT_FAILURE);
+  }
+  if (erro != 0) {
+    fprintf(stderr, "Erro ao ler '%s' no modo --streaming: %s\n", s->arquivo, strerror(erro));
+    exit(EXIT_FAILURE);
+  }
+  return buffer;
+}
+
+/**
+ * @brief Devolve o buffer do bloco atual à thread leitora, que passa a ler nele o
+ * bloco seguinte ao que já está sendo lido.
+ */
+static inline void streaming_devolver(LeitorStreaming* s) {
+  pthread_mutex_lock(&s->trava);
+  s->buffers[s->consumidos % 2].cheio = 0;
+  s->consumidos++;
+  pthread_cond_broadcast(&s->mudou);
+  pthread_mutex_unlock(&s->trava);
+}
+
+/**
+ * @brief Escolhe os centroides iniciais com o mesmo sorteio de initialize_centroids
+ * (srand(42) e embaralhamento dos M índices), lendo do disco só os K pontos sorteados.
+ * O vetor de índices também fica em um arquivo temporário.
+ */
+static inline void streaming_inicializar_centroides(const LeitorStreaming* s, int* centroids, int num_clusters) {
+  const int num_pontos = s->num_pontos, D = s->num_dimensoes;
+  srand(42);
+
+  int* indices = (int*)streaming_mapa_temporario(s->arquivo, (size_t)num_pontos * sizeof(int));
+  for (int i = 0; i < num_pontos; i++) {
+    indices[i] = i;
+  }
+
+  for (int i = 0; i < num_pontos; i++) {
+    int j = rand() % num_pontos;
+    int temp = indices[i];
+    indices[i] = indices[j];
+    indices[j] = temp;
+  }
+
+  for (int i = 0; i < num_clusters; i++) {
+    int erro = streaming_pread(s->fd, &centroids[(size_t)i * D], (size_t)D * sizeof(int),
+                               (off_t)DATASET_OFFSET_DADOS + (off_t)indices[i] * D * sizeof(int));
+    if (erro != 0) {
+      fprintf(stderr, "Erro ao ler '%s' no modo --streaming: %s\n", s->arquivo, strerror(erro));
+      exit(EXIT_FAILURE);
+    }
+    int menor, maior;
+    simd_faixa(&centroids[(size_t)i * D], D, &menor, &maior);
+    if (menor < s->min_val || maior > s->max_val) {
+      fprintf(stderr, "Erro: o ponto %d de '%s' tem valores fora da faixa [%d, %d] do cabeçalho.\n", indices[i],
+              s->arquivo, s->min_val, s->max_val);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  munmap(indices, (size_t)num_pontos * sizeof(int));
+}
+
+static inline void streaming_fechar(LeitorStreaming* s) {
+  pthread_mutex_lock(&s->trava);
+  s->parar = 1;
+  pthread_cond_broadcast(&s->mudou);
+  pthread_mutex_unlock(&s->trava);
+  pthread_join(s->leitora, NULL);
+  pthread_mutex_destroy(&s->trava);
+  pthread_cond_destroy(&s->mudou);
+  munmap(s->rotulos, s->tamanho_rotulos);
+  for (int b = 0; b < 2; b++) {
+    free(s->buffers[b].coords);
+    free(s->buffers[b].compactos);
+  }
+  close(s->fd);
+}
+
+#endif